@@ -0,0 +1,154 @@
+// Copyright (C) 2024 Neo Jin. All Rights Reserved.
+#include "TinyEncryptFramer.h"
+#include "TinyEncryptAlgorithm.h"
+#include "Misc/Paths.h"
+#include "AutomationTest/TinyEncryptAutomationTestInterface.h"
+#include "Misc/AutomationTest.h"
+#include "Runtime/Launch/Resources/Version.h"
+
+#if !UE_BUILD_SHIPPING
+
+bool TestTinyEncryptFramer(FString& Detail)
+{
+	FUInt128Ex RandomKey;
+	RandomKey.MakeRandom();
+	FTinyEncrypt TEA(RandomKey);
+
+	uint8 MessageData[256];
+	for (int32 i = 0; i < 256; i++)
+	{
+		MessageData[i] = (uint8)i;
+	}
+
+	//Many small messages in one frame
+	{
+		FTinyEncryptFramer Framer(TEA);
+		TEST_TRUE_WITH_AUTONAME(!Framer.Flush());
+
+		const int32 MessageCounts = 10;
+		for (int32 i = 0; i < MessageCounts; i++)
+		{
+			TEST_TRUE_WITH_AUTONAME(Framer.AddMessage(MessageData + i, 20 + i));
+		}
+		TEST_TRUE_WITH_AUTONAME(Framer.GetPendingMessages() == MessageCounts);
+		TEST_TRUE_WITH_AUTONAME(Framer.GetNumFrames() == 0);
+		TEST_TRUE_WITH_AUTONAME(Framer.Flush());
+		TEST_TRUE_WITH_AUTONAME(Framer.GetNumFrames() == 1);
+
+		//One padding and one byte length per message
+		const int32 PlainLen = MessageCounts * 20 + (MessageCounts - 1) * MessageCounts / 2 + MessageCounts;
+		TArray<uint8> Frame(Framer.GetFrame(0).GetData(), Framer.GetFrame(0).Num());
+		TEST_TRUE_WITH_AUTONAME(Frame.Num() == FTinyEncrypt::GetEncryptLength(PlainLen));
+
+		TArray<TArrayView<const uint8>> Messages;
+		TEST_TRUE_WITH_AUTONAME(FTinyEncryptFramer::SplitFrame(TEA, Frame.GetData(), Frame.Num(), Messages));
+		TEST_TRUE_WITH_AUTONAME(Messages.Num() == MessageCounts);
+		for (int32 i = 0; i < MessageCounts; i++)
+		{
+			TEST_TRUE_WITH_AUTONAME(Messages[i].Num() == 20 + i);
+			TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(Messages[i].GetData(), MessageData + i, 20 + i) == 0);
+			//Zero copy
+			TEST_TRUE_WITH_AUTONAME(Messages[i].GetData() >= Frame.GetData() && Messages[i].GetData() < Frame.GetData() + Frame.Num());
+		}
+
+		Framer.ClearFrames();
+		TEST_TRUE_WITH_AUTONAME(Framer.GetNumFrames() == 0);
+		TEST_TRUE_WITH_AUTONAME(Framer.GetPendingSize() == 0);
+	}
+
+	//Frame size limit and flush policy
+	{
+		FTinyEncryptFrameSettings Settings;
+		Settings.MaxFrameSize = 64;
+		Settings.MaxMessagesPerFrame = 3;
+		FTinyEncryptFramer Framer(TEA, Settings);
+
+		//Max plain frame is 63 bytes, 1 byte length
+		TEST_TRUE_WITH_AUTONAME(Framer.GetMaxMessageSize() == 62);
+		TEST_TRUE_WITH_AUTONAME(!Framer.AddMessage(MessageData, 63));
+		TEST_TRUE_WITH_AUTONAME(Framer.AddMessage(MessageData, 62));
+		TEST_TRUE_WITH_AUTONAME(Framer.GetNumFrames() == 0);
+
+		//Doesn't fit, flush the pending frame first
+		TEST_TRUE_WITH_AUTONAME(Framer.AddMessage(MessageData, 0));
+		TEST_TRUE_WITH_AUTONAME(Framer.GetNumFrames() == 1);
+		TEST_TRUE_WITH_AUTONAME(Framer.GetFrame(0).Num() == 64);
+
+		//Flush by message counts
+		TEST_TRUE_WITH_AUTONAME(Framer.AddMessage(MessageData + 1, 5));
+		TEST_TRUE_WITH_AUTONAME(Framer.AddMessage(MessageData + 2, 5));
+		TEST_TRUE_WITH_AUTONAME(Framer.GetNumFrames() == 2);
+		TEST_TRUE_WITH_AUTONAME(Framer.GetPendingMessages() == 0);
+
+		TEST_TRUE_WITH_AUTONAME(Framer.AddMessage(MessageData + 3, 7));
+		TArray<uint8> Frame(Framer.GetFrame(1).GetData(), Framer.GetFrame(1).Num());
+		Framer.ClearFrames();
+		TEST_TRUE_WITH_AUTONAME(Framer.GetNumFrames() == 0);
+		TEST_TRUE_WITH_AUTONAME(Framer.GetPendingMessages() == 1);
+
+		TArray<TArrayView<const uint8>> Messages;
+		TEST_TRUE_WITH_AUTONAME(FTinyEncryptFramer::SplitFrame(TEA, Frame.GetData(), Frame.Num(), Messages));
+		TEST_TRUE_WITH_AUTONAME(Messages.Num() == 3);
+		TEST_TRUE_WITH_AUTONAME(Messages[0].Num() == 0);
+		TEST_TRUE_WITH_AUTONAME(Messages[1].Num() == 5 && Messages[1][0] == 1);
+		TEST_TRUE_WITH_AUTONAME(Messages[2].Num() == 5 && Messages[2][0] == 2);
+
+		//The pending message is kept after clear
+		TEST_TRUE_WITH_AUTONAME(Framer.Flush());
+		Frame = TArray<uint8>(Framer.GetFrame(0).GetData(), Framer.GetFrame(0).Num());
+		TEST_TRUE_WITH_AUTONAME(FTinyEncryptFramer::SplitFrame(TEA, Frame.GetData(), Frame.Num(), Messages));
+		TEST_TRUE_WITH_AUTONAME(Messages.Num() == 1 && Messages[0].Num() == 7 && Messages[0][0] == 3);
+	}
+
+	//Multi bytes length
+	{
+		FTinyEncryptFrameSettings Settings;
+		Settings.MaxFrameSize = 512;
+		FTinyEncryptFramer Framer(TEA, Settings);
+		TEST_TRUE_WITH_AUTONAME(Framer.AddMessage(MessageData, 200));
+		TEST_TRUE_WITH_AUTONAME(Framer.AddMessage(MessageData, 256));
+		TEST_TRUE_WITH_AUTONAME(Framer.Flush());
+
+		TArray<uint8> Frame(Framer.GetFrame(0).GetData(), Framer.GetFrame(0).Num());
+		TEST_TRUE_WITH_AUTONAME(Frame.Num() == FTinyEncrypt::GetEncryptLength(2 + 200 + 2 + 256));
+
+		TArray<TArrayView<const uint8>> Messages;
+		TEST_TRUE_WITH_AUTONAME(FTinyEncryptFramer::SplitFrame(TEA, Frame.GetData(), Frame.Num(), Messages));
+		TEST_TRUE_WITH_AUTONAME(Messages.Num() == 2);
+		TEST_TRUE_WITH_AUTONAME(Messages[0].Num() == 200 && FMemory::Memcmp(Messages[0].GetData(), MessageData, 200) == 0);
+		TEST_TRUE_WITH_AUTONAME(Messages[1].Num() == 256 && FMemory::Memcmp(Messages[1].GetData(), MessageData, 256) == 0);
+	}
+
+	//Invalid frames
+	{
+		TArray<TArrayView<const uint8>> Messages;
+		uint8 Frame[16] = { 0 };
+		TEST_TRUE_WITH_AUTONAME(!FTinyEncryptFramer::SplitFrame(TEA, Frame, 7, Messages));
+
+		//Message length out of the frame
+		uint8 Plain[7] = { 10, 1, 2, 3, 4, 5, 6 };
+		TEST_TRUE_WITH_AUTONAME(TEA.Encrypt(Plain, 7, Frame) == 8);
+		TEST_TRUE_WITH_AUTONAME(!FTinyEncryptFramer::SplitFrame(TEA, Frame, 8, Messages));
+		TEST_TRUE_WITH_AUTONAME(Messages.Num() == 0);
+	}
+	return true;
+}
+
+#endif //!UE_BUILD_SHIPPING
+
+#if WITH_DEV_AUTOMATION_TESTS && !UE_BUILD_SHIPPING
+
+#if (ENGINE_MAJOR_VERSION >= 5 && ENGINE_MINOR_VERSION >= 5)
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST(FTinyEncryptTestFramer, FAutomationTestBase, "TinyEncrypt.Framer", EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+#else
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST(FTinyEncryptTestFramer, FAutomationTestBase, "TinyEncrypt.Framer", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+#endif
+bool FTinyEncryptTestFramer::RunTest(const FString& Parameters)
+{
+	FString Detail;
+	bool bSuccess = TestTinyEncryptFramer(Detail);
+	TestTrue(Detail, bSuccess);
+	return true;
+}
+
+#endif
@@ -1,6 +1,9 @@
 // Copyright (C) 2024 Neo Jin. All Rights Reserved.
 #include "TinyEncryptKeyExchange.h"
+#include "TinyEncryptSessionTicket.h"
 #include "Misc/Paths.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/MemoryReader.h"
 #include "AutomationTest/TinyEncryptAutomationTestInterface.h"
 #include "Misc/AutomationTest.h"
 #include "Runtime/Launch/Resources/Version.h"
@@ -196,6 +199,23 @@ bool TestTinyEncryptUInt128(FString & Detail)
 		TEST_TRUE_WITH_AUTONAME(ValueC == FUInt128Ex(0x838b0ab9fdcfdecfULL, 0x5fb0295c033f790bULL));
 	}
 
+	//Constant time versions give the same results
+	{
+		TEST_TRUE_WITH_AUTONAME(FUInt128Ex::MulModPConstantTime(FUInt128Ex(0xFFFFFFFFFFFFFFFFULL, 0x456ULL), FUInt128Ex(0xFFFFFFFFFFFFFFFFULL, 0x123ULL)) == FUInt128Ex(0xfffffffffffff949, 0x000000000008b6aa));
+		TEST_TRUE_WITH_AUTONAME(FUInt128Ex::PowerModPConstantTime(FUInt128Ex(0x123ULL), FUInt128Ex(0x456ULL)) == FUInt128Ex(0x651085792dd1313eULL, 0x5b550778601818aeULL));
+		TEST_TRUE_WITH_AUTONAME(FUInt128Ex::PowerModPConstantTime(FUInt128Ex(0xFFFFFFFFFFFFFFFFULL, 0xFFFFFFFFFFFFFFFEULL), FUInt128Ex(0x456ULL)) == FUInt128Ex(0x838b0ab9fdcfdecfULL, 0x5fb0295c033f790bULL));
+		TEST_TRUE_WITH_AUTONAME(FUInt128Ex::PowerModPConstantTime(FUInt128Ex(0x123ULL), FUInt128Ex::Zero) == FUInt128Ex(1ULL));
+
+		for (int i = 0; i < 10; i++)
+		{
+			FUInt128Ex ValueA, ValueB;
+			ValueA.MakeRandom();
+			ValueB.MakeRandom();
+			TEST_TRUE_WITH_AUTONAME(FUInt128Ex::MulModPConstantTime(ValueA, ValueB) == FUInt128Ex::MulModP(ValueA, ValueB));
+			TEST_TRUE_WITH_AUTONAME(FUInt128Ex::PowerModPConstantTime(ValueA, ValueB) == FUInt128Ex::PowerModP(ValueA, ValueB));
+		}
+	}
+
 	// Convert to Array
 	{
 		FUInt128Ex Value = FUInt128Ex(0ULL);
@@ -226,6 +246,37 @@ bool TestTinyEncryptUInt128(FString & Detail)
 		TEST_TRUE_WITH_AUTONAME(Value == FUInt128Ex(0x500c1bdba67f0068ULL, 0x4715fa5cdaf82724ULL));
 	}
 
+	//Fixed size bytes
+	{
+		const FUInt128Ex Value(0x500c1bdba67f0068ULL, 0x4715fa5cdaf82724ULL);
+		uint8 Bytes[FUInt128Ex::ByteSize];
+		Value.WriteBytes(Bytes);
+
+		TArray<uint8> Array = Value.ToArray();
+		TEST_TRUE_WITH_AUTONAME(Array.Num() == FUInt128Ex::ByteSize);
+		TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(Array.GetData(), Bytes, FUInt128Ex::ByteSize) == 0);
+		TEST_TRUE_WITH_AUTONAME(Bytes[0] == 0x50 && Bytes[15] == 0x24);
+
+		FUInt128Ex ReadValue;
+		ReadValue.ReadBytes(Bytes);
+		TEST_TRUE_WITH_AUTONAME(ReadValue == Value);
+	}
+
+	//Net serialize
+	{
+		FUInt128Ex Value(0xad7521da95e27fc1ULL, 0xe96c4bcda7e650b6ULL);
+		TArray<uint8> Buffer;
+		FMemoryWriter Writer(Buffer);
+		bool bSuccess = false;
+		TEST_TRUE_WITH_AUTONAME(Value.NetSerialize(Writer, nullptr, bSuccess) && bSuccess);
+		TEST_TRUE_WITH_AUTONAME(Buffer.Num() == FUInt128Ex::ByteSize);
+
+		FUInt128Ex ReadValue;
+		FMemoryReader Reader(Buffer);
+		TEST_TRUE_WITH_AUTONAME(ReadValue.NetSerialize(Reader, nullptr, bSuccess) && bSuccess);
+		TEST_TRUE_WITH_AUTONAME(ReadValue == Value);
+	}
+
 	//Convert to String
 	{
 		FUInt128Ex Value;
@@ -272,6 +323,45 @@ bool TestTinyEncryptUInt128(FString & Detail)
 
 		Value.MakeFromBase64(TEXT("Hello"));
 		TEST_TRUE_WITH_AUTONAME(Value.IsZero());
+
+		//Short and long data, same as `MakeFromArray`
+		Value.MakeFromBase64(TEXT("EjQ="));
+		TEST_TRUE_WITH_AUTONAME(Value == FUInt128Ex(0ULL, 0x1234ULL));
+
+		Value.MakeFromBase64(TEXT("UAwb26Z/AGhHFfpc2vgnJK11Idqh4n/B"));
+		TEST_TRUE_WITH_AUTONAME(Value == FUInt128Ex(0x500c1bdba67f0068ULL, 0x4715fa5cdaf82724ULL));
+
+		Value.MakeFromBase64(TEXT("UAwb26Z/AGhH=Fpc2vgnJA=="));
+		TEST_TRUE_WITH_AUTONAME(Value.IsZero());
+	}
+
+	//Fixed length chars and batch conversion
+	{
+		const FUInt128Ex Values[3] = { FUInt128Ex(0x500c1bdba67f0068ULL, 0x4715fa5cdaf82724ULL), FUInt128Ex::Zero, FUInt128Ex(0xad7521da95e27fc1ULL, 0xe96c4bcda7e650b6ULL) };
+
+		TCHAR HexChars[3 * FUInt128Ex::HexLength];
+		FUInt128Ex::ToHexChars(Values, HexChars);
+		TCHAR Base64Chars[3 * FUInt128Ex::Base64Length];
+		FUInt128Ex::ToBase64Chars(Values, Base64Chars);
+
+		for (int32 i = 0; i < 3; i++)
+		{
+			TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(HexChars + i * FUInt128Ex::HexLength, *Values[i].ToHexString(), FUInt128Ex::HexLength * sizeof(TCHAR)) == 0);
+			TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(Base64Chars + i * FUInt128Ex::Base64Length, *Values[i].ToBase64(), FUInt128Ex::Base64Length * sizeof(TCHAR)) == 0);
+		}
+
+		FUInt128Ex Parsed[3];
+		TEST_TRUE_WITH_AUTONAME(FUInt128Ex::MakeFromHexChars(HexChars, Parsed) == 3);
+		TEST_TRUE_WITH_AUTONAME(Parsed[0] == Values[0] && Parsed[1] == Values[1] && Parsed[2] == Values[2]);
+
+		Base64Chars[FUInt128Ex::Base64Length + 3] = TEXT('!');
+		TEST_TRUE_WITH_AUTONAME(FUInt128Ex::MakeFromBase64Chars(Base64Chars, Parsed) == 2);
+		TEST_TRUE_WITH_AUTONAME(Parsed[0] == Values[0] && Parsed[1].IsZero() && Parsed[2] == Values[2]);
+
+		FUInt128Ex Value;
+		TEST_TRUE_WITH_AUTONAME(!Value.MakeFromHexChars(TEXT("12x4"), 4));
+		TEST_TRUE_WITH_AUTONAME(Value.MakeFromHexChars(TEXT("12x4"), 2));
+		TEST_TRUE_WITH_AUTONAME(Value == FUInt128Ex(0ULL, 0x12ULL));
 	}
 	return true;
 }
@@ -292,6 +382,72 @@ bool TestTinyEncryptExchange(FString& Detail)
 			TEST_TRUE_WITH_AUTONAME(SecretKeyA == SecretKeyB);
 		}
 	}
+
+	//Constant time exchange matches the fast one
+	{
+		FDiffieHellmanKeyPair Alice, Bob;
+		Alice.GenerateRandomKeyPair(EDiffieHellmanPowerMode::ConstantTime);
+		Bob.GenerateRandomKeyPair();
+
+		TEST_TRUE_WITH_AUTONAME(Alice.PublicKey == FUInt128Ex::PowerModP(FUInt128Ex::G, Alice.PrivateKey));
+		TEST_TRUE_WITH_AUTONAME(Alice.GenerateSecretKey(Bob.PublicKey, EDiffieHellmanPowerMode::ConstantTime) == Bob.GenerateSecretKey(Alice.PublicKey));
+	}
+
+	//Session resumption ticket
+	{
+		FUInt128Ex TicketKey;
+		TicketKey.MakeRandom();
+		FTinyEncryptTicketIssuer Issuer(TicketKey);
+
+		FDiffieHellmanKeyPair Alice, Bob;
+		Alice.GenerateRandomKeyPair();
+		Bob.GenerateRandomKeyPair();
+		FUInt128Ex SecretKey = Alice.GenerateSecretKey(Bob.PublicKey);
+
+		const int64 Now = FTinyEncryptTicketIssuer::GetNow();
+		FTinyEncryptTicket Ticket;
+		Issuer.IssueTicket(SecretKey, Now + 60, Ticket);
+
+		FUInt128Ex ResumedKey;
+		TEST_TRUE_WITH_AUTONAME(Issuer.ValidateTicket(Ticket, Now, ResumedKey));
+		TEST_TRUE_WITH_AUTONAME(ResumedKey == SecretKey);
+
+		//Expired
+		TEST_TRUE_WITH_AUTONAME(!Issuer.ValidateTicket(Ticket, Now + 61, ResumedKey));
+		TEST_TRUE_WITH_AUTONAME(ResumedKey.IsZero());
+
+		//Tampered
+		Ticket.Data[3] ^= 0x80;
+		TEST_TRUE_WITH_AUTONAME(!Issuer.ValidateTicket(Ticket, Now, ResumedKey));
+		Ticket.Data[3] ^= 0x80;
+
+		//Issued by another server key
+		FUInt128Ex AnotherKey;
+		AnotherKey.MakeRandom();
+		TEST_TRUE_WITH_AUTONAME(!FTinyEncryptTicketIssuer(AnotherKey).ValidateTicket(Ticket, Now, ResumedKey));
+
+		//Batch
+		TArray<FUInt128Ex> SecretKeys;
+		for (int32 i = 0; i < 8; i++)
+		{
+			FUInt128Ex Key;
+			Key.MakeRandom();
+			SecretKeys.Add(Key);
+		}
+		TArray<FTinyEncryptTicket> Tickets;
+		Tickets.SetNumZeroed(SecretKeys.Num());
+		Issuer.IssueTickets(SecretKeys, Now + 60, Tickets);
+
+		Tickets[5].Data[FTinyEncryptTicket::Size - 1] ^= 0x01;
+
+		TArray<FUInt128Ex> ResumedKeys;
+		ResumedKeys.SetNumZeroed(Tickets.Num());
+		TEST_TRUE_WITH_AUTONAME(Issuer.ValidateTickets(Tickets, Now, ResumedKeys) == SecretKeys.Num() - 1);
+		for (int32 i = 0; i < SecretKeys.Num(); i++)
+		{
+			TEST_TRUE_WITH_AUTONAME(ResumedKeys[i] == (i == 5 ? FUInt128Ex::Zero : SecretKeys[i]));
+		}
+	}
 	return true;
 }
 
@@ -0,0 +1,156 @@
+// Copyright (C) 2024 Neo Jin. All Rights Reserved.
+#include "TinyEncryptSessionTable.h"
+#include "TinyEncryptAlgorithm.h"
+#include "Misc/Paths.h"
+#include "AutomationTest/TinyEncryptAutomationTestInterface.h"
+#include "Misc/AutomationTest.h"
+#include "Runtime/Launch/Resources/Version.h"
+
+#if !UE_BUILD_SHIPPING
+
+bool TestTinyEncryptSessionTable(FString& Detail)
+{
+	//Add and remove
+	{
+		FTinyEncryptSessionTable Table(4);
+		TEST_TRUE_WITH_AUTONAME(Table.Num() == 0);
+		TEST_TRUE_WITH_AUTONAME(!Table.Find(1).IsValid());
+
+		FTinyEncryptSessionHandle Handle1 = Table.Add(1, FUInt128Ex(1ULL));
+		FTinyEncryptSessionHandle Handle2 = Table.Add(2, FUInt128Ex(2ULL));
+		TEST_TRUE_WITH_AUTONAME(Table.Num() == 2);
+		TEST_TRUE_WITH_AUTONAME(Table.IsValid(Handle1) && Table.IsValid(Handle2));
+		TEST_TRUE_WITH_AUTONAME(Table.Find(1) == Handle1);
+		TEST_TRUE_WITH_AUTONAME(Table.Find(2) == Handle2);
+
+		TEST_TRUE_WITH_AUTONAME(Table.Remove(Handle1));
+		TEST_TRUE_WITH_AUTONAME(!Table.Remove(Handle1));
+		TEST_TRUE_WITH_AUTONAME(!Table.IsValid(Handle1));
+		TEST_TRUE_WITH_AUTONAME(!Table.Find(1).IsValid());
+		TEST_TRUE_WITH_AUTONAME(Table.Num() == 1);
+
+		//Reuse the removed slot, the old handle is still invalid
+		FTinyEncryptSessionHandle Handle3 = Table.Add(3, FUInt128Ex(3ULL));
+		TEST_TRUE_WITH_AUTONAME(Handle3.Index == Handle1.Index);
+		TEST_TRUE_WITH_AUTONAME(!Table.IsValid(Handle1));
+		TEST_TRUE_WITH_AUTONAME(Table.IsValid(Handle3));
+
+		uint8 OutBuff[16];
+		TEST_TRUE_WITH_AUTONAME(Table.Encrypt(Handle1, (const uint8*)"Hello", 5, OutBuff) == -1);
+	}
+
+	//Same output as FTinyEncrypt
+	{
+		const int32 SessionCounts = 16;
+		const int32 MaxLength = 64;
+
+		FTinyEncryptSessionTable Table;
+		TArray<FUInt128Ex> Keys;
+		TArray<FTinyEncryptSessionHandle> Handles;
+		for (int32 i = 0; i < SessionCounts; i++)
+		{
+			FUInt128Ex Key;
+			Key.MakeRandom();
+			Keys.Add(Key);
+			Handles.Add(Table.Add(1000 + i, Key));
+		}
+
+		uint8 PlainText[MaxLength];
+		for (int32 i = 0; i < MaxLength; i++)
+		{
+			PlainText[i] = (uint8)FMath::RandRange(0, 0xFF);
+		}
+
+		TArray<uint8> EncryptBuff, DecryptBuff, ExpectBuff;
+		EncryptBuff.SetNumZeroed(SessionCounts * (MaxLength + 8));
+		DecryptBuff.SetNumZeroed(SessionCounts * (MaxLength + 8));
+		ExpectBuff.SetNumZeroed(MaxLength + 8);
+
+		TArray<FTinyEncryptSessionPacket> Packets;
+		for (int32 i = 0; i < SessionCounts; i++)
+		{
+			FTinyEncryptSessionPacket Packet;
+			Packet.Session = Handles[i];
+			Packet.InBuf = PlainText;
+			Packet.InLen = (i * 5) % MaxLength;
+			Packet.OutBuf = EncryptBuff.GetData() + i * (MaxLength + 8);
+			Packets.Add(Packet);
+		}
+		Table.EncryptBatch(Packets);
+
+		for (int32 i = 0; i < SessionCounts; i++)
+		{
+			FTinyEncrypt TEA(Keys[i]);
+			const int32 ExpectLength = TEA.Encrypt(Packets[i].InBuf, Packets[i].InLen, ExpectBuff.GetData());
+			TEST_TRUE_WITH_AUTONAME(Packets[i].OutLen == ExpectLength);
+			TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(Packets[i].OutBuf, ExpectBuff.GetData(), ExpectLength) == 0);
+
+			//Prepare decrypt
+			Packets[i].InBuf = Packets[i].OutBuf;
+			Packets[i].InLen = Packets[i].OutLen;
+			Packets[i].OutBuf = DecryptBuff.GetData() + i * (MaxLength + 8);
+		}
+		Table.DecryptBatch(Packets);
+
+		for (int32 i = 0; i < SessionCounts; i++)
+		{
+			TEST_TRUE_WITH_AUTONAME(Packets[i].OutLen == (i * 5) % MaxLength);
+			TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(Packets[i].OutBuf, PlainText, Packets[i].OutLen) == 0);
+		}
+	}
+
+	//Fan-out to many sessions
+	{
+		const int32 SessionCounts = 6;
+		FTinyEncryptSessionTable Table;
+		TArray<FUInt128Ex> Keys;
+		TArray<FTinyEncryptSessionHandle> Handles;
+		for (int32 i = 0; i < SessionCounts; i++)
+		{
+			FUInt128Ex Key;
+			Key.MakeRandom();
+			Keys.Add(Key);
+			Handles.Add(Table.Add(i, Key));
+		}
+		Table.Remove(Handles[2]);
+
+		uint8* PlainText = (uint8*)"Hello,World!";
+		uint8 FanOutBuff[SessionCounts][16] = { { 0 } };
+		uint8* OutBufs[SessionCounts];
+		for (int32 i = 0; i < SessionCounts; i++)
+		{
+			OutBufs[i] = FanOutBuff[i];
+		}
+
+		TEST_TRUE_WITH_AUTONAME(Table.EncryptFanOut(PlainText, 12, Handles, TArrayView<uint8* const>(OutBufs, SessionCounts)) == 16);
+		for (int32 i = 0; i < SessionCounts; i++)
+		{
+			uint8 ExpectBuff[16] = { 0 };
+			if (i != 2)
+			{
+				FTinyEncrypt(Keys[i]).Encrypt(PlainText, 12, ExpectBuff);
+			}
+			TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(FanOutBuff[i], ExpectBuff, 16) == 0);
+		}
+	}
+	return true;
+}
+
+#endif //!UE_BUILD_SHIPPING
+
+#if WITH_DEV_AUTOMATION_TESTS && !UE_BUILD_SHIPPING
+
+#if (ENGINE_MAJOR_VERSION >= 5 && ENGINE_MINOR_VERSION >= 5)
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST(FTinyEncryptTestSessionTable, FAutomationTestBase, "TinyEncrypt.SessionTable", EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+#else
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST(FTinyEncryptTestSessionTable, FAutomationTestBase, "TinyEncrypt.SessionTable", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+#endif
+bool FTinyEncryptTestSessionTable::RunTest(const FString& Parameters)
+{
+	FString Detail;
+	bool bSuccess = TestTinyEncryptSessionTable(Detail);
+	TestTrue(Detail, bSuccess);
+	return true;
+}
+
+#endif
@@ -0,0 +1,209 @@
+// Copyright (C) 2024 Neo Jin. All Rights Reserved.
+#include "TinyEncryptSocketStream.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+#include "IPAddress.h"
+#include "Misc/Paths.h"
+#include "AutomationTest/TinyEncryptAutomationTestInterface.h"
+#include "Misc/AutomationTest.h"
+#include "Runtime/Launch/Resources/Version.h"
+
+#if !UE_BUILD_SHIPPING
+
+static bool TestSocketStreamWithCipher(FString& Detail, FSocket* Client, FSocket* Server, ETinyEncryptCipher CipherType)
+{
+	FUInt128Ex RandomKey;
+	RandomKey.MakeRandom();
+
+	//Small buffers, so the frames are split across Recv calls and the send buffer fills up
+	FTinyEncryptSocketStreamSettings Settings;
+	Settings.MaxMessageSize = 1000;
+	Settings.SendBufferSize = 4096;
+	Settings.ReceiveBufferSize = 2048;
+	FTinyEncryptSocketStream ClientStream(Client, ITinyEncryptCipher::Create(CipherType, RandomKey), Settings);
+	FTinyEncryptSocketStream ServerStream(Server, ITinyEncryptCipher::Create(CipherType, RandomKey), Settings);
+
+	const int32 MessageDataLength = 1001;
+	uint8 MessageData[MessageDataLength];
+	for (int32 i = 0; i < MessageDataLength; i++)
+	{
+		MessageData[i] = (uint8)(i * 7 + 3);
+	}
+	TEST_TRUE_WITH_AUTONAME(ClientStream.Send(MessageData, MessageDataLength) == ETinyEncryptSendResult::TooLarge);
+
+	const int32 MessageCount = 1000;
+	int32 Sent = 0;
+	int32 Received = 0;
+	TArray<TArrayView<const uint8>> Messages;
+	const double StartTime = FPlatformTime::Seconds();
+	while (Received < MessageCount)
+	{
+		while (Sent < MessageCount)
+		{
+			const ETinyEncryptSendResult Result = ClientStream.Send(MessageData, (Sent * 37) % MessageDataLength);
+			TEST_TRUE_WITH_AUTONAME(Result == ETinyEncryptSendResult::Queued || Result == ETinyEncryptSendResult::WouldBlock);
+			if (Result == ETinyEncryptSendResult::WouldBlock)
+			{
+				//Back pressure, the unsent bytes are still buffered
+				TEST_TRUE_WITH_AUTONAME(ClientStream.GetPendingSendBytes() > 0);
+				break;
+			}
+			Sent++;
+		}
+		TEST_TRUE_WITH_AUTONAME(ClientStream.Flush());
+
+		TEST_TRUE_WITH_AUTONAME(ServerStream.Receive(Messages));
+		for (const TArrayView<const uint8>& Message : Messages)
+		{
+			//Same order as sent
+			TEST_TRUE_WITH_AUTONAME(Message.Num() == (Received * 37) % MessageDataLength);
+			TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(Message.GetData(), MessageData, Message.Num()) == 0);
+			Received++;
+		}
+
+		//Don't hang forever
+		TEST_TRUE_WITH_AUTONAME(FPlatformTime::Seconds() - StartTime < 30.0);
+	}
+	TEST_TRUE_WITH_AUTONAME(ClientStream.GetPendingSendBytes() == 0);
+
+	//Reply in the other direction
+	TEST_TRUE_WITH_AUTONAME(ServerStream.Send(MessageData, 10) == ETinyEncryptSendResult::Queued && ServerStream.Flush());
+	while (true)
+	{
+		TEST_TRUE_WITH_AUTONAME(ClientStream.Receive(Messages));
+		if (Messages.Num() > 0)
+		{
+			TEST_TRUE_WITH_AUTONAME(Messages.Num() == 1 && Messages[0].Num() == 10);
+			TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(Messages[0].GetData(), MessageData, 10) == 0);
+			break;
+		}
+		TEST_TRUE_WITH_AUTONAME(FPlatformTime::Seconds() - StartTime < 30.0);
+	}
+	return true;
+}
+
+//The messages sent right before the peer closes the connection are still received
+static bool TestSocketStreamClose(FString& Detail, ISocketSubsystem* SocketSubsystem, FSocket* Listener, const FInternetAddr& Address, ETinyEncryptCipher CipherType)
+{
+	FUInt128Ex RandomKey;
+	RandomKey.MakeRandom();
+
+	FSocket* Client = SocketSubsystem->CreateSocket(NAME_Stream, TEXT("TinyEncryptTestClient"), false);
+	TEST_TRUE_WITH_AUTONAME(Client != nullptr && Client->Connect(Address));
+	FSocket* Server = Listener->Accept(TEXT("TinyEncryptTestServer"));
+	TEST_TRUE_WITH_AUTONAME(Server != nullptr);
+
+	const uint8 MessageData[] = "Logout: server shutting down";
+	const int32 MessageCount = 3;
+	{
+		FTinyEncryptSocketStream ClientStream(Client, ITinyEncryptCipher::Create(CipherType, RandomKey));
+		for (int32 i = 0; i < MessageCount; i++)
+		{
+			TEST_TRUE_WITH_AUTONAME(ClientStream.Send(MessageData, sizeof(MessageData) - i) == ETinyEncryptSendResult::Queued);
+		}
+		TEST_TRUE_WITH_AUTONAME(ClientStream.Flush() && ClientStream.GetPendingSendBytes() == 0);
+	}
+	SocketSubsystem->DestroySocket(Client);
+
+	FTinyEncryptSocketStream ServerStream(Server, ITinyEncryptCipher::Create(CipherType, RandomKey));
+	TArray<TArrayView<const uint8>> Messages;
+	int32 Received = 0;
+	bool bValid = true;
+	const double StartTime = FPlatformTime::Seconds();
+	while (ServerStream.Receive(Messages))
+	{
+		for (const TArrayView<const uint8>& Message : Messages)
+		{
+			bValid &= Received < MessageCount && Message.Num() == (int32)sizeof(MessageData) - Received && FMemory::Memcmp(Message.GetData(), MessageData, Message.Num()) == 0;
+			Received++;
+		}
+		TEST_TRUE_WITH_AUTONAME(FPlatformTime::Seconds() - StartTime < 30.0);
+	}
+	SocketSubsystem->DestroySocket(Server);
+
+	TEST_TRUE_WITH_AUTONAME(bValid && Received == MessageCount && Messages.Num() == 0);
+	return true;
+}
+
+bool TestTinyEncryptSocketStream(FString& Detail)
+{
+	ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+	TEST_TRUE_WITH_AUTONAME(SocketSubsystem != nullptr);
+
+	FSocket* Listener = SocketSubsystem->CreateSocket(NAME_Stream, TEXT("TinyEncryptTestListener"), false);
+	TSharedRef<FInternetAddr> Address = SocketSubsystem->CreateInternetAddr();
+	Address->SetLoopbackAddress();
+	Address->SetPort(0);
+	TEST_TRUE_WITH_AUTONAME(Listener != nullptr && Listener->Bind(*Address) && Listener->Listen(4));
+	Listener->GetAddress(*Address);
+	Address->SetLoopbackAddress();
+
+	bool bSuccess = true;
+	for (ETinyEncryptCipher CipherType : { ETinyEncryptCipher::TEA, ETinyEncryptCipher::AES128 })
+	{
+		FSocket* Client = SocketSubsystem->CreateSocket(NAME_Stream, TEXT("TinyEncryptTestClient"), false);
+		FSocket* Server = nullptr;
+		if (Client != nullptr && Client->Connect(*Address))
+		{
+			Server = Listener->Accept(TEXT("TinyEncryptTestServer"));
+		}
+
+		bSuccess = Server != nullptr && TestSocketStreamWithCipher(Detail, Client, Server, CipherType);
+		bSuccess = bSuccess && TestSocketStreamClose(Detail, SocketSubsystem, Listener, *Address, CipherType);
+
+		//A frame with an invalid length is rejected
+		if (bSuccess)
+		{
+			FTinyEncryptSocketStream ServerStream(Server, ITinyEncryptCipher::Create(CipherType, FUInt128Ex()));
+			const uint8 InvalidFrame[] = { 5, 0, 0, 0, 1, 2, 3, 4, 5 };
+			int32 BytesSent = 0;
+			Client->Send(InvalidFrame, sizeof(InvalidFrame), BytesSent);
+
+			TArray<TArrayView<const uint8>> Messages;
+			const double StartTime = FPlatformTime::Seconds();
+			while (ServerStream.Receive(Messages) && FPlatformTime::Seconds() - StartTime < 30.0)
+			{
+			}
+			bSuccess = FPlatformTime::Seconds() - StartTime < 30.0 && Messages.Num() == 0;
+			if (!bSuccess)
+			{
+				Detail = TEXT("Invalid frame is not rejected");
+			}
+		}
+
+		if (Client != nullptr)
+		{
+			SocketSubsystem->DestroySocket(Client);
+		}
+		if (Server != nullptr)
+		{
+			SocketSubsystem->DestroySocket(Server);
+		}
+		if (!bSuccess)
+		{
+			break;
+		}
+	}
+
+	SocketSubsystem->DestroySocket(Listener);
+	return bSuccess;
+}
+
+#endif //!UE_BUILD_SHIPPING
+
+#if WITH_DEV_AUTOMATION_TESTS && !UE_BUILD_SHIPPING
+
+#if (ENGINE_MAJOR_VERSION >= 5 && ENGINE_MINOR_VERSION >= 5)
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST(FTinyEncryptTestSocketStream, FAutomationTestBase, "TinyEncrypt.SocketStream", EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+#else
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST(FTinyEncryptTestSocketStream, FAutomationTestBase, "TinyEncrypt.SocketStream", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+#endif
+bool FTinyEncryptTestSocketStream::RunTest(const FString& Parameters)
+{
+	FString Detail;
+	bool bSuccess = TestTinyEncryptSocketStream(Detail);
+	TestTrue(Detail, bSuccess);
+	return true;
+}
+
+#endif
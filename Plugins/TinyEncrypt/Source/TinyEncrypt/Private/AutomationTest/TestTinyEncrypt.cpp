@@ -1,6 +1,16 @@
 // Copyright (C) 2024 Neo Jin. All Rights Reserved.
 #include "TinyEncryptAlgorithm.h"
 #include "TinyEncryptUtilities.h"
+#include "TinyEncryptKeystream.h"
+#include "TinyEncryptChunked.h"
+#include "TinyEncryptIncremental.h"
+#include "TinyEncryptXXTEA.h"
+#include "TinyEncryptCipher.h"
+#include "TinyEncryptLiteral.h"
+#include "TinyEncryptCompression.h"
+#include "TinyEncryptBufferPool.h"
+#include "TinyEncryptBlock.h"
+#include "HAL/PlatformProcess.h"
 #include "Misc/Paths.h"
 #include "AutomationTest/TinyEncryptAutomationTestInterface.h"
 #include "Misc/AutomationTest.h"
@@ -9,6 +19,11 @@
 
 #if !UE_BUILD_SHIPPING
 
+static const char* GetTestLiteral()
+{
+	return *TINYENCRYPT_LITERAL("Hello,World!");
+}
+
 bool TestTinyEncryptEncrypt(FString& Detail)
 {
 	const int32 MaxOutputLength = 256;
@@ -154,6 +169,881 @@ bool TestTinyEncryptEncrypt(FString& Detail)
 		TEST_TRUE_WITH_AUTONAME(DecryptedData.Num() == PlainTextLen);
 		TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(PlainText, DecryptedData.GetData(), PlainTextLen) == 0);
 	}
+
+	//Test in place encryption of the async action, across the 1MB chunks
+	{
+		FUInt128Ex RandomKey;
+		RandomKey.MakeRandom();
+		FTinyEncrypt TEA(RandomKey);
+
+		for (int32 PlainTextLen : { 0, 5, 1024 * 1024 - 8, 1024 * 1024, 1024 * 1024 + 3, 2 * 1024 * 1024 + 13 })
+		{
+			TArray<uint8> PlainText;
+			PlainText.SetNumUninitialized(PlainTextLen);
+			for (int32 i = 0; i < PlainTextLen; i++)
+			{
+				PlainText[i] = (uint8)(i * 13 + (i >> 10));
+			}
+
+			TArray<uint8> Expected;
+			Expected.SetNumUninitialized(FTinyEncrypt::GetEncryptLength(PlainTextLen));
+			TEST_TRUE_WITH_AUTONAME(TEA.Encrypt(PlainText.GetData(), PlainTextLen, Expected.GetData()) == Expected.Num());
+
+			float LastProgress = 0.0f;
+			bool bProgressValid = true;
+			auto OnProgress = [&LastProgress, &bProgressValid](float Progress)
+			{
+				bProgressValid = bProgressValid && Progress > LastProgress && Progress < 1.0f;
+				LastProgress = Progress;
+			};
+
+			TArray<uint8> Data = PlainText;
+			TEST_TRUE_WITH_AUTONAME(TinyEncryptBlock::CryptInPlace(RandomKey, false, Data, OnProgress));
+			TEST_TRUE_WITH_AUTONAME(Data == Expected);
+
+			LastProgress = 0.0f;
+			TEST_TRUE_WITH_AUTONAME(TinyEncryptBlock::CryptInPlace(RandomKey, true, Data, OnProgress));
+			TEST_TRUE_WITH_AUTONAME(Data == PlainText);
+			TEST_TRUE_WITH_AUTONAME(bProgressValid);
+		}
+
+		auto IgnoreProgress = [](float) {};
+
+		//Invalid length
+		for (int32 InvalidLen : { 0, 7, 1024 * 1024 + 9 })
+		{
+			TArray<uint8> Data;
+			Data.SetNumZeroed(InvalidLen);
+			TEST_TRUE_WITH_AUTONAME(!TinyEncryptBlock::CryptInPlace(RandomKey, true, Data, IgnoreProgress) && Data.Num() == 0);
+		}
+
+		//Invalid padding, the last block decrypts to a pad length of 0
+		{
+			uint8 BadTail[8] = { 1, 2, 3, 4, 5, 6, 7, 0 };
+			TArray<uint8> Data;
+			Data.SetNumZeroed(1024 * 1024 + 8);
+			TEST_TRUE_WITH_AUTONAME(TEA.EncryptCTS(BadTail, 8, Data.GetData() + 1024 * 1024) == 8);
+			TEST_TRUE_WITH_AUTONAME(!TinyEncryptBlock::CryptInPlace(RandomKey, true, Data, IgnoreProgress) && Data.Num() == 0);
+		}
+	}
+
+	//Test ciphertext stealing mode
+	{
+		TEST_TRUE_WITH_AUTONAME(FTinyEncrypt::GetEncryptLengthCTS(0) == -1);
+		TEST_TRUE_WITH_AUTONAME(FTinyEncrypt::GetEncryptLengthCTS(7) == -1);
+		TEST_TRUE_WITH_AUTONAME(FTinyEncrypt::GetEncryptLengthCTS(8) == 8);
+		TEST_TRUE_WITH_AUTONAME(FTinyEncrypt::GetEncryptLengthCTS(13) == 13);
+		TEST_TRUE_WITH_AUTONAME(FTinyEncrypt::GetDecryptLengthCTS(13) == 13);
+
+		uint8* PlainText = (uint8*)"ABCDEFGHIGKLMNOPQRSTUVWXYZ0123456789";
+		int32 PlainTextLen = TCString<char>::Strlen((const char*)PlainText);
+
+		FUInt128Ex RandomKey;
+		RandomKey.MakeRandom();
+		FTinyEncrypt TEA(RandomKey);
+
+		TEST_TRUE_WITH_AUTONAME(TEA.EncryptCTS(PlainText, 7, EncryptOutputBuff) == -1);
+
+		for (int32 Len = 8; Len <= PlainTextLen; Len++)
+		{
+			int32 RealEncryptLength = TEA.EncryptCTS(PlainText, Len, EncryptOutputBuff);
+			TEST_TRUE_WITH_AUTONAME(RealEncryptLength == Len);
+
+			int32 RealDecryptLength = TEA.DecryptCTS(EncryptOutputBuff, RealEncryptLength, DecryptOutputBuff);
+			TEST_TRUE_WITH_AUTONAME(RealDecryptLength == Len);
+			TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(PlainText, DecryptOutputBuff, Len) == 0);
+
+			//Encrypt and decrypt in place
+			uint8 InPlaceBuff[MaxOutputLength];
+			FMemory::Memcpy(InPlaceBuff, PlainText, Len);
+			TEA.EncryptCTS(InPlaceBuff, Len, InPlaceBuff);
+			TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(InPlaceBuff, EncryptOutputBuff, Len) == 0);
+			TEA.DecryptCTS(InPlaceBuff, Len, InPlaceBuff);
+			TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(InPlaceBuff, PlainText, Len) == 0);
+		}
+
+		//The full blocks are the same as the default mode
+		TEA.Encrypt(PlainText, 16, DecryptOutputBuff);
+		TEA.EncryptCTS(PlainText, 16, EncryptOutputBuff);
+		TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(EncryptOutputBuff, DecryptOutputBuff, 16) == 0);
+	}
+
+	//Test authenticated mode
+	{
+		TEST_TRUE_WITH_AUTONAME(FTinyEncrypt::GetEncryptAndTagLength(0) == 16);
+		TEST_TRUE_WITH_AUTONAME(FTinyEncrypt::GetEncryptAndTagLength(8) == 24);
+		TEST_TRUE_WITH_AUTONAME(FTinyEncrypt::GetDecryptAndVerifyLength(24) == 16);
+
+		uint8* PlainText = (uint8*)"ABCDEFGHIGKLMNOPQRSTUVWXYZ0123456789";
+		int32 PlainTextLen = TCString<char>::Strlen((const char*)PlainText);
+
+		FUInt128Ex RandomKey;
+		RandomKey.MakeRandom();
+		FTinyEncrypt TEA(RandomKey);
+
+		for (int32 Len = 0; Len <= PlainTextLen; Len++)
+		{
+			int32 RealEncryptLength = TEA.EncryptAndTag(PlainText, Len, EncryptOutputBuff);
+			TEST_TRUE_WITH_AUTONAME(RealEncryptLength == FTinyEncrypt::GetEncryptAndTagLength(Len));
+
+			//Same encrypted data as the default mode
+			TEA.Encrypt(PlainText, Len, DecryptOutputBuff);
+			TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(EncryptOutputBuff, DecryptOutputBuff, FTinyEncrypt::GetEncryptLength(Len)) == 0);
+
+			int32 RealDecryptLength = TEA.DecryptAndVerify(EncryptOutputBuff, RealEncryptLength, DecryptOutputBuff);
+			TEST_TRUE_WITH_AUTONAME(RealDecryptLength == Len);
+			TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(PlainText, DecryptOutputBuff, Len) == 0);
+		}
+
+		//Tampered data
+		int32 EncryptLength = TEA.EncryptAndTag(PlainText, PlainTextLen, EncryptOutputBuff);
+		for (int32 i = 0; i < EncryptLength; i++)
+		{
+			EncryptOutputBuff[i] ^= 0x01;
+			TEST_TRUE_WITH_AUTONAME(TEA.DecryptAndVerify(EncryptOutputBuff, EncryptLength, DecryptOutputBuff) == -1);
+			EncryptOutputBuff[i] ^= 0x01;
+		}
+		TEST_TRUE_WITH_AUTONAME(TEA.DecryptAndVerify(EncryptOutputBuff, EncryptLength - 8, DecryptOutputBuff) == -1);
+		TEST_TRUE_WITH_AUTONAME(TEA.DecryptAndVerify(EncryptOutputBuff, 8, DecryptOutputBuff) == -1);
+
+		//Nothing is written if the tag is wrong, so the encrypted data survives a failed in place call
+		{
+			uint8 InPlaceBuff[64];
+			FMemory::Memcpy(InPlaceBuff, EncryptOutputBuff, EncryptLength);
+			InPlaceBuff[EncryptLength - 1] ^= 0x01;
+			TEST_TRUE_WITH_AUTONAME(TEA.DecryptAndVerify(InPlaceBuff, EncryptLength, InPlaceBuff) == -1);
+			InPlaceBuff[EncryptLength - 1] ^= 0x01;
+			TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(InPlaceBuff, EncryptOutputBuff, EncryptLength) == 0);
+
+			TEST_TRUE_WITH_AUTONAME(TEA.DecryptAndVerify(InPlaceBuff, EncryptLength, InPlaceBuff) == PlainTextLen);
+			TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(InPlaceBuff, PlainText, PlainTextLen) == 0);
+		}
+
+		//Wrong key
+		FUInt128Ex AnotherKey;
+		AnotherKey.MakeRandom();
+		FTinyEncrypt AnotherTEA(AnotherKey);
+		TEST_TRUE_WITH_AUTONAME(AnotherTEA.DecryptAndVerify(EncryptOutputBuff, EncryptLength, DecryptOutputBuff) == -1);
+	}
+
+	//Test fan-out encryption
+	{
+		uint8* PlainText = (uint8*)"ABCDEFGHIGKLMNOPQRSTUVWXYZ0123456789";
+		int32 PlainTextLen = TCString<char>::Strlen((const char*)PlainText);
+
+		const int32 MaxKeys = 9;
+		TArray<FTinyEncrypt> Ciphers;
+		for (int32 i = 0; i < MaxKeys; i++)
+		{
+			FUInt128Ex RandomKey;
+			RandomKey.MakeRandom();
+			Ciphers.Add(FTinyEncrypt(RandomKey));
+		}
+
+		uint8 FanOutBuff[MaxKeys][MaxOutputLength];
+		uint8* OutBufs[MaxKeys];
+		for (int32 i = 0; i < MaxKeys; i++)
+		{
+			OutBufs[i] = FanOutBuff[i];
+		}
+
+		for (int32 NumKeys : { 1, 3, 4, 5, MaxKeys })
+		{
+			for (int32 Len : { 0, 7, 8, PlainTextLen })
+			{
+				int32 RealEncryptLength = FTinyEncrypt::EncryptFanOut(PlainText, Len,
+					TArrayView<const FTinyEncrypt>(Ciphers.GetData(), NumKeys), TArrayView<uint8* const>(OutBufs, NumKeys));
+				TEST_TRUE_WITH_AUTONAME(RealEncryptLength == FTinyEncrypt::GetEncryptLength(Len));
+
+				for (int32 i = 0; i < NumKeys; i++)
+				{
+					Ciphers[i].Encrypt(PlainText, Len, EncryptOutputBuff);
+					TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(FanOutBuff[i], EncryptOutputBuff, RealEncryptLength) == 0);
+				}
+			}
+		}
+	}
+
+	//Test batch encryption
+	{
+		uint8* PlainText = (uint8*)"ABCDEFGHIGKLMNOPQRSTUVWXYZ0123456789";
+		int32 PlainTextLen = TCString<char>::Strlen((const char*)PlainText);
+
+		FUInt128Ex RandomKey;
+		RandomKey.MakeRandom();
+		FTinyEncrypt TEA(RandomKey);
+
+		const int32 ItemCounts = 11;
+		uint8 BatchBuff[ItemCounts][MaxOutputLength];
+		TArray<FTinyEncryptBatchItem> Items;
+		for (int32 i = 0; i < ItemCounts; i++)
+		{
+			FTinyEncryptBatchItem Item;
+			Item.InBuf = PlainText;
+			Item.InLen = (i * 7) % (PlainTextLen + 1);
+			Item.OutBuf = BatchBuff[i];
+			Items.Add(Item);
+		}
+
+		//The last one is encrypted in place
+		FMemory::Memcpy(BatchBuff[ItemCounts - 1], PlainText, PlainTextLen);
+		Items[ItemCounts - 1].InBuf = BatchBuff[ItemCounts - 1];
+		Items[ItemCounts - 1].InLen = PlainTextLen;
+
+		TEA.EncryptBatch(Items);
+		for (int32 i = 0; i < ItemCounts; i++)
+		{
+			const int32 ExpectLength = TEA.Encrypt(PlainText, Items[i].InLen, EncryptOutputBuff);
+			TEST_TRUE_WITH_AUTONAME(Items[i].OutLen == ExpectLength);
+			TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(BatchBuff[i], EncryptOutputBuff, ExpectLength) == 0);
+
+			//Decrypt in place
+			Items[i].InBuf = BatchBuff[i];
+			Items[i].InLen = Items[i].OutLen;
+		}
+
+		//Invalid length
+		Items[3].InLen = 5;
+
+		TEA.DecryptBatch(Items);
+		for (int32 i = 0; i < ItemCounts; i++)
+		{
+			if (i == 3)
+			{
+				TEST_TRUE_WITH_AUTONAME(Items[i].OutLen == -1);
+				continue;
+			}
+			const int32 ExpectLength = (i == ItemCounts - 1) ? PlainTextLen : (i * 7) % (PlainTextLen + 1);
+			TEST_TRUE_WITH_AUTONAME(Items[i].OutLen == ExpectLength);
+			TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(BatchBuff[i], PlainText, ExpectLength) == 0);
+		}
+	}
+
+	//Test authenticated batch encryption, the output is the same as the single message version
+	{
+		uint8* PlainText = (uint8*)"ABCDEFGHIGKLMNOPQRSTUVWXYZ0123456789";
+		int32 PlainTextLen = TCString<char>::Strlen((const char*)PlainText);
+
+		FUInt128Ex RandomKey;
+		RandomKey.MakeRandom();
+		FTinyEncrypt TEA(RandomKey);
+
+		const int32 ItemCounts = 11;
+		uint8 BatchBuff[ItemCounts][MaxOutputLength];
+		TArray<FTinyEncryptBatchItem> Items;
+		for (int32 i = 0; i < ItemCounts; i++)
+		{
+			FTinyEncryptBatchItem Item;
+			Item.InBuf = PlainText;
+			Item.InLen = (i * 7) % (PlainTextLen + 1);
+			Item.OutBuf = BatchBuff[i];
+			Items.Add(Item);
+		}
+
+		TEA.EncryptAndTagBatch(Items);
+		for (int32 i = 0; i < ItemCounts; i++)
+		{
+			const int32 ExpectLength = TEA.EncryptAndTag(PlainText, Items[i].InLen, EncryptOutputBuff);
+			TEST_TRUE_WITH_AUTONAME(Items[i].OutLen == ExpectLength);
+			TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(BatchBuff[i], EncryptOutputBuff, ExpectLength) == 0);
+
+			//Verify in place
+			Items[i].InBuf = BatchBuff[i];
+			Items[i].InLen = Items[i].OutLen;
+		}
+
+		//Invalid length, tampered data and tampered tag
+		Items[3].InLen = 5;
+		BatchBuff[5][0] ^= 1;
+		BatchBuff[6][Items[6].InLen - 1] ^= 1;
+
+		TEA.DecryptAndVerifyBatch(Items);
+		for (int32 i = 0; i < ItemCounts; i++)
+		{
+			if (i == 3 || i == 5 || i == 6)
+			{
+				TEST_TRUE_WITH_AUTONAME(Items[i].OutLen == -1);
+				continue;
+			}
+			const int32 ExpectLength = (i * 7) % (PlainTextLen + 1);
+			TEST_TRUE_WITH_AUTONAME(Items[i].OutLen == ExpectLength);
+			TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(BatchBuff[i], PlainText, ExpectLength) == 0);
+		}
+	}
+
+	//Test counter mode
+	{
+		FUInt128Ex RandomKey;
+		RandomKey.MakeRandom();
+		FTinyEncrypt TEA(RandomKey);
+
+		uint8 PlainBuff[200];
+		for (int32 i = 0; i < 200; i++)
+		{
+			PlainBuff[i] = (uint8)(i * 7);
+		}
+
+		const uint64 InitialCounter = 0xFFFFFFFFFFFFFFF0ULL;
+		TEST_TRUE_WITH_AUTONAME(TEA.EncryptCTR(PlainBuff, 200, EncryptOutputBuff, InitialCounter) == 200);
+		TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(PlainBuff, EncryptOutputBuff, 200) != 0);
+
+		//The first block is the encrypted counter
+		uint8 ZeroBuff[8] = { 0 };
+		uint8 CounterBlock[8] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0 };
+		uint8 ExpectBuff[16];
+		TEA.EncryptCTR(ZeroBuff, 8, DecryptOutputBuff, InitialCounter);
+		TEA.Encrypt(CounterBlock, 8, ExpectBuff);
+		TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(DecryptOutputBuff, ExpectBuff, 8) == 0);
+
+		//Decrypt any range with its stream offset, in place
+		for (int32 Offset = 0; Offset < 200; Offset += 13)
+		{
+			const int32 Len = FMath::Min(200 - Offset, 37);
+			FMemory::Memcpy(DecryptOutputBuff, EncryptOutputBuff + Offset, Len);
+			TEST_TRUE_WITH_AUTONAME(TEA.DecryptCTR(DecryptOutputBuff, Len, DecryptOutputBuff, InitialCounter, Offset) == Len);
+			TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(DecryptOutputBuff, PlainBuff + Offset, Len) == 0);
+		}
+
+		//Precomputed keystream has the same output, without auto refill
+		{
+			FTinyEncryptKeystream Keystream(RandomKey, InitialCounter, 64, 16);
+			TEST_TRUE_WITH_AUTONAME(Keystream.GetReadyBytes() == 0);
+
+			//Computed inline
+			TEST_TRUE_WITH_AUTONAME(Keystream.Encrypt(PlainBuff, 10, DecryptOutputBuff) == 0);
+			TEST_TRUE_WITH_AUTONAME(Keystream.GetReadyBytes() == 0);
+
+			Keystream.Refill();
+			TEST_TRUE_WITH_AUTONAME(Keystream.GetReadyBytes() == 64);
+
+			//Partly precomputed, wrap around the ring
+			TEST_TRUE_WITH_AUTONAME(Keystream.Encrypt(PlainBuff + 10, 50, DecryptOutputBuff + 10) == 10);
+			Keystream.Refill();
+			TEST_TRUE_WITH_AUTONAME(Keystream.Encrypt(PlainBuff + 60, 140, DecryptOutputBuff + 60) == 60);
+			TEST_TRUE_WITH_AUTONAME(Keystream.GetStreamOffset() == 200);
+			TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(DecryptOutputBuff, EncryptOutputBuff, 200) == 0);
+		}
+
+		//Auto refill on background thread
+		{
+			TSharedPtr<FTinyEncryptKeystream, ESPMode::ThreadSafe> Keystream = MakeShared<FTinyEncryptKeystream, ESPMode::ThreadSafe>(RandomKey, InitialCounter, 1024, 512);
+			uint64 StreamOffset = 0;
+			for (int32 Round = 0; Round < 200; Round++)
+			{
+				const int32 Len = Round % 50;
+				uint8 Buff[64];
+				FMemory::Memcpy(Buff, PlainBuff, Len);
+				TEST_TRUE_WITH_AUTONAME(Keystream->Encrypt(Buff, Len, Buff) == StreamOffset);
+				TEST_TRUE_WITH_AUTONAME(TEA.DecryptCTR(Buff, Len, Buff, InitialCounter, StreamOffset) == Len);
+				TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(Buff, PlainBuff, Len) == 0);
+				StreamOffset += Len;
+
+				if (Round % 20 == 0)
+				{
+					FPlatformProcess::Sleep(0.001f);
+				}
+			}
+		}
+	}
+
+	//Test 64-bit length and chunked processing
+	{
+		FUInt128Ex RandomKey;
+		RandomKey.MakeRandom();
+		FTinyEncrypt TEA(RandomKey);
+
+		const int64 DataLen = 1000;
+		TArray64<uint8> PlainData;
+		PlainData.SetNumUninitialized(DataLen);
+		for (int64 i = 0; i < DataLen; i++)
+		{
+			PlainData[i] = (uint8)(i * 13 + 5);
+		}
+
+		TArray<uint8> ExpectData;
+		ExpectData.SetNumUninitialized(FTinyEncrypt::GetEncryptLength((int32)DataLen));
+		TEA.Encrypt(PlainData.GetData(), (int32)DataLen, ExpectData.GetData());
+
+		TArray64<uint8> EncryptData = UTinyEncryptUtilities::EncryptWithTEA64(PlainData, RandomKey);
+		TEST_TRUE_WITH_AUTONAME(EncryptData.Num() == FTinyEncrypt::GetEncryptLength64(DataLen));
+		TEST_TRUE_WITH_AUTONAME(EncryptData.Num() == ExpectData.Num());
+		TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(EncryptData.GetData(), ExpectData.GetData(), ExpectData.Num()) == 0);
+
+		TArray64<uint8> DecryptData = UTinyEncryptUtilities::DecryptWithTEA64(EncryptData, RandomKey);
+		TEST_TRUE_WITH_AUTONAME(DecryptData.Num() == DataLen);
+		TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(DecryptData.GetData(), PlainData.GetData(), DataLen) == 0);
+		TEST_TRUE_WITH_AUTONAME(TEA.Decrypt64(EncryptData.GetData(), 7, DecryptData.GetData()) == -1);
+
+		//Block level pieces, the blocks are processed out of order
+		{
+			const int64 NumBlocks = DataLen / FTinyEncrypt::BlockSize;
+			const int64 BlockBytes = NumBlocks * FTinyEncrypt::BlockSize;
+			TArray64<uint8> PieceData = PlainData;
+			PieceData.SetNumUninitialized(BlockBytes + FTinyEncrypt::BlockSize);
+			TEA.EncryptBlocks(PieceData.GetData() + 40 * 8, PieceData.GetData() + 40 * 8, NumBlocks - 40);
+			TEA.EncryptBlocks(PieceData.GetData(), PieceData.GetData(), 40);
+			TEST_TRUE_WITH_AUTONAME(TEA.EncryptTail(PlainData.GetData() + BlockBytes, (int32)(DataLen - BlockBytes), PieceData.GetData() + BlockBytes) == FTinyEncrypt::BlockSize);
+			TEST_TRUE_WITH_AUTONAME(PieceData.Num() == ExpectData.Num());
+			TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(PieceData.GetData(), ExpectData.GetData(), ExpectData.Num()) == 0);
+
+			TEA.DecryptBlocks(PieceData.GetData(), PieceData.GetData(), NumBlocks);
+			TEST_TRUE_WITH_AUTONAME(TEA.DecryptTail(PieceData.GetData() + BlockBytes, PieceData.GetData() + BlockBytes) == DataLen - BlockBytes);
+			TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(PieceData.GetData(), PlainData.GetData(), DataLen) == 0);
+
+			//A last block which decrypts to a pad length of 0
+			uint8 TailBuff[8] = { 1, 2, 3, 4, 5, 6, 7, 0 };
+			TEA.EncryptBlocks(TailBuff, TailBuff, 1);
+			TEST_TRUE_WITH_AUTONAME(TEA.DecryptTail(TailBuff, TailBuff) == -1);
+		}
+
+		//Chunks of any size, the output is the same as one call
+		const int32 ChunkSizes[] = { 1, 3, 8, 0, 17, 64, 5, 100, 2 };
+		for (int32 Round = 0; Round < 2; Round++)
+		{
+			FTinyEncryptChunkedEncryptor Encryptor(RandomKey);
+			TArray64<uint8> ChunkedData;
+			ChunkedData.SetNumUninitialized(FTinyEncrypt::GetEncryptLength64(DataLen));
+
+			int64 InPos = 0, OutPos = 0, ChunkIndex = Round;
+			while (InPos < DataLen)
+			{
+				const int64 ChunkLen = FMath::Min<int64>(ChunkSizes[ChunkIndex++ % UE_ARRAY_COUNT(ChunkSizes)], DataLen - InPos);
+				OutPos += Encryptor.Update(PlainData.GetData() + InPos, ChunkLen, ChunkedData.GetData() + OutPos);
+				InPos += ChunkLen;
+			}
+			TEST_TRUE_WITH_AUTONAME(Encryptor.GetTotalInput() == DataLen);
+			OutPos += Encryptor.Finalize(ChunkedData.GetData() + OutPos);
+			TEST_TRUE_WITH_AUTONAME(OutPos == ExpectData.Num());
+			TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(ChunkedData.GetData(), ExpectData.GetData(), OutPos) == 0);
+
+			FTinyEncryptChunkedDecryptor Decryptor(RandomKey);
+			TArray64<uint8> ChunkedPlain;
+			ChunkedPlain.SetNumUninitialized(DataLen + 16);
+
+			const int64 EncryptLen = OutPos;
+			InPos = 0, OutPos = 0, ChunkIndex = Round + 3;
+			while (InPos < EncryptLen)
+			{
+				const int64 ChunkLen = FMath::Min<int64>(ChunkSizes[ChunkIndex++ % UE_ARRAY_COUNT(ChunkSizes)], EncryptLen - InPos);
+				OutPos += Decryptor.Update(ChunkedData.GetData() + InPos, ChunkLen, ChunkedPlain.GetData() + OutPos);
+				InPos += ChunkLen;
+			}
+			const int32 LastLen = Decryptor.Finalize(ChunkedPlain.GetData() + OutPos);
+			TEST_TRUE_WITH_AUTONAME(LastLen >= 0);
+			TEST_TRUE_WITH_AUTONAME(OutPos + LastLen == DataLen);
+			TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(ChunkedPlain.GetData(), PlainData.GetData(), DataLen) == 0);
+		}
+
+		//Truncated stream
+		FTinyEncryptChunkedDecryptor Decryptor(RandomKey);
+		uint8 OutBuff[32];
+		TEST_TRUE_WITH_AUTONAME(Decryptor.Update(ExpectData.GetData(), 13, OutBuff) == 8);
+		TEST_TRUE_WITH_AUTONAME(Decryptor.Finalize(OutBuff) == -1);
+		TEST_TRUE_WITH_AUTONAME(Decryptor.Finalize(OutBuff) == -1);
+	}
+
+	//Test incremental re-encryption
+	{
+		FUInt128Ex RandomKey;
+		RandomKey.MakeRandom();
+
+		//Not a multiple of the block size, the last full block and the tail are encrypted together
+		const int32 BlobSize = 1003;
+		FTinyEncryptIncremental Tracker(RandomKey, 1000, BlobSize);
+		TArray<uint8> PlainBlob, EncryptedBlob, ExpectBlob;
+		PlainBlob.SetNumUninitialized(BlobSize);
+		EncryptedBlob.SetNumUninitialized(BlobSize);
+		ExpectBlob.SetNumUninitialized(BlobSize);
+		for (int32 i = 0; i < BlobSize; i++)
+		{
+			PlainBlob[i] = (uint8)(i * 31);
+		}
+
+		//Whole blob round trip
+		Tracker.EncryptRange(PlainBlob.GetData(), EncryptedBlob.GetData(), 0, BlobSize);
+		TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(EncryptedBlob.GetData(), PlainBlob.GetData(), BlobSize) != 0);
+		Tracker.DecryptRange(EncryptedBlob.GetData(), ExpectBlob.GetData(), 0, BlobSize);
+		TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(ExpectBlob.GetData(), PlainBlob.GetData(), BlobSize) == 0);
+
+		//Another InitialCounter gives another output
+		FTinyEncryptIncremental OtherTracker(RandomKey, 1001, BlobSize);
+		OtherTracker.EncryptRange(PlainBlob.GetData(), ExpectBlob.GetData(), 0, BlobSize);
+		TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(EncryptedBlob.GetData(), ExpectBlob.GetData(), 8) != 0);
+
+		//Ranges are widened to whole blocks, overlapped and adjacent ranges are merged
+		TEST_TRUE_WITH_AUTONAME(!Tracker.IsDirty());
+		Tracker.MarkDirty(100, 10);
+		Tracker.MarkDirty(300, 5);
+		Tracker.MarkDirty(105, 20);
+		Tracker.MarkDirty(125, 3);
+		Tracker.MarkDirty(0, 0);
+		Tracker.MarkDirty(990, 10);
+		Tracker.MarkDirty(299, 2);
+		TEST_TRUE_WITH_AUTONAME(Tracker.GetDirtyBytes() == (128 - 96) + (312 - 296) + (BlobSize - 984));
+
+		for (int32 i : { 100, 127, 299, 304, 995 })
+		{
+			PlainBlob[i] ^= 0x5A;
+		}
+		TEST_TRUE_WITH_AUTONAME(Tracker.Flush(PlainBlob.GetData(), EncryptedBlob.GetData()) == 32 + 16 + 19);
+		TEST_TRUE_WITH_AUTONAME(!Tracker.IsDirty());
+
+		Tracker.EncryptRange(PlainBlob.GetData(), ExpectBlob.GetData(), 0, BlobSize);
+		TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(EncryptedBlob.GetData(), ExpectBlob.GetData(), BlobSize) == 0);
+
+		//Modify the encrypted blob in place, in the middle and in the tail
+		for (int32 Offset : { 500, 1001 })
+		{
+			Tracker.DecryptRange(EncryptedBlob.GetData(), Offset, 2);
+			TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(EncryptedBlob.GetData() + Offset, PlainBlob.GetData() + Offset, 2) == 0);
+			EncryptedBlob[Offset + 1] = PlainBlob[Offset + 1] = 0xEE;
+			Tracker.MarkDirty(Offset, 2);
+			Tracker.Flush(EncryptedBlob.GetData(), EncryptedBlob.GetData());
+
+			Tracker.EncryptRange(PlainBlob.GetData(), ExpectBlob.GetData(), 0, BlobSize);
+			TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(EncryptedBlob.GetData(), ExpectBlob.GetData(), BlobSize) == 0);
+		}
+
+		//Re-encrypting a range with new data doesn't reuse a keystream, the XOR of the old and new encrypted data
+		//is not the XOR of the old and new plain data
+		TArray<uint8> OldPlainBlob = PlainBlob;
+		TArray<uint8> OldEncryptedBlob = EncryptedBlob;
+		for (int32 i = 200; i < 264; i++)
+		{
+			PlainBlob[i] = (uint8)(i * 7 + 1);
+		}
+		Tracker.MarkDirty(200, 64);
+		Tracker.Flush(PlainBlob.GetData(), EncryptedBlob.GetData());
+		for (int32 Block = 200; Block < 264; Block += 8)
+		{
+			uint8 PlainDiff[8], EncryptedDiff[8];
+			for (int32 i = 0; i < 8; i++)
+			{
+				PlainDiff[i] = OldPlainBlob[Block + i] ^ PlainBlob[Block + i];
+				EncryptedDiff[i] = OldEncryptedBlob[Block + i] ^ EncryptedBlob[Block + i];
+			}
+			TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(PlainDiff, EncryptedDiff, 8) != 0);
+		}
+		TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(OldEncryptedBlob.GetData(), EncryptedBlob.GetData(), 200) == 0);
+		TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(OldEncryptedBlob.GetData() + 264, EncryptedBlob.GetData() + 264, BlobSize - 264) == 0);
+
+		Tracker.DecryptRange(EncryptedBlob.GetData(), ExpectBlob.GetData(), 0, BlobSize);
+		TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(ExpectBlob.GetData(), PlainBlob.GetData(), BlobSize) == 0);
+	}
+
+	//Test key derivation
+	{
+		FUInt128Ex SolidKey(0x651085792dd1313e, 0x5b550778601818ae);
+		TEST_TRUE_WITH_AUTONAME(FTinyEncrypt::DeriveKey(SolidKey, 0) == FUInt128Ex(0xee69278eb51ca3f7ULL, 0x1878e9bd6efaace1ULL));
+		TEST_TRUE_WITH_AUTONAME(FTinyEncrypt::DeriveKey(SolidKey, 1) == FUInt128Ex(0x1dcf3b3d2e510937ULL, 0x2ae8a54a4a62f204ULL));
+		TEST_TRUE_WITH_AUTONAME(UTinyEncryptUtilities::DeriveTEAKey(SolidKey, 1) == FTinyEncrypt::DeriveKey(SolidKey, 1));
+
+		//Both peers derive the same key from the DH secret key
+		FDiffieHellmanKeyPair Alice, Bob;
+		Alice.GenerateRandomKeyPair();
+		Bob.GenerateRandomKeyPair();
+		FUInt128Ex AliceKey = FTinyEncrypt::DeriveKey(Alice.GenerateSecretKey(Bob.PublicKey), 100);
+		FUInt128Ex BobKey = FTinyEncrypt::DeriveKey(Bob.GenerateSecretKey(Alice.PublicKey), 100);
+		TEST_TRUE_WITH_AUTONAME(AliceKey == BobKey);
+		TEST_TRUE_WITH_AUTONAME(!(AliceKey == FTinyEncrypt::DeriveKey(Alice.GenerateSecretKey(Bob.PublicKey), 101)));
+	}
+
+	//XXTEA
+	{
+		TEST_TRUE_WITH_AUTONAME(FTinyEncryptXXTEA::GetEncryptLength(0) == 8);
+		TEST_TRUE_WITH_AUTONAME(FTinyEncryptXXTEA::GetEncryptLength(4) == 8);
+		TEST_TRUE_WITH_AUTONAME(FTinyEncryptXXTEA::GetEncryptLength(7) == 8);
+		TEST_TRUE_WITH_AUTONAME(FTinyEncryptXXTEA::GetEncryptLength(8) == 12);
+		TEST_TRUE_WITH_AUTONAME(FTinyEncryptXXTEA::GetDecryptLength(12) == 12);
+
+		//Known answer, the words are big endian as FTinyEncrypt
+		const uint8* PlainText = (const uint8*)"Hello,World!";
+		const uint8 Expected[] = { 0x0c, 0x44, 0x52, 0xc6, 0x61, 0x40, 0x6f, 0x26, 0xff, 0x83, 0xb5, 0x28, 0x72, 0x4c, 0xe5, 0x17 };
+		FTinyEncryptXXTEA SolidXXTEA(FUInt128Ex(0x0123456789abcdefULL, 0xfedcba9876543210ULL));
+		TEST_TRUE_WITH_AUTONAME(SolidXXTEA.Encrypt(PlainText, 12, EncryptOutputBuff) == 16);
+		TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(EncryptOutputBuff, Expected, sizeof(Expected)) == 0);
+		TEST_TRUE_WITH_AUTONAME(SolidXXTEA.Decrypt(EncryptOutputBuff, 16, DecryptOutputBuff) == 12);
+		TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(DecryptOutputBuff, PlainText, 12) == 0);
+
+		//The words are processed in the output buffer, which may not be aligned
+		TEST_TRUE_WITH_AUTONAME(SolidXXTEA.Encrypt(PlainText, 12, EncryptOutputBuff + 1) == 16);
+		TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(EncryptOutputBuff + 1, Expected, sizeof(Expected)) == 0);
+		TEST_TRUE_WITH_AUTONAME(SolidXXTEA.Decrypt(EncryptOutputBuff + 1, 16, DecryptOutputBuff + 3) == 12);
+		TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(DecryptOutputBuff + 3, PlainText, 12) == 0);
+
+		//All lengths, in place
+		FUInt128Ex RandomKey;
+		RandomKey.MakeRandom();
+		FTinyEncryptXXTEA XXTEA(RandomKey);
+		const int32 PlainBuffLength = 200;
+		uint8 PlainBuff[PlainBuffLength];
+		for (int32 i = 0; i < PlainBuffLength; i++)
+		{
+			PlainBuff[i] = (uint8)(i * 7 + 3);
+		}
+		for (int32 Len = 0; Len <= PlainBuffLength; Len += 13)
+		{
+			FMemory::Memcpy(EncryptOutputBuff, PlainBuff, Len);
+			const int32 EncryptLength = XXTEA.Encrypt(EncryptOutputBuff, Len, EncryptOutputBuff);
+			TEST_TRUE_WITH_AUTONAME(EncryptLength == FTinyEncryptXXTEA::GetEncryptLength(Len));
+			TEST_TRUE_WITH_AUTONAME(XXTEA.Decrypt(EncryptOutputBuff, EncryptLength, EncryptOutputBuff) == Len);
+			TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(EncryptOutputBuff, PlainBuff, Len) == 0);
+		}
+
+		//Invalid length
+		TEST_TRUE_WITH_AUTONAME(XXTEA.Decrypt(EncryptOutputBuff, 4, DecryptOutputBuff) == -1);
+		TEST_TRUE_WITH_AUTONAME(XXTEA.Decrypt(EncryptOutputBuff, 10, DecryptOutputBuff) == -1);
+
+		//Blueprint Utilities
+		TArray<uint8> InputData(PlainText, 12);
+		TArray<uint8> EncryptedData = UTinyEncryptUtilities::EncryptWithXXTEA(InputData, RandomKey);
+		TEST_TRUE_WITH_AUTONAME(EncryptedData.Num() == 16);
+		TEST_TRUE_WITH_AUTONAME(UTinyEncryptUtilities::DecryptWithXXTEA(EncryptedData, RandomKey) == InputData);
+		TEST_TRUE_WITH_AUTONAME(UTinyEncryptUtilities::DecryptWithXXTEA(TArray<uint8>(PlainText, 5), RandomKey).Num() == 0);
+	}
+
+	//Cipher backends
+	{
+		//FIPS-197 appendix C.1
+		const FUInt128Ex AESKey(0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL);
+		const uint8 AESPlain[] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff };
+		const uint8 AESExpected[] = { 0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30, 0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a };
+
+		for (int32 Hardware = 0; Hardware < 2; Hardware++)
+		{
+			TUniquePtr<ITinyEncryptCipher> AES = ITinyEncryptCipher::Create(ETinyEncryptCipher::AES128, AESKey, Hardware != 0);
+			TEST_TRUE_WITH_AUTONAME(AES->GetCipherType() == ETinyEncryptCipher::AES128);
+			TEST_TRUE_WITH_AUTONAME(AES->GetBlockSize() == 16);
+			TEST_TRUE_WITH_AUTONAME(AES->IsHardwareAccelerated() == (Hardware != 0 && ITinyEncryptCipher::IsHardwareAESSupported()));
+			TEST_TRUE_WITH_AUTONAME(AES->GetEncryptLength(16) == 32);
+			TEST_TRUE_WITH_AUTONAME(AES->GetEncryptLength(15) == 16);
+
+			//The first block has no padding
+			TEST_TRUE_WITH_AUTONAME(AES->Encrypt(AESPlain, 16, EncryptOutputBuff) == 32);
+			TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(EncryptOutputBuff, AESExpected, 16) == 0);
+			TEST_TRUE_WITH_AUTONAME(AES->Decrypt(EncryptOutputBuff, 32, DecryptOutputBuff) == 16);
+			TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(DecryptOutputBuff, AESPlain, 16) == 0);
+		}
+
+		//Both backends, software and hardware AES give the same result for all lengths
+		FUInt128Ex RandomKey;
+		RandomKey.MakeRandom();
+		TUniquePtr<ITinyEncryptCipher> Ciphers[] =
+		{
+			ITinyEncryptCipher::Create(ETinyEncryptCipher::TEA, RandomKey),
+			ITinyEncryptCipher::Create(ETinyEncryptCipher::AES128, RandomKey, false),
+			ITinyEncryptCipher::Create(ETinyEncryptCipher::AES128, RandomKey),
+		};
+		TEST_TRUE_WITH_AUTONAME(Ciphers[0]->GetBlockSize() == ITinyEncryptCipher::GetCipherBlockSize(ETinyEncryptCipher::TEA));
+
+		uint8 PlainBuff[150];
+		uint8 SoftwareBuff[MaxOutputLength];
+		for (int32 i = 0; i < 150; i++)
+		{
+			PlainBuff[i] = (uint8)(i * 5 + 1);
+		}
+		for (int32 Len = 0; Len <= 150; Len += 7)
+		{
+			for (int32 i = 0; i < 3; i++)
+			{
+				const TUniquePtr<ITinyEncryptCipher>& Cipher = Ciphers[i];
+				FMemory::Memcpy(EncryptOutputBuff, PlainBuff, Len);
+				const int32 EncryptLength = Cipher->Encrypt(EncryptOutputBuff, Len, EncryptOutputBuff);
+				TEST_TRUE_WITH_AUTONAME(EncryptLength == Cipher->GetEncryptLength(Len));
+				TEST_TRUE_WITH_AUTONAME(EncryptLength > Len && EncryptLength - Len <= Cipher->GetBlockSize());
+				if (i == 1)
+				{
+					FMemory::Memcpy(SoftwareBuff, EncryptOutputBuff, EncryptLength);
+				}
+				else if (i == 2)
+				{
+					TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(SoftwareBuff, EncryptOutputBuff, EncryptLength) == 0);
+				}
+				TEST_TRUE_WITH_AUTONAME(Cipher->Decrypt(EncryptOutputBuff, EncryptLength, EncryptOutputBuff) == Len);
+				TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(EncryptOutputBuff, PlainBuff, Len) == 0);
+			}
+		}
+
+		//Invalid length
+		for (const TUniquePtr<ITinyEncryptCipher>& Cipher : Ciphers)
+		{
+			TEST_TRUE_WITH_AUTONAME(Cipher->Decrypt(EncryptOutputBuff, 0, DecryptOutputBuff) == -1);
+			TEST_TRUE_WITH_AUTONAME(Cipher->Decrypt(EncryptOutputBuff, 12, DecryptOutputBuff) == -1);
+		}
+	}
+
+	//Compile-time encrypted literals
+	{
+		//Same output as FTinyEncrypt
+		const TinyEncryptLiteral::FKey Key = { 0x0123456789abcdefULL, 0xfedcba9876543210ULL };
+		constexpr auto Encrypted = TinyEncryptLiteral::Encrypt("Hello,World!", TinyEncryptLiteral::FKey{ 0x0123456789abcdefULL, 0xfedcba9876543210ULL });
+		static_assert(sizeof(Encrypted.Data) == 16, "13 bytes are padded to 16 bytes");
+		FTinyEncrypt SolidTEA(FUInt128Ex(Key.Hi, Key.Lo));
+		TEST_TRUE_WITH_AUTONAME(SolidTEA.Encrypt((const uint8*)"Hello,World!", 13, EncryptOutputBuff) == 16);
+		TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(EncryptOutputBuff, Encrypted.Data, 16) == 0);
+
+		//Decrypted once, the same buffer for every access
+		const char* Literal = GetTestLiteral();
+		TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(Literal, "Hello,World!", 13) == 0);
+		TEST_TRUE_WITH_AUTONAME(GetTestLiteral() == Literal);
+
+		const auto& WideLiteral = TINYENCRYPT_LITERAL(TEXT("https://example.com"));
+		TEST_TRUE_WITH_AUTONAME(WideLiteral.Len() == 19);
+		TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(*WideLiteral, TEXT("https://example.com"), sizeof(TCHAR) * 20) == 0);
+
+		const auto& BytesLiteral = TINYENCRYPT_LITERAL("\x12\x00\xff\x34");
+		const uint8 ExpectedBytes[] = { 0x12, 0x00, 0xff, 0x34 };
+		TEST_TRUE_WITH_AUTONAME(BytesLiteral.NumBytes() == 4);
+		TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(BytesLiteral.GetBytes(), ExpectedBytes, 4) == 0);
+	}
+
+	//Compress and encrypt pipeline
+	{
+		FUInt128Ex RandomKey;
+		RandomKey.MakeRandom();
+		FTinyEncryptCompression Pipeline(RandomKey, NAME_Zlib, 16 * 1024);
+
+		//Compressible text followed by random bytes
+		const int32 TextLen = 100 * 1024;
+		const int32 RandomLen = 50 * 1024 + 3;
+		TArray<uint8> Payload;
+		Payload.SetNumUninitialized(TextLen + RandomLen);
+		for (int32 i = 0; i < TextLen; i++)
+		{
+			Payload[i] = (uint8)("The quick brown fox jumps over the lazy dog. "[i % 45]);
+		}
+		for (int32 i = TextLen; i < Payload.Num(); i++)
+		{
+			Payload[i] = (uint8)FMath::RandRange(0, 0xFF);
+		}
+		TEST_TRUE_WITH_AUTONAME(FTinyEncryptCompression::IsLikelyCompressible(Payload.GetData(), TextLen));
+		TEST_TRUE_WITH_AUTONAME(!FTinyEncryptCompression::IsLikelyCompressible(Payload.GetData() + TextLen, RandomLen));
+
+		TArray<uint8> Packed;
+		TEST_TRUE_WITH_AUTONAME(Pipeline.CompressAndEncrypt(Payload.GetData(), Payload.Num(), Packed));
+		TEST_TRUE_WITH_AUTONAME(Packed.Num() < RandomLen + TextLen / 4);
+		TEST_TRUE_WITH_AUTONAME(Packed.Num() <= Pipeline.GetMaxEncodedLength(Payload.Num()));
+		TEST_TRUE_WITH_AUTONAME(FTinyEncryptCompression::GetDecodedLength(Packed.GetData(), Packed.Num()) == Payload.Num());
+
+		TArray<uint8> Unpacked;
+		TEST_TRUE_WITH_AUTONAME(Pipeline.DecryptAndDecompress(Packed.GetData(), Packed.Num(), Unpacked));
+		TEST_TRUE_WITH_AUTONAME(Unpacked == Payload);
+
+		//Caller-owned buffer is not enough
+		TEST_TRUE_WITH_AUTONAME(Pipeline.CompressAndEncrypt(Payload.GetData(), Payload.Num(), Packed.GetData(), 100) == -1);
+		TEST_TRUE_WITH_AUTONAME(Pipeline.DecryptAndDecompress(Packed.GetData(), Packed.Num(), Unpacked.GetData(), Payload.Num() - 1) == -1);
+
+		//Empty and small payloads
+		TEST_TRUE_WITH_AUTONAME(Pipeline.CompressAndEncrypt(nullptr, 0, Packed));
+		TEST_TRUE_WITH_AUTONAME(Packed.Num() == FTinyEncryptCompression::HeaderSize);
+		TEST_TRUE_WITH_AUTONAME(Pipeline.DecryptAndDecompress(Packed.GetData(), Packed.Num(), Unpacked) && Unpacked.Num() == 0);
+		TEST_TRUE_WITH_AUTONAME(Pipeline.CompressAndEncrypt(Payload.GetData(), 5, Packed));
+		TEST_TRUE_WITH_AUTONAME(Pipeline.DecryptAndDecompress(Packed.GetData(), Packed.Num(), Unpacked));
+		TEST_TRUE_WITH_AUTONAME(Unpacked.Num() == 5 && FMemory::Memcmp(Unpacked.GetData(), Payload.GetData(), 5) == 0);
+
+		//Wrong key, truncated data or a different block size
+		TEST_TRUE_WITH_AUTONAME(Pipeline.CompressAndEncrypt(Payload.GetData(), Payload.Num(), Packed));
+		FUInt128Ex AnotherKey;
+		AnotherKey.MakeRandom();
+		FTinyEncryptCompression AnotherPipeline(AnotherKey, NAME_Zlib, 16 * 1024);
+		TEST_TRUE_WITH_AUTONAME(!AnotherPipeline.DecryptAndDecompress(Packed.GetData(), Packed.Num(), Unpacked));
+		TEST_TRUE_WITH_AUTONAME(!Pipeline.DecryptAndDecompress(Packed.GetData(), Packed.Num() - 8, Unpacked));
+		FTinyEncryptCompression OtherBlockSize(RandomKey, NAME_Zlib, 32 * 1024);
+		TEST_TRUE_WITH_AUTONAME(!OtherBlockSize.DecryptAndDecompress(Packed.GetData(), Packed.Num(), Unpacked));
+
+		//A forged raw size larger than the blocks can hold is rejected before the output is allocated
+		uint8 ForgedHeader[FTinyEncryptCompression::HeaderSize + FTinyEncryptCompression::BlockHeaderSize + 8] = { 0xFF, 0xFF, 0xFF, 0x7F, 0x00, 0x40, 0x00, 0x00 };
+		TEST_TRUE_WITH_AUTONAME(FTinyEncryptCompression::GetDecodedLength(ForgedHeader, sizeof(ForgedHeader)) == -1);
+		TEST_TRUE_WITH_AUTONAME(!Pipeline.DecryptAndDecompress(ForgedHeader, sizeof(ForgedHeader), Unpacked) && Unpacked.Num() == 0);
+		ForgedHeader[0] = 0x00;
+		ForgedHeader[1] = 0x40;
+		ForgedHeader[2] = 0x00;
+		ForgedHeader[3] = 0x00;
+		TEST_TRUE_WITH_AUTONAME(FTinyEncryptCompression::GetDecodedLength(ForgedHeader, sizeof(ForgedHeader)) == 16 * 1024);
+		TEST_TRUE_WITH_AUTONAME(FTinyEncryptCompression::GetDecodedLength(ForgedHeader, sizeof(ForgedHeader) - 1) == -1);
+	}
+
+	//Buffer pool
+	{
+		TEST_TRUE_WITH_AUTONAME(FTinyEncryptBufferPool::GetSizeClass(0) == 0);
+		TEST_TRUE_WITH_AUTONAME(FTinyEncryptBufferPool::GetSizeClass(64) == 0);
+		TEST_TRUE_WITH_AUTONAME(FTinyEncryptBufferPool::GetSizeClass(65) == 1);
+		TEST_TRUE_WITH_AUTONAME(FTinyEncryptBufferPool::GetSizeClass(FTinyEncryptBufferPool::MaxPooledSize) == FTinyEncryptBufferPool::NumSizeClasses - 1);
+		TEST_TRUE_WITH_AUTONAME(FTinyEncryptBufferPool::GetSizeClass(FTinyEncryptBufferPool::MaxPooledSize + 1) == -1);
+
+		FTinyEncryptBufferPool& Pool = FTinyEncryptBufferPool::Get();
+		FTinyEncryptBuffer Buffer = Pool.Allocate(100);
+		TEST_TRUE_WITH_AUTONAME(Buffer.IsValid() && Buffer.Num() == 100 && Buffer.GetCapacity() == 128);
+		TEST_TRUE_WITH_AUTONAME(IsAligned(Buffer.GetData(), FTinyEncryptBufferPool::Alignment));
+
+		//The released buffer is reused by the same thread
+		const uint8* FirstData = Buffer.GetData();
+		Buffer.Reset();
+		TEST_TRUE_WITH_AUTONAME(!Buffer.IsValid());
+		Buffer = Pool.Allocate(120);
+		TEST_TRUE_WITH_AUTONAME(Buffer.GetData() == FirstData);
+
+		FTinyEncryptBuffer Moved = MoveTemp(Buffer);
+		TEST_TRUE_WITH_AUTONAME(!Buffer.IsValid() && Moved.GetData() == FirstData && Moved.Num() == 120);
+
+		//The used bytes are zeroed when the buffer goes back to the pool, including the bytes past a smaller length
+		FMemory::Memset(Moved.GetData(), 0xAB, 120);
+		Moved.SetNum(10);
+		Moved.Reset();
+		Buffer = Pool.Allocate(128);
+		TEST_TRUE_WITH_AUTONAME(Buffer.GetData() == FirstData);
+		for (int32 i = 0; i < 120; i++)
+		{
+			TEST_TRUE_WITH_AUTONAME(Buffer.GetData()[i] == 0);
+		}
+		Buffer.Reset();
+
+		//Large classes keep fewer buffers per thread
+		TEST_TRUE_WITH_AUTONAME(FTinyEncryptBufferPool::GetMaxThreadCached(0) == FTinyEncryptBufferPool::MaxThreadCached);
+		TEST_TRUE_WITH_AUTONAME(FTinyEncryptBufferPool::GetMaxThreadCached(FTinyEncryptBufferPool::NumSizeClasses - 1) == 1);
+		{
+			TArray<FTinyEncryptBuffer> LargeBuffers;
+			for (int32 i = 0; i < 4; i++)
+			{
+				LargeBuffers.Add(Pool.Allocate(FTinyEncryptBufferPool::MaxPooledSize));
+			}
+		}
+		//Trim frees the cache of the calling thread too, the pool still works after it
+		Buffer = Pool.Allocate(100);
+		Buffer.Reset();
+		Pool.Trim();
+		Buffer = Pool.Allocate(100);
+		TEST_TRUE_WITH_AUTONAME(Buffer.IsValid() && Buffer.Num() == 100);
+		Buffer.Reset();
+
+		//Not pooled
+		FTinyEncryptBuffer Large = Pool.Allocate(FTinyEncryptBufferPool::MaxPooledSize + 1);
+		TEST_TRUE_WITH_AUTONAME(Large.IsValid() && Large.GetCapacity() % 8 == 0);
+		TEST_TRUE_WITH_AUTONAME(IsAligned(Large.GetData(), FTinyEncryptBufferPool::Alignment));
+
+		//Many buffers go through the shared lists
+		TArray<FTinyEncryptBuffer> Buffers;
+		for (int32 i = 0; i < 100; i++)
+		{
+			Buffers.Add(Pool.Allocate(1000));
+		}
+		Buffers.Empty();
+		Pool.Trim();
+
+		//Pooled encryption
+		FUInt128Ex RandomKey;
+		RandomKey.MakeRandom();
+		FTinyEncrypt TEA(RandomKey);
+		const uint8* PlainText = (const uint8*)"Hello,World!";
+		FTinyEncryptBuffer Encrypted = TEA.EncryptPooled(PlainText, 12);
+		TEST_TRUE_WITH_AUTONAME(Encrypted.Num() == FTinyEncrypt::GetEncryptLength(12));
+		TEST_TRUE_WITH_AUTONAME(TEA.Encrypt(PlainText, 12, EncryptOutputBuff) == Encrypted.Num());
+		TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(EncryptOutputBuff, Encrypted.GetData(), Encrypted.Num()) == 0);
+
+		FTinyEncryptBuffer Decrypted = TEA.DecryptPooled(Encrypted.GetData(), Encrypted.Num());
+		TEST_TRUE_WITH_AUTONAME(Decrypted.Num() == 12 && FMemory::Memcmp(Decrypted.GetData(), PlainText, 12) == 0);
+		TEST_TRUE_WITH_AUTONAME(!TEA.DecryptPooled(Encrypted.GetData(), 7).IsValid());
+	}
 	return true;
 }
 
@@ -0,0 +1,112 @@
+// Copyright (C) 2024 Neo Jin. All Rights Reserved.
+#include "TinyEncryptWorker.h"
+#include "TinyEncryptAlgorithm.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/Paths.h"
+#include "AutomationTest/TinyEncryptAutomationTestInterface.h"
+#include "Misc/AutomationTest.h"
+#include "Runtime/Launch/Resources/Version.h"
+
+#if !UE_BUILD_SHIPPING
+
+bool TestTinyEncryptWorker(FString& Detail)
+{
+	FUInt128Ex RandomKey;
+	RandomKey.MakeRandom();
+	FTinyEncrypt TEA(RandomKey);
+
+	uint8 MessageData[64];
+	for (int32 i = 0; i < 64; i++)
+	{
+		MessageData[i] = (uint8)(i * 3 + 1);
+	}
+
+	//Small rings, so the worker has to wait for the consumer
+	FTinyEncryptWorker Worker(8);
+
+	const int32 JobCounts = 100;
+	int32 Enqueued = 0;
+	int32 Completed = 0;
+	FTinyEncryptJob PendingDecrypt;
+	bool bHasPendingDecrypt = false;
+	double StartTime = FPlatformTime::Seconds();
+	while (Completed < JobCounts)
+	{
+		if (Enqueued < JobCounts)
+		{
+			FTinyEncryptJob Job;
+			Job.TEA = &TEA;
+			Job.Data.Append(MessageData, Enqueued % 64);
+			Job.UserData = (uint64)Enqueued;
+			if (Worker.EnqueueEncrypt(MoveTemp(Job)))
+			{
+				Enqueued++;
+			}
+		}
+
+		//Encrypted data goes back to the inbound direction
+		if (!bHasPendingDecrypt && Worker.DequeueEncrypted(PendingDecrypt))
+		{
+			const int32 Index = (int32)PendingDecrypt.UserData;
+			TEST_TRUE_WITH_AUTONAME(PendingDecrypt.Result == FTinyEncrypt::GetEncryptLength(Index % 64));
+			TEST_TRUE_WITH_AUTONAME(PendingDecrypt.Data.Num() == PendingDecrypt.Result);
+
+			uint8 ExpectBuff[72];
+			TEA.Encrypt(MessageData, Index % 64, ExpectBuff);
+			TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(PendingDecrypt.Data.GetData(), ExpectBuff, PendingDecrypt.Result) == 0);
+
+			//Tamper the length of one job
+			if (Index == 7)
+			{
+				PendingDecrypt.Data.SetNum(5);
+			}
+			bHasPendingDecrypt = true;
+		}
+		if (bHasPendingDecrypt && Worker.EnqueueDecrypt(MoveTemp(PendingDecrypt)))
+		{
+			bHasPendingDecrypt = false;
+		}
+
+		FTinyEncryptJob Decrypted;
+		while (Worker.DequeueDecrypted(Decrypted))
+		{
+			//Same order as requests
+			const int32 Index = (int32)Decrypted.UserData;
+			TEST_TRUE_WITH_AUTONAME(Index == Completed);
+			if (Index == 7)
+			{
+				TEST_TRUE_WITH_AUTONAME(Decrypted.Result == -1);
+			}
+			else
+			{
+				TEST_TRUE_WITH_AUTONAME(Decrypted.Result == Index % 64);
+				TEST_TRUE_WITH_AUTONAME(Decrypted.Data.Num() == Index % 64);
+				TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(Decrypted.Data.GetData(), MessageData, Index % 64) == 0);
+			}
+			Completed++;
+		}
+
+		//Don't hang forever
+		TEST_TRUE_WITH_AUTONAME(FPlatformTime::Seconds() - StartTime < 30.0);
+	}
+	return true;
+}
+
+#endif //!UE_BUILD_SHIPPING
+
+#if WITH_DEV_AUTOMATION_TESTS && !UE_BUILD_SHIPPING
+
+#if (ENGINE_MAJOR_VERSION >= 5 && ENGINE_MINOR_VERSION >= 5)
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST(FTinyEncryptTestWorker, FAutomationTestBase, "TinyEncrypt.Worker", EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+#else
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST(FTinyEncryptTestWorker, FAutomationTestBase, "TinyEncrypt.Worker", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+#endif
+bool FTinyEncryptTestWorker::RunTest(const FString& Parameters)
+{
+	FString Detail;
+	bool bSuccess = TestTinyEncryptWorker(Detail);
+	TestTrue(Detail, bSuccess);
+	return true;
+}
+
+#endif
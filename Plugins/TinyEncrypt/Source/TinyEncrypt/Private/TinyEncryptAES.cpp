@@ -0,0 +1,428 @@
+// Copyright (C) 2024 Neo Jin. All Rights Reserved.
+#include "TinyEncryptAES.h"
+
+#if PLATFORM_CPU_X86_FAMILY
+	#define TINYENCRYPT_AES_X86 1
+	#include <emmintrin.h>
+	#include <wmmintrin.h>
+	#if defined(_MSC_VER) && !defined(__clang__)
+		#include <intrin.h>
+		#define TINYENCRYPT_AES_TARGET
+	#else
+		#include <cpuid.h>
+		#define TINYENCRYPT_AES_TARGET __attribute__((target("aes,sse2")))
+	#endif
+#else
+	#define TINYENCRYPT_AES_X86 0
+#endif
+
+#if PLATFORM_CPU_ARM_FAMILY && (defined(__ARM_FEATURE_AES) || defined(__ARM_FEATURE_CRYPTO))
+	//The whole target is compiled with the crypto extension(e.g. Apple arm64)
+	#define TINYENCRYPT_AES_ARM 1
+	#define TINYENCRYPT_AES_ARM_RUNTIME 0
+	#define TINYENCRYPT_AES_ARM_TARGET
+	#include <arm_neon.h>
+#elif PLATFORM_CPU_ARM_FAMILY && defined(__aarch64__) && (PLATFORM_LINUX || PLATFORM_ANDROID)
+	//Only the kernels are compiled with the crypto extension, they are used if HWCAP reports it at runtime
+	#define TINYENCRYPT_AES_ARM 1
+	#define TINYENCRYPT_AES_ARM_RUNTIME 1
+	#if defined(__clang__)
+		#define TINYENCRYPT_AES_ARM_TARGET __attribute__((target("aes")))
+	#else
+		#define TINYENCRYPT_AES_ARM_TARGET __attribute__((target("+crypto")))
+	#endif
+	#include <arm_neon.h>
+	#include <sys/auxv.h>
+	#ifndef HWCAP_AES
+		#define HWCAP_AES (1 << 3)
+	#endif
+#else
+	#define TINYENCRYPT_AES_ARM 0
+	#define TINYENCRYPT_AES_ARM_RUNTIME 0
+#endif
+
+namespace TinyEncryptAES
+{
+	static const uint8 SBox[256] =
+	{
+		0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+		0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
+		0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+		0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
+		0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
+		0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+		0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
+		0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
+		0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+		0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
+		0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+		0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+		0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
+		0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
+		0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+		0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16,
+	};
+
+	static const uint8 InvSBox[256] =
+	{
+		0x52, 0x09, 0x6a, 0xd5, 0x30, 0x36, 0xa5, 0x38, 0xbf, 0x40, 0xa3, 0x9e, 0x81, 0xf3, 0xd7, 0xfb,
+		0x7c, 0xe3, 0x39, 0x82, 0x9b, 0x2f, 0xff, 0x87, 0x34, 0x8e, 0x43, 0x44, 0xc4, 0xde, 0xe9, 0xcb,
+		0x54, 0x7b, 0x94, 0x32, 0xa6, 0xc2, 0x23, 0x3d, 0xee, 0x4c, 0x95, 0x0b, 0x42, 0xfa, 0xc3, 0x4e,
+		0x08, 0x2e, 0xa1, 0x66, 0x28, 0xd9, 0x24, 0xb2, 0x76, 0x5b, 0xa2, 0x49, 0x6d, 0x8b, 0xd1, 0x25,
+		0x72, 0xf8, 0xf6, 0x64, 0x86, 0x68, 0x98, 0x16, 0xd4, 0xa4, 0x5c, 0xcc, 0x5d, 0x65, 0xb6, 0x92,
+		0x6c, 0x70, 0x48, 0x50, 0xfd, 0xed, 0xb9, 0xda, 0x5e, 0x15, 0x46, 0x57, 0xa7, 0x8d, 0x9d, 0x84,
+		0x90, 0xd8, 0xab, 0x00, 0x8c, 0xbc, 0xd3, 0x0a, 0xf7, 0xe4, 0x58, 0x05, 0xb8, 0xb3, 0x45, 0x06,
+		0xd0, 0x2c, 0x1e, 0x8f, 0xca, 0x3f, 0x0f, 0x02, 0xc1, 0xaf, 0xbd, 0x03, 0x01, 0x13, 0x8a, 0x6b,
+		0x3a, 0x91, 0x11, 0x41, 0x4f, 0x67, 0xdc, 0xea, 0x97, 0xf2, 0xcf, 0xce, 0xf0, 0xb4, 0xe6, 0x73,
+		0x96, 0xac, 0x74, 0x22, 0xe7, 0xad, 0x35, 0x85, 0xe2, 0xf9, 0x37, 0xe8, 0x1c, 0x75, 0xdf, 0x6e,
+		0x47, 0xf1, 0x1a, 0x71, 0x1d, 0x29, 0xc5, 0x89, 0x6f, 0xb7, 0x62, 0x0e, 0xaa, 0x18, 0xbe, 0x1b,
+		0xfc, 0x56, 0x3e, 0x4b, 0xc6, 0xd2, 0x79, 0x20, 0x9a, 0xdb, 0xc0, 0xfe, 0x78, 0xcd, 0x5a, 0xf4,
+		0x1f, 0xdd, 0xa8, 0x33, 0x88, 0x07, 0xc7, 0x31, 0xb1, 0x12, 0x10, 0x59, 0x27, 0x80, 0xec, 0x5f,
+		0x60, 0x51, 0x7f, 0xa9, 0x19, 0xb5, 0x4a, 0x0d, 0x2d, 0xe5, 0x7a, 0x9f, 0x93, 0xc9, 0x9c, 0xef,
+		0xa0, 0xe0, 0x3b, 0x4d, 0xae, 0x2a, 0xf5, 0xb0, 0xc8, 0xeb, 0xbb, 0x3c, 0x83, 0x53, 0x99, 0x61,
+		0x17, 0x2b, 0x04, 0x7e, 0xba, 0x77, 0xd6, 0x26, 0xe1, 0x69, 0x14, 0x63, 0x55, 0x21, 0x0c, 0x7d,
+	};
+
+	static const uint8 RoundConstants[NumRounds] = { 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1b, 0x36 };
+
+	FORCEINLINE uint8 XTime(uint8 Value)
+	{
+		return (uint8)((Value << 1) ^ ((Value & 0x80) ? 0x1b : 0x00));
+	}
+
+	//Multiply in GF(2^8)
+	FORCEINLINE uint8 Multiply(uint8 A, uint8 B)
+	{
+		uint8 Result = 0;
+		while (B != 0)
+		{
+			if (B & 1)
+			{
+				Result ^= A;
+			}
+			A = XTime(A);
+			B >>= 1;
+		}
+		return Result;
+	}
+
+	//The state is column major, State[Row + Column * 4]
+	FORCEINLINE void AddRoundKey(uint8* State, const uint8* RoundKey)
+	{
+		for (int32 i = 0; i < BlockSize; ++i)
+		{
+			State[i] ^= RoundKey[i];
+		}
+	}
+
+	FORCEINLINE void SubBytesShiftRows(uint8* State)
+	{
+		uint8 Temp[BlockSize];
+		for (int32 i = 0; i < BlockSize; ++i)
+		{
+			const int32 Row = i & 3;
+			const int32 Column = i >> 2;
+			Temp[i] = SBox[State[Row + ((Column + Row) & 3) * 4]];
+		}
+		FMemory::Memcpy(State, Temp, BlockSize);
+	}
+
+	FORCEINLINE void InvSubBytesShiftRows(uint8* State)
+	{
+		uint8 Temp[BlockSize];
+		for (int32 i = 0; i < BlockSize; ++i)
+		{
+			const int32 Row = i & 3;
+			const int32 Column = i >> 2;
+			Temp[Row + ((Column + Row) & 3) * 4] = InvSBox[State[i]];
+		}
+		FMemory::Memcpy(State, Temp, BlockSize);
+	}
+
+	FORCEINLINE void MixColumns(uint8* State)
+	{
+		for (int32 Column = 0; Column < 4; ++Column)
+		{
+			uint8* C = State + Column * 4;
+			const uint8 A0 = C[0], A1 = C[1], A2 = C[2], A3 = C[3];
+			const uint8 All = A0 ^ A1 ^ A2 ^ A3;
+			C[0] ^= All ^ XTime(A0 ^ A1);
+			C[1] ^= All ^ XTime(A1 ^ A2);
+			C[2] ^= All ^ XTime(A2 ^ A3);
+			C[3] ^= All ^ XTime(A3 ^ A0);
+		}
+	}
+
+	FORCEINLINE void InvMixColumns(uint8* State)
+	{
+		for (int32 Column = 0; Column < 4; ++Column)
+		{
+			uint8* C = State + Column * 4;
+			const uint8 A0 = C[0], A1 = C[1], A2 = C[2], A3 = C[3];
+			C[0] = Multiply(A0, 14) ^ Multiply(A1, 11) ^ Multiply(A2, 13) ^ Multiply(A3, 9);
+			C[1] = Multiply(A0, 9) ^ Multiply(A1, 14) ^ Multiply(A2, 11) ^ Multiply(A3, 13);
+			C[2] = Multiply(A0, 13) ^ Multiply(A1, 9) ^ Multiply(A2, 14) ^ Multiply(A3, 11);
+			C[3] = Multiply(A0, 11) ^ Multiply(A1, 13) ^ Multiply(A2, 9) ^ Multiply(A3, 14);
+		}
+	}
+
+	//Table lookups indexed by the secret state, not constant-time, see the header
+	static void EncryptBlockSoftware(const FKeySchedule& Schedule, const uint8* In, uint8* Out)
+	{
+		uint8 State[BlockSize];
+		FMemory::Memcpy(State, In, BlockSize);
+
+		AddRoundKey(State, Schedule.EncryptKeys);
+		for (int32 Round = 1; Round < NumRounds; ++Round)
+		{
+			SubBytesShiftRows(State);
+			MixColumns(State);
+			AddRoundKey(State, Schedule.EncryptKeys + Round * BlockSize);
+		}
+		SubBytesShiftRows(State);
+		AddRoundKey(State, Schedule.EncryptKeys + NumRounds * BlockSize);
+
+		FMemory::Memcpy(Out, State, BlockSize);
+	}
+
+	static void DecryptBlockSoftware(const FKeySchedule& Schedule, const uint8* In, uint8* Out)
+	{
+		uint8 State[BlockSize];
+		FMemory::Memcpy(State, In, BlockSize);
+
+		AddRoundKey(State, Schedule.EncryptKeys + NumRounds * BlockSize);
+		for (int32 Round = NumRounds - 1; Round > 0; --Round)
+		{
+			InvSubBytesShiftRows(State);
+			AddRoundKey(State, Schedule.EncryptKeys + Round * BlockSize);
+			InvMixColumns(State);
+		}
+		InvSubBytesShiftRows(State);
+		AddRoundKey(State, Schedule.EncryptKeys);
+
+		FMemory::Memcpy(Out, State, BlockSize);
+	}
+
+#if TINYENCRYPT_AES_X86
+	//4 blocks in flight to hide the latency of the AES instructions
+	static constexpr int32 Lanes = 4;
+
+	TINYENCRYPT_AES_TARGET static void EncryptBlocksX86(const FKeySchedule& Schedule, const uint8* In, uint8* Out, int32 NumBlocks)
+	{
+		__m128i Keys[NumRounds + 1];
+		for (int32 i = 0; i <= NumRounds; ++i)
+		{
+			Keys[i] = _mm_load_si128((const __m128i*)(Schedule.EncryptKeys + i * BlockSize));
+		}
+
+		int32 Block = 0;
+		for (; Block + Lanes <= NumBlocks; Block += Lanes)
+		{
+			__m128i State[Lanes];
+			for (int32 Lane = 0; Lane < Lanes; ++Lane)
+			{
+				State[Lane] = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(In + (Block + Lane) * BlockSize)), Keys[0]);
+			}
+			for (int32 Round = 1; Round < NumRounds; ++Round)
+			{
+				for (int32 Lane = 0; Lane < Lanes; ++Lane)
+				{
+					State[Lane] = _mm_aesenc_si128(State[Lane], Keys[Round]);
+				}
+			}
+			for (int32 Lane = 0; Lane < Lanes; ++Lane)
+			{
+				_mm_storeu_si128((__m128i*)(Out + (Block + Lane) * BlockSize), _mm_aesenclast_si128(State[Lane], Keys[NumRounds]));
+			}
+		}
+		for (; Block < NumBlocks; ++Block)
+		{
+			__m128i State = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(In + Block * BlockSize)), Keys[0]);
+			for (int32 Round = 1; Round < NumRounds; ++Round)
+			{
+				State = _mm_aesenc_si128(State, Keys[Round]);
+			}
+			_mm_storeu_si128((__m128i*)(Out + Block * BlockSize), _mm_aesenclast_si128(State, Keys[NumRounds]));
+		}
+	}
+
+	TINYENCRYPT_AES_TARGET static void DecryptBlocksX86(const FKeySchedule& Schedule, const uint8* In, uint8* Out, int32 NumBlocks)
+	{
+		__m128i Keys[NumRounds + 1];
+		for (int32 i = 0; i <= NumRounds; ++i)
+		{
+			Keys[i] = _mm_load_si128((const __m128i*)(Schedule.DecryptKeys + i * BlockSize));
+		}
+
+		int32 Block = 0;
+		for (; Block + Lanes <= NumBlocks; Block += Lanes)
+		{
+			__m128i State[Lanes];
+			for (int32 Lane = 0; Lane < Lanes; ++Lane)
+			{
+				State[Lane] = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(In + (Block + Lane) * BlockSize)), Keys[0]);
+			}
+			for (int32 Round = 1; Round < NumRounds; ++Round)
+			{
+				for (int32 Lane = 0; Lane < Lanes; ++Lane)
+				{
+					State[Lane] = _mm_aesdec_si128(State[Lane], Keys[Round]);
+				}
+			}
+			for (int32 Lane = 0; Lane < Lanes; ++Lane)
+			{
+				_mm_storeu_si128((__m128i*)(Out + (Block + Lane) * BlockSize), _mm_aesdeclast_si128(State[Lane], Keys[NumRounds]));
+			}
+		}
+		for (; Block < NumBlocks; ++Block)
+		{
+			__m128i State = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(In + Block * BlockSize)), Keys[0]);
+			for (int32 Round = 1; Round < NumRounds; ++Round)
+			{
+				State = _mm_aesdec_si128(State, Keys[Round]);
+			}
+			_mm_storeu_si128((__m128i*)(Out + Block * BlockSize), _mm_aesdeclast_si128(State, Keys[NumRounds]));
+		}
+	}
+#endif
+
+#if TINYENCRYPT_AES_ARM
+	TINYENCRYPT_AES_ARM_TARGET static void EncryptBlocksARM(const FKeySchedule& Schedule, const uint8* In, uint8* Out, int32 NumBlocks)
+	{
+		uint8x16_t Keys[NumRounds + 1];
+		for (int32 i = 0; i <= NumRounds; ++i)
+		{
+			Keys[i] = vld1q_u8(Schedule.EncryptKeys + i * BlockSize);
+		}
+
+		for (int32 Block = 0; Block < NumBlocks; ++Block)
+		{
+			uint8x16_t State = vld1q_u8(In + Block * BlockSize);
+			for (int32 Round = 0; Round < NumRounds - 1; ++Round)
+			{
+				State = vaesmcq_u8(vaeseq_u8(State, Keys[Round]));
+			}
+			State = veorq_u8(vaeseq_u8(State, Keys[NumRounds - 1]), Keys[NumRounds]);
+			vst1q_u8(Out + Block * BlockSize, State);
+		}
+	}
+
+	TINYENCRYPT_AES_ARM_TARGET static void DecryptBlocksARM(const FKeySchedule& Schedule, const uint8* In, uint8* Out, int32 NumBlocks)
+	{
+		uint8x16_t Keys[NumRounds + 1];
+		for (int32 i = 0; i <= NumRounds; ++i)
+		{
+			Keys[i] = vld1q_u8(Schedule.DecryptKeys + i * BlockSize);
+		}
+
+		for (int32 Block = 0; Block < NumBlocks; ++Block)
+		{
+			uint8x16_t State = vld1q_u8(In + Block * BlockSize);
+			for (int32 Round = 0; Round < NumRounds - 1; ++Round)
+			{
+				State = vaesimcq_u8(vaesdq_u8(State, Keys[Round]));
+			}
+			State = veorq_u8(vaesdq_u8(State, Keys[NumRounds - 1]), Keys[NumRounds]);
+			vst1q_u8(Out + Block * BlockSize, State);
+		}
+	}
+#endif
+
+	void ExpandKey(const FUInt128Ex& Key, FKeySchedule& OutSchedule)
+	{
+		uint8* Words = OutSchedule.EncryptKeys;
+		Key.WriteBytes(Words);
+
+		for (int32 i = 4; i < (NumRounds + 1) * 4; ++i)
+		{
+			uint8 Temp[4] = { Words[(i - 1) * 4], Words[(i - 1) * 4 + 1], Words[(i - 1) * 4 + 2], Words[(i - 1) * 4 + 3] };
+			if ((i & 3) == 0)
+			{
+				//RotWord, SubWord, Rcon
+				const uint8 First = Temp[0];
+				Temp[0] = SBox[Temp[1]] ^ RoundConstants[i / 4 - 1];
+				Temp[1] = SBox[Temp[2]];
+				Temp[2] = SBox[Temp[3]];
+				Temp[3] = SBox[First];
+			}
+			for (int32 j = 0; j < 4; ++j)
+			{
+				Words[i * 4 + j] = Words[(i - 4) * 4 + j] ^ Temp[j];
+			}
+		}
+
+		//Equivalent inverse cipher keys: reversed order, InvMixColumns on the middle rounds
+		for (int32 Round = 0; Round <= NumRounds; ++Round)
+		{
+			uint8* DecryptKey = OutSchedule.DecryptKeys + Round * BlockSize;
+			FMemory::Memcpy(DecryptKey, OutSchedule.EncryptKeys + (NumRounds - Round) * BlockSize, BlockSize);
+			if (Round > 0 && Round < NumRounds)
+			{
+				InvMixColumns(DecryptKey);
+			}
+		}
+	}
+
+	bool IsHardwareSupported()
+	{
+#if TINYENCRYPT_AES_X86
+		static const bool bSupported = []()
+		{
+	#if defined(_MSC_VER) && !defined(__clang__)
+			int32 Info[4];
+			__cpuid(Info, 1);
+			return (Info[2] & (1 << 25)) != 0;
+	#else
+			unsigned int A, B, C, D;
+			return __get_cpuid(1, &A, &B, &C, &D) != 0 && (C & (1u << 25)) != 0;
+	#endif
+		}();
+		return bSupported;
+#elif TINYENCRYPT_AES_ARM_RUNTIME
+		static const bool bSupported = (getauxval(AT_HWCAP) & HWCAP_AES) != 0;
+		return bSupported;
+#elif TINYENCRYPT_AES_ARM
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	void EncryptBlocks(const FKeySchedule& Schedule, bool bHardware, const uint8* In, uint8* Out, int32 NumBlocks)
+	{
+		if (bHardware)
+		{
+#if TINYENCRYPT_AES_X86
+			EncryptBlocksX86(Schedule, In, Out, NumBlocks);
+			return;
+#elif TINYENCRYPT_AES_ARM
+			EncryptBlocksARM(Schedule, In, Out, NumBlocks);
+			return;
+#endif
+		}
+
+		for (int32 Block = 0; Block < NumBlocks; ++Block)
+		{
+			EncryptBlockSoftware(Schedule, In + Block * BlockSize, Out + Block * BlockSize);
+		}
+	}
+
+	void DecryptBlocks(const FKeySchedule& Schedule, bool bHardware, const uint8* In, uint8* Out, int32 NumBlocks)
+	{
+		if (bHardware)
+		{
+#if TINYENCRYPT_AES_X86
+			DecryptBlocksX86(Schedule, In, Out, NumBlocks);
+			return;
+#elif TINYENCRYPT_AES_ARM
+			DecryptBlocksARM(Schedule, In, Out, NumBlocks);
+			return;
+#endif
+		}
+
+		for (int32 Block = 0; Block < NumBlocks; ++Block)
+		{
+			DecryptBlockSoftware(Schedule, In + Block * BlockSize, Out + Block * BlockSize);
+		}
+	}
+}
@@ -0,0 +1,39 @@
+// Copyright (C) 2024 Neo Jin. All Rights Reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TinyEncryptKeyExchange.h"
+
+/*
+AES-128 block kernels of `ITinyEncryptCipher`.
+
+Uses AES-NI on x86 CPUs which support it(checked with cpuid at runtime), the ARMv8 crypto extension when the target
+is compiled with it or HWCAP reports it at runtime(Linux/Android arm64), and a portable software implementation
+otherwise. All of them give the same result.
+
+The software implementation uses S-box table lookups indexed by the secret state, it is NOT constant-time: the key can
+leak through cache timing to code which shares the CPU. Use TEA or check `IsHardwareSupported` when that matters.
+*/
+namespace TinyEncryptAES
+{
+	static constexpr int32 BlockSize = 16;
+	static constexpr int32 NumRounds = 10;
+	static constexpr int32 RoundKeysSize = (NumRounds + 1) * BlockSize;
+
+	struct FKeySchedule
+	{
+		alignas(16) uint8 EncryptKeys[RoundKeysSize];
+		//Round keys of the equivalent inverse cipher(reversed, InvMixColumns applied), used by the hardware kernels
+		alignas(16) uint8 DecryptKeys[RoundKeysSize];
+	};
+
+	//The key bytes are `FUInt128Ex::WriteBytes` of the key(big endian)
+	void ExpandKey(const FUInt128Ex& Key, FKeySchedule& OutSchedule);
+
+	//True if the hardware kernels can be used on this CPU
+	bool IsHardwareSupported();
+
+	//Encrypt/Decrypt NumBlocks blocks, In and Out can be the same buffer
+	void EncryptBlocks(const FKeySchedule& Schedule, bool bHardware, const uint8* In, uint8* Out, int32 NumBlocks);
+	void DecryptBlocks(const FKeySchedule& Schedule, bool bHardware, const uint8* In, uint8* Out, int32 NumBlocks);
+}
@@ -1,5 +1,6 @@
 // Copyright (C) 2024 Neo Jin. All Rights Reserved.
 #include "TinyEncryptAlgorithm.h"
+#include "TinyEncryptBlock.h"
 
 FTinyEncrypt::FTinyEncrypt(const FUInt128Ex& _Key)
 {
@@ -20,7 +21,7 @@ int32 FTinyEncrypt::GetDecryptLength(int32 InLen)
 	return InLen;
 }
 
-void FTinyEncrypt::EncryptBlock(const uint8* InBuf, uint8* OutBuf)
+void FTinyEncrypt::EncryptBlock(const uint8* InBuf, uint8* OutBuf) const
 {
 	static const uint32 Delta = 0x9E3779B9;	//(sqrt(5)-1)/2*2^32
 
@@ -50,7 +51,7 @@ void FTinyEncrypt::EncryptBlock(const uint8* InBuf, uint8* OutBuf)
 	OutBuf[7] = (uint8)(o4 & 0xFF);
 }
 
-void FTinyEncrypt::DecryptBlock(const uint8* InBuf, uint8* OutBuf)
+void FTinyEncrypt::DecryptBlock(const uint8* InBuf, uint8* OutBuf) const
 {
 	static const uint32 Delta = 0x9E3779B9;	//A key of schedule constant: (sqrt(5)-1)*2^31
 	uint32 Sum = Delta * 32;
@@ -80,7 +81,7 @@ void FTinyEncrypt::DecryptBlock(const uint8* InBuf, uint8* OutBuf)
 	OutBuf[7] = (uint8)(o4 & 0xFF);
 }
 
-int32 FTinyEncrypt::Encrypt(const uint8* InBuf, int32 InLen, uint8* OutBuf)
+int32 FTinyEncrypt::Encrypt(const uint8* InBuf, int32 InLen, uint8* OutBuf) const
 {
 	int32 BlockCounts = InLen / 8;
 	int32 BlockBytes = BlockCounts * 8;
@@ -104,7 +105,7 @@ int32 FTinyEncrypt::Encrypt(const uint8* InBuf, int32 InLen, uint8* OutBuf)
 	return BlockBytes + 8;
 }
 
-int32 FTinyEncrypt::Decrypt(const uint8* InBuf, int32 InLen, uint8* OutBuf)
+int32 FTinyEncrypt::Decrypt(const uint8* InBuf, int32 InLen, uint8* OutBuf) const
 {
 	int32 BlockCounts = InLen / 8;
 	int32 BlockBytes = (BlockCounts - 1) * 8;
@@ -125,3 +126,530 @@ int32 FTinyEncrypt::Decrypt(const uint8* InBuf, int32 InLen, uint8* OutBuf)
 	}
 	return BlockBytes + (8 - PadLen);
 }
+
+int64 FTinyEncrypt::GetEncryptLength64(int64 InLen)
+{
+	return (InLen / 8) * 8 + 8;
+}
+
+int64 FTinyEncrypt::GetDecryptLength64(int64 InLen)
+{
+	return InLen;
+}
+
+int64 FTinyEncrypt::Encrypt64(const uint8* InBuf, int64 InLen, uint8* OutBuf) const
+{
+	using namespace TinyEncryptBlock;
+
+	uint32 Schedule[ScheduleSize];
+	MakeSchedule(Key, Schedule);
+
+	const int64 BlockBytes = (InLen / BlockSize) * BlockSize;
+	EncryptBlocks64(Schedule, InBuf, OutBuf, BlockBytes / BlockSize);
+
+	return BlockBytes + EncryptWithPadding(Schedule, InBuf + BlockBytes, (int32)(InLen - BlockBytes), OutBuf + BlockBytes);
+}
+
+int64 FTinyEncrypt::Decrypt64(const uint8* InBuf, int64 InLen, uint8* OutBuf) const
+{
+	using namespace TinyEncryptBlock;
+
+	if (InLen <= 0 || (InLen % BlockSize) != 0)
+	{
+		return -1;
+	}
+
+	uint32 Schedule[ScheduleSize];
+	MakeSchedule(Key, Schedule);
+
+	const int64 BlockBytes = InLen - BlockSize;
+	DecryptBlocks64(Schedule, InBuf, OutBuf, BlockBytes / BlockSize);
+
+	const int32 TailLen = DecryptWithPadding(Schedule, InBuf + BlockBytes, BlockSize, OutBuf + BlockBytes);
+	return (TailLen < 0) ? -1 : BlockBytes + TailLen;
+}
+
+void FTinyEncrypt::EncryptBlocks(const uint8* InBuf, uint8* OutBuf, int64 NumBlocks) const
+{
+	uint32 Schedule[TinyEncryptBlock::ScheduleSize];
+	TinyEncryptBlock::MakeSchedule(Key, Schedule);
+	TinyEncryptBlock::EncryptBlocks64(Schedule, InBuf, OutBuf, NumBlocks);
+}
+
+void FTinyEncrypt::DecryptBlocks(const uint8* InBuf, uint8* OutBuf, int64 NumBlocks) const
+{
+	uint32 Schedule[TinyEncryptBlock::ScheduleSize];
+	TinyEncryptBlock::MakeSchedule(Key, Schedule);
+	TinyEncryptBlock::DecryptBlocks64(Schedule, InBuf, OutBuf, NumBlocks);
+}
+
+int32 FTinyEncrypt::EncryptTail(const uint8* InBuf, int32 InLen, uint8* OutBuf) const
+{
+	check(InLen >= 0 && InLen < BlockSize);
+
+	uint32 Schedule[TinyEncryptBlock::ScheduleSize];
+	TinyEncryptBlock::MakeSchedule(Key, Schedule);
+	return TinyEncryptBlock::EncryptWithPadding(Schedule, InBuf, InLen, OutBuf);
+}
+
+int32 FTinyEncrypt::DecryptTail(const uint8* InBuf, uint8* OutBuf) const
+{
+	uint32 Schedule[TinyEncryptBlock::ScheduleSize];
+	TinyEncryptBlock::MakeSchedule(Key, Schedule);
+	return TinyEncryptBlock::DecryptWithPadding(Schedule, InBuf, BlockSize, OutBuf);
+}
+
+FTinyEncryptBuffer FTinyEncrypt::EncryptPooled(const uint8* InBuf, int32 InLen) const
+{
+	FTinyEncryptBuffer Buffer = FTinyEncryptBufferPool::Get().Allocate(GetEncryptLength(InLen));
+	Encrypt64(InBuf, InLen, Buffer.GetData());
+	return Buffer;
+}
+
+FTinyEncryptBuffer FTinyEncrypt::DecryptPooled(const uint8* InBuf, int32 InLen) const
+{
+	FTinyEncryptBuffer Buffer = FTinyEncryptBufferPool::Get().Allocate(GetDecryptLength(InLen));
+	const int64 OutLen = Decrypt64(InBuf, InLen, Buffer.GetData());
+	if (OutLen < 0)
+	{
+		Buffer.Reset();
+	}
+	else
+	{
+		Buffer.SetNum((int32)OutLen);
+	}
+	return Buffer;
+}
+
+int32 FTinyEncrypt::GetEncryptLengthCTS(int32 InLen)
+{
+	return (InLen < 8) ? -1 : InLen;
+}
+
+int32 FTinyEncrypt::GetDecryptLengthCTS(int32 InLen)
+{
+	return (InLen < 8) ? -1 : InLen;
+}
+
+int32 FTinyEncrypt::EncryptCTS(const uint8* InBuf, int32 InLen, uint8* OutBuf) const
+{
+	if (InLen < 8)
+	{
+		return -1;
+	}
+
+	int32 BlockCounts = InLen / 8;
+	int32 TailLen = InLen - BlockCounts * 8;
+	if (TailLen == 0)
+	{
+		for (int32 i = 0; i < InLen; i += 8)
+		{
+			EncryptBlock(InBuf + i, OutBuf + i);
+		}
+		return InLen;
+	}
+
+	int32 LastBlockPos = (BlockCounts - 1) * 8;
+	for (int32 i = 0; i < LastBlockPos; i += 8)
+	{
+		EncryptBlock(InBuf + i, OutBuf + i);
+	}
+
+	//Encrypt the last full block, its tail is stolen to pad the last partial block
+	uint8 LastBlock[8];
+	EncryptBlock(InBuf + LastBlockPos, LastBlock);
+
+	uint8 TailBuff[8];
+	FMemory::Memcpy(TailBuff, InBuf + LastBlockPos + 8, TailLen);
+	FMemory::Memcpy(TailBuff + TailLen, LastBlock + TailLen, 8 - TailLen);
+
+	EncryptBlock(TailBuff, OutBuf + LastBlockPos);
+	FMemory::Memcpy(OutBuf + LastBlockPos + 8, LastBlock, TailLen);
+
+	return InLen;
+}
+
+int32 FTinyEncrypt::DecryptCTS(const uint8* InBuf, int32 InLen, uint8* OutBuf) const
+{
+	if (InLen < 8)
+	{
+		return -1;
+	}
+
+	int32 BlockCounts = InLen / 8;
+	int32 TailLen = InLen - BlockCounts * 8;
+	if (TailLen == 0)
+	{
+		for (int32 i = 0; i < InLen; i += 8)
+		{
+			DecryptBlock(InBuf + i, OutBuf + i);
+		}
+		return InLen;
+	}
+
+	int32 LastBlockPos = (BlockCounts - 1) * 8;
+	for (int32 i = 0; i < LastBlockPos; i += 8)
+	{
+		DecryptBlock(InBuf + i, OutBuf + i);
+	}
+
+	//Decrypt the last full block, get the last partial block and the stolen tail
+	uint8 TailBuff[8];
+	DecryptBlock(InBuf + LastBlockPos, TailBuff);
+
+	uint8 LastBlock[8];
+	FMemory::Memcpy(LastBlock, InBuf + LastBlockPos + 8, TailLen);
+	FMemory::Memcpy(LastBlock + TailLen, TailBuff + TailLen, 8 - TailLen);
+
+	DecryptBlock(LastBlock, OutBuf + LastBlockPos);
+	FMemory::Memcpy(OutBuf + LastBlockPos + 8, TailBuff, TailLen);
+
+	return InLen;
+}
+
+int32 FTinyEncrypt::GetEncryptAndTagLength(int32 InLen)
+{
+	return GetEncryptLength(InLen) + 8;
+}
+
+int32 FTinyEncrypt::GetDecryptAndVerifyLength(int32 InLen)
+{
+	return FMath::Max(InLen - 8, 0);
+}
+
+int32 FTinyEncrypt::EncryptAndTag(const uint8* InBuf, int32 InLen, uint8* OutBuf) const
+{
+	FTinyEncryptBatchItem Item;
+	Item.InBuf = InBuf;
+	Item.InLen = InLen;
+	Item.OutBuf = OutBuf;
+	EncryptAndTagBatch(MakeArrayView(&Item, 1));
+	return Item.OutLen;
+}
+
+int32 FTinyEncrypt::DecryptAndVerify(const uint8* InBuf, int32 InLen, uint8* OutBuf) const
+{
+	FTinyEncryptBatchItem Item;
+	Item.InBuf = InBuf;
+	Item.InLen = InLen;
+	Item.OutBuf = OutBuf;
+	DecryptAndVerifyBatch(MakeArrayView(&Item, 1));
+	return Item.OutLen;
+}
+
+void FTinyEncrypt::EncryptAndTagBatch(TArrayView<FTinyEncryptBatchItem> Items) const
+{
+	using namespace TinyEncryptBlock;
+
+	uint32 Schedule[ScheduleSize], TagKey[4], TagSchedule[ScheduleSize];
+	MakeSchedule(Key, Schedule);
+	MakeTagKey(Schedule, TagKey);
+	MakeSchedule(TagKey, TagSchedule);
+
+	//4 messages in parallel lanes, the CBC-MAC of each message is a chain but the chains of the lanes are independent
+	for (int32 First = 0; First < Items.Num(); First += Lanes)
+	{
+		const int32 Count = FMath::Min(Lanes, Items.Num() - First);
+		FTinyEncryptBatchItem* Group = Items.GetData() + First;
+
+		uint8 TailBuffs[Lanes][BlockSize];
+		int32 EncryptLens[Lanes];
+		uint32 Tag0[Lanes], Tag1[Lanes];
+		int32 MaxLen = 0;
+		for (int32 Lane = 0; Lane < Count; ++Lane)
+		{
+			const FTinyEncryptBatchItem& Item = Group[Lane];
+			EncryptLens[Lane] = GetEncryptLength(Item.InLen);
+			MaxLen = FMath::Max(MaxLen, EncryptLens[Lane]);
+
+			//fill tail buf(last data and pad length)
+			const int32 BlockBytes = EncryptLens[Lane] - BlockSize;
+			const int32 PadLen = BlockSize - (Item.InLen - BlockBytes);
+			if (PadLen < BlockSize)
+			{
+				FMemory::Memcpy(TailBuffs[Lane], Item.InBuf + BlockBytes, BlockSize - PadLen);
+			}
+			FMemory::Memset(TailBuffs[Lane] + (BlockSize - PadLen), PadLen, PadLen);
+
+			//CBC-MAC of the encrypted data, start with the length of the encrypted data
+			Tag0[Lane] = (uint32)EncryptLens[Lane];
+			Tag1[Lane] = 0;
+		}
+		CryptWordsLanes<true>(TagSchedule, Tag0, Tag1, Count);
+
+		for (int32 Pos = 0; Pos < MaxLen; Pos += BlockSize)
+		{
+			//Lanes which still have a block at Pos
+			int32 Active[Lanes];
+			uint32 V0[Lanes], V1[Lanes], T0[Lanes], T1[Lanes];
+			int32 NumActive = 0;
+			for (int32 Lane = 0; Lane < Count; ++Lane)
+			{
+				if (Pos < EncryptLens[Lane])
+				{
+					const uint8* Block = (Pos < EncryptLens[Lane] - BlockSize) ? (Group[Lane].InBuf + Pos) : TailBuffs[Lane];
+					V0[NumActive] = LoadWord(Block);
+					V1[NumActive] = LoadWord(Block + 4);
+					Active[NumActive++] = Lane;
+				}
+			}
+
+			CryptWordsLanes<true>(Schedule, V0, V1, NumActive);
+			for (int32 n = 0; n < NumActive; ++n)
+			{
+				const int32 Lane = Active[n];
+				StoreWord(V0[n], Group[Lane].OutBuf + Pos);
+				StoreWord(V1[n], Group[Lane].OutBuf + Pos + 4);
+				T0[n] = Tag0[Lane] ^ V0[n];
+				T1[n] = Tag1[Lane] ^ V1[n];
+			}
+
+			CryptWordsLanes<true>(TagSchedule, T0, T1, NumActive);
+			for (int32 n = 0; n < NumActive; ++n)
+			{
+				Tag0[Active[n]] = T0[n];
+				Tag1[Active[n]] = T1[n];
+			}
+		}
+
+		for (int32 Lane = 0; Lane < Count; ++Lane)
+		{
+			FTinyEncryptBatchItem& Item = Group[Lane];
+			StoreWord(Tag0[Lane], Item.OutBuf + EncryptLens[Lane]);
+			StoreWord(Tag1[Lane], Item.OutBuf + EncryptLens[Lane] + 4);
+			Item.OutLen = EncryptLens[Lane] + BlockSize;
+		}
+	}
+}
+
+void FTinyEncrypt::DecryptAndVerifyBatch(TArrayView<FTinyEncryptBatchItem> Items) const
+{
+	using namespace TinyEncryptBlock;
+
+	uint32 Schedule[ScheduleSize], TagKey[4], TagSchedule[ScheduleSize];
+	MakeSchedule(Key, Schedule);
+	MakeTagKey(Schedule, TagKey);
+	MakeSchedule(TagKey, TagSchedule);
+
+	for (int32 First = 0; First < Items.Num(); First += Lanes)
+	{
+		const int32 Count = FMath::Min(Lanes, Items.Num() - First);
+		FTinyEncryptBatchItem* Group = Items.GetData() + First;
+
+		//Lanes with an invalid length have EncryptLen 0 and never take part
+		int32 EncryptLens[Lanes];
+		uint32 Tag0[Lanes], Tag1[Lanes];
+		int32 MaxLen = 0;
+		for (int32 Lane = 0; Lane < Count; ++Lane)
+		{
+			FTinyEncryptBatchItem& Item = Group[Lane];
+			Item.OutLen = -1;
+
+			const int32 EncryptLen = Item.InLen - BlockSize;
+			EncryptLens[Lane] = (EncryptLen >= BlockSize && (EncryptLen % BlockSize) == 0) ? EncryptLen : 0;
+			MaxLen = FMath::Max(MaxLen, EncryptLens[Lane]);
+			Tag0[Lane] = (uint32)EncryptLens[Lane];
+			Tag1[Lane] = 0;
+		}
+		CryptWordsLanes<true>(TagSchedule, Tag0, Tag1, Count);
+
+		//The tag is computed from the encrypted data, verify it before anything is written to OutBuf
+		for (int32 Pos = 0; Pos < MaxLen; Pos += BlockSize)
+		{
+			int32 Active[Lanes];
+			uint32 T0[Lanes], T1[Lanes];
+			int32 NumActive = 0;
+			for (int32 Lane = 0; Lane < Count; ++Lane)
+			{
+				if (Pos < EncryptLens[Lane])
+				{
+					T0[NumActive] = Tag0[Lane] ^ LoadWord(Group[Lane].InBuf + Pos);
+					T1[NumActive] = Tag1[Lane] ^ LoadWord(Group[Lane].InBuf + Pos + 4);
+					Active[NumActive++] = Lane;
+				}
+			}
+
+			CryptWordsLanes<true>(TagSchedule, T0, T1, NumActive);
+			for (int32 n = 0; n < NumActive; ++n)
+			{
+				Tag0[Active[n]] = T0[n];
+				Tag1[Active[n]] = T1[n];
+			}
+		}
+
+		//Check the padding of the last block before the other blocks are decrypted
+		uint8 TailBuffs[Lanes][BlockSize];
+		bool bValid[Lanes];
+		TBlockGather<false> Gather(Schedule);
+		for (int32 Lane = 0; Lane < Count; ++Lane)
+		{
+			const FTinyEncryptBatchItem& Item = Group[Lane];
+			const int32 EncryptLen = EncryptLens[Lane];
+
+			bValid[Lane] = false;
+			if (EncryptLen > 0)
+			{
+				//Compare without early exit
+				const uint32 Diff = (Tag0[Lane] ^ LoadWord(Item.InBuf + EncryptLen)) | (Tag1[Lane] ^ LoadWord(Item.InBuf + EncryptLen + 4));
+				bValid[Lane] = (Diff == 0);
+			}
+			if (bValid[Lane])
+			{
+				Gather.Add(Item.InBuf + EncryptLen - BlockSize, TailBuffs[Lane]);
+			}
+		}
+		Gather.Flush();
+
+		for (int32 Lane = 0; Lane < Count; ++Lane)
+		{
+			if (!bValid[Lane])
+			{
+				continue;
+			}
+
+			FTinyEncryptBatchItem& Item = Group[Lane];
+			const int32 PadLen = (int32)TailBuffs[Lane][BlockSize - 1];
+			if (PadLen < 1 || PadLen > BlockSize)
+			{
+				continue;
+			}
+
+			const int32 BlockBytes = EncryptLens[Lane] - BlockSize;
+			for (int32 i = 0; i < BlockBytes; i += BlockSize)
+			{
+				Gather.Add(Item.InBuf + i, Item.OutBuf + i);
+			}
+			FMemory::Memcpy(Item.OutBuf + BlockBytes, TailBuffs[Lane], BlockSize - PadLen);
+			Item.OutLen = BlockBytes + (BlockSize - PadLen);
+		}
+		Gather.Flush();
+	}
+}
+
+FUInt128Ex FTinyEncrypt::DeriveKey(const FUInt128Ex& SecretKey, uint64 Epoch)
+{
+	using namespace TinyEncryptBlock;
+
+	uint32 Schedule[ScheduleSize];
+	uint32 KeyWords[4];
+	MakeKey(SecretKey, KeyWords);
+	MakeSchedule(KeyWords, Schedule);
+
+	//Matyas-Meyer-Oseas: E(SecretKey, X) ^ X, with two domain separated blocks of the epoch
+	uint32 Output[4];
+	for (int32 i = 0; i < 2; i++)
+	{
+		const uint32 X0 = (uint32)(Epoch >> 32) ^ (0x52454B00U + (uint32)i);	//'REK'
+		const uint32 X1 = (uint32)(Epoch & 0xFFFFFFFFULL);
+
+		uint32 V0 = X0, V1 = X1;
+		EncryptWords(Schedule, V0, V1);
+		Output[i * 2] = V0 ^ X0;
+		Output[i * 2 + 1] = V1 ^ X1;
+	}
+	return FUInt128Ex(Output[0], Output[1], Output[2], Output[3]);
+}
+
+int32 FTinyEncrypt::EncryptCTR(const uint8* InBuf, int32 InLen, uint8* OutBuf, uint64 InitialCounter, uint64 StreamOffset) const
+{
+	uint32 Schedule[TinyEncryptBlock::ScheduleSize];
+	TinyEncryptBlock::MakeSchedule(Key, Schedule);
+
+	TinyEncryptBlock::CryptCTR(Schedule, InitialCounter, StreamOffset, InBuf, OutBuf, InLen);
+	return InLen;
+}
+
+int32 FTinyEncrypt::DecryptCTR(const uint8* InBuf, int32 InLen, uint8* OutBuf, uint64 InitialCounter, uint64 StreamOffset) const
+{
+	return EncryptCTR(InBuf, InLen, OutBuf, InitialCounter, StreamOffset);
+}
+
+void FTinyEncrypt::EncryptBatch(TArrayView<FTinyEncryptBatchItem> Items) const
+{
+	using namespace TinyEncryptBlock;
+
+	uint32 Schedule[ScheduleSize];
+	MakeSchedule(Key, Schedule);
+
+	TBlockGather<true> Gather(Schedule);
+	for (FTinyEncryptBatchItem& Item : Items)
+	{
+		const int32 BlockBytes = (Item.InLen / BlockSize) * BlockSize;
+		for (int32 i = 0; i < BlockBytes; i += BlockSize)
+		{
+			Gather.Add(Item.InBuf + i, Item.OutBuf + i);
+		}
+
+		//Build the tail block(last data and pad length) in the output buffer, then encrypt it in place
+		const int32 PadLen = BlockSize - (Item.InLen - BlockBytes);
+		uint8* TailBuff = Item.OutBuf + BlockBytes;
+		if (PadLen < BlockSize)
+		{
+			FMemory::Memmove(TailBuff, Item.InBuf + BlockBytes, BlockSize - PadLen);
+		}
+		FMemory::Memset(TailBuff + (BlockSize - PadLen), (uint8)PadLen, PadLen);
+		Gather.Add(TailBuff, TailBuff);
+
+		Item.OutLen = BlockBytes + BlockSize;
+	}
+	Gather.Flush();
+}
+
+void FTinyEncrypt::DecryptBatch(TArrayView<FTinyEncryptBatchItem> Items) const
+{
+	using namespace TinyEncryptBlock;
+
+	uint32 Schedule[ScheduleSize];
+	MakeSchedule(Key, Schedule);
+
+	TBlockGather<false> Gather(Schedule);
+	for (FTinyEncryptBatchItem& Item : Items)
+	{
+		if (Item.InLen <= 0 || (Item.InLen % BlockSize) != 0)
+		{
+			Item.OutLen = -1;
+			continue;
+		}
+
+		for (int32 i = 0; i < Item.InLen; i += BlockSize)
+		{
+			Gather.Add(Item.InBuf + i, Item.OutBuf + i);
+		}
+		Item.OutLen = Item.InLen;
+	}
+	Gather.Flush();
+
+	//Remove the padding after all blocks are decrypted
+	for (FTinyEncryptBatchItem& Item : Items)
+	{
+		if (Item.OutLen > 0)
+		{
+			const int32 PadLen = (int32)Item.OutBuf[Item.OutLen - 1];
+			Item.OutLen = (PadLen >= 1 && PadLen <= BlockSize) ? (Item.OutLen - PadLen) : -1;
+		}
+	}
+}
+
+int32 FTinyEncrypt::EncryptFanOut(const uint8* InBuf, int32 InLen, TArrayView<const FTinyEncrypt> Ciphers, TArrayView<uint8* const> OutBufs)
+{
+	using namespace TinyEncryptBlock;
+	check(Ciphers.Num() == OutBufs.Num());
+
+	const int32 NumKeys = Ciphers.Num();
+	if (NumKeys == 0)
+	{
+		return GetEncryptLength(InLen);
+	}
+
+	TArray<uint32, TInlineAllocator<ScheduleSize * 16>> Schedules;
+	TArray<const uint32*, TInlineAllocator<16>> SchedulePtrs;
+	Schedules.SetNumUninitialized(NumKeys * ScheduleSize);
+	SchedulePtrs.SetNumUninitialized(NumKeys);
+	for (int32 i = 0; i < NumKeys; i++)
+	{
+		MakeSchedule(Ciphers[i].Key, Schedules.GetData() + i * ScheduleSize);
+		SchedulePtrs[i] = Schedules.GetData() + i * ScheduleSize;
+	}
+
+	return TinyEncryptBlock::EncryptFanOut(SchedulePtrs.GetData(), NumKeys, InBuf, InLen, OutBufs.GetData());
+}
@@ -0,0 +1,56 @@
+// Copyright (C) 2024 Neo Jin. All Rights Reserved.
+#include "TinyEncryptAsyncAction.h"
+#include "TinyEncryptBlock.h"
+#include "Async/Async.h"
+
+UTinyEncryptAsyncAction* UTinyEncryptAsyncAction::EncryptWithTEAAsync(UObject* WorldContextObject, const TArray<uint8>& InputData, const FUInt128Ex& Key)
+{
+	return Create(WorldContextObject, TArray<uint8>(InputData), Key, false);
+}
+
+UTinyEncryptAsyncAction* UTinyEncryptAsyncAction::DecryptWithTEAAsync(UObject* WorldContextObject, const TArray<uint8>& InputData, const FUInt128Ex& Key)
+{
+	return Create(WorldContextObject, TArray<uint8>(InputData), Key, true);
+}
+
+UTinyEncryptAsyncAction* UTinyEncryptAsyncAction::Create(UObject* WorldContextObject, TArray<uint8>&& InputData, const FUInt128Ex& Key, bool bDecrypt)
+{
+	UTinyEncryptAsyncAction* Action = NewObject<UTinyEncryptAsyncAction>();
+	Action->Data = MoveTemp(InputData);
+	Action->Key = Key;
+	Action->bDecrypt = bDecrypt;
+	Action->RegisterWithGameInstance(WorldContextObject);
+	return Action;
+}
+
+void UTinyEncryptAsyncAction::Activate()
+{
+	//The background task owns the data, the action is only touched on the game thread
+	TWeakObjectPtr<UTinyEncryptAsyncAction> WeakThis(this);
+	Async(EAsyncExecution::ThreadPool, [WeakThis, Data = MoveTemp(Data), Key = Key, bDecrypt = bDecrypt]() mutable
+	{
+		auto ReportProgress = [WeakThis](float Progress)
+		{
+			AsyncTask(ENamedThreads::GameThread, [WeakThis, Progress]()
+			{
+				if (UTinyEncryptAsyncAction* This = WeakThis.Get())
+				{
+					This->OnProgress.Broadcast(Progress);
+				}
+			});
+		};
+
+		const bool bSuccess = TinyEncryptBlock::CryptInPlace(Key, bDecrypt, Data, ReportProgress);
+
+		AsyncTask(ENamedThreads::GameThread, [WeakThis, Data = MoveTemp(Data), bSuccess]()
+		{
+			if (UTinyEncryptAsyncAction* This = WeakThis.Get())
+			{
+				This->OnProgress.Broadcast(1.0f);
+				This->OnCompleted.Broadcast(Data, bSuccess);
+				This->SetReadyToDestroy();
+			}
+		});
+	});
+	Key = FUInt128Ex();
+}
@@ -0,0 +1,544 @@
+// Copyright (C) 2024 Neo Jin. All Rights Reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TinyEncryptKeyExchange.h"
+#include "TinyEncryptCompat.h"
+
+/*
+TEA block kernels shared by the cipher objects of this module.
+
+The round schedule caches `Sum + Key[...]` of all 32 cycles(64 rounds), so the kernels
+don't need to index the key or update the sum in the inner loop.
+*/
+namespace TinyEncryptBlock
+{
+	static constexpr uint32 Delta = 0x9E3779B9;	//(sqrt(5)-1)/2*2^32
+	static constexpr int32 Cycles = 32;
+	static constexpr int32 BlockSize = 8;
+	static constexpr int32 ScheduleSize = Cycles * 2;
+
+	FORCEINLINE uint32 LoadWord(const uint8* Buf)
+	{
+		return (((uint32)Buf[0]) << 24) | (((uint32)Buf[1]) << 16) | (((uint32)Buf[2]) << 8) | ((uint32)Buf[3]);
+	}
+
+	FORCEINLINE void StoreWord(uint32 Value, uint8* Buf)
+	{
+		Buf[0] = (uint8)(Value >> 24);
+		Buf[1] = (uint8)(Value >> 16);
+		Buf[2] = (uint8)(Value >> 8);
+		Buf[3] = (uint8)(Value);
+	}
+
+	//Same key layout as FTinyEncrypt
+	FORCEINLINE void MakeKey(const FUInt128Ex& InKey, uint32 OutKey[4])
+	{
+		OutKey[0] = (uint32)(InKey.LowPart() & 0xFFFFFFFFULL);
+		OutKey[1] = (uint32)((InKey.LowPart() >> 32) & 0xFFFFFFFFULL);
+		OutKey[2] = (uint32)(InKey.HiPart() & 0xFFFFFFFFULL);
+		OutKey[3] = (uint32)((InKey.HiPart() >> 32) & 0xFFFFFFFFULL);
+	}
+
+	FORCEINLINE void MakeSchedule(const uint32 Key[4], uint32* Schedule)
+	{
+		uint32 Sum = 0;
+		for (int32 i = 0; i < Cycles; ++i)
+		{
+			Schedule[i * 2] = Sum + Key[Sum & 3];
+			Sum += Delta;
+			Schedule[i * 2 + 1] = Sum + Key[(Sum >> 11) & 3];
+		}
+	}
+
+	FORCEINLINE void EncryptWords(const uint32* Schedule, uint32& V0, uint32& V1)
+	{
+		for (int32 i = 0; i < Cycles; ++i)
+		{
+			V0 += (((V1 << 4) ^ (V1 >> 5)) + V1) ^ Schedule[i * 2];
+			V1 += (((V0 << 4) ^ (V0 >> 5)) + V0) ^ Schedule[i * 2 + 1];
+		}
+	}
+
+	FORCEINLINE void DecryptWords(const uint32* Schedule, uint32& V0, uint32& V1)
+	{
+		for (int32 i = Cycles - 1; i >= 0; --i)
+		{
+			V1 -= (((V0 << 4) ^ (V0 >> 5)) + V0) ^ Schedule[i * 2 + 1];
+			V0 -= (((V1 << 4) ^ (V1 >> 5)) + V1) ^ Schedule[i * 2];
+		}
+	}
+
+	//MAC key of the authenticated mode: a constant encrypted with the encrypt key, so the tag and the encrypted data
+	//never share a key. Only the tag functions pay for it
+	FORCEINLINE void MakeTagKey(const uint32* Schedule, uint32 OutTagKey[4])
+	{
+		static const uint8 TagKeyConstant[16] = { 'T', 'i', 'n', 'y', 'E', 'n', 'c', '1', 'T', 'i', 'n', 'y', 'T', 'a', 'g', '2' };
+		for (int32 i = 0; i < 4; i += 2)
+		{
+			OutTagKey[i] = LoadWord(TagKeyConstant + i * 4);
+			OutTagKey[i + 1] = LoadWord(TagKeyConstant + i * 4 + 4);
+			EncryptWords(Schedule, OutTagKey[i], OutTagKey[i + 1]);
+		}
+	}
+
+	//Encrypt/Decrypt `NumBlocks` continuous blocks, four independent blocks are interleaved to fill the pipeline.
+	//InBuf and OutBuf can be the same buffer.
+	FORCEINLINE void EncryptBlocks(const uint32* Schedule, const uint8* InBuf, uint8* OutBuf, int32 NumBlocks)
+	{
+		int32 Index = 0;
+		for (; Index + 4 <= NumBlocks; Index += 4)
+		{
+			const uint8* In = InBuf + Index * BlockSize;
+			uint8* Out = OutBuf + Index * BlockSize;
+
+			uint32 V0[4], V1[4];
+			for (int32 Lane = 0; Lane < 4; ++Lane)
+			{
+				V0[Lane] = LoadWord(In + Lane * BlockSize);
+				V1[Lane] = LoadWord(In + Lane * BlockSize + 4);
+			}
+			for (int32 i = 0; i < Cycles; ++i)
+			{
+				const uint32 S0 = Schedule[i * 2];
+				const uint32 S1 = Schedule[i * 2 + 1];
+				for (int32 Lane = 0; Lane < 4; ++Lane)
+				{
+					V0[Lane] += (((V1[Lane] << 4) ^ (V1[Lane] >> 5)) + V1[Lane]) ^ S0;
+				}
+				for (int32 Lane = 0; Lane < 4; ++Lane)
+				{
+					V1[Lane] += (((V0[Lane] << 4) ^ (V0[Lane] >> 5)) + V0[Lane]) ^ S1;
+				}
+			}
+			for (int32 Lane = 0; Lane < 4; ++Lane)
+			{
+				StoreWord(V0[Lane], Out + Lane * BlockSize);
+				StoreWord(V1[Lane], Out + Lane * BlockSize + 4);
+			}
+		}
+
+		for (; Index < NumBlocks; ++Index)
+		{
+			uint32 V0 = LoadWord(InBuf + Index * BlockSize);
+			uint32 V1 = LoadWord(InBuf + Index * BlockSize + 4);
+			EncryptWords(Schedule, V0, V1);
+			StoreWord(V0, OutBuf + Index * BlockSize);
+			StoreWord(V1, OutBuf + Index * BlockSize + 4);
+		}
+	}
+
+	FORCEINLINE void DecryptBlocks(const uint32* Schedule, const uint8* InBuf, uint8* OutBuf, int32 NumBlocks)
+	{
+		int32 Index = 0;
+		for (; Index + 4 <= NumBlocks; Index += 4)
+		{
+			const uint8* In = InBuf + Index * BlockSize;
+			uint8* Out = OutBuf + Index * BlockSize;
+
+			uint32 V0[4], V1[4];
+			for (int32 Lane = 0; Lane < 4; ++Lane)
+			{
+				V0[Lane] = LoadWord(In + Lane * BlockSize);
+				V1[Lane] = LoadWord(In + Lane * BlockSize + 4);
+			}
+			for (int32 i = Cycles - 1; i >= 0; --i)
+			{
+				const uint32 S0 = Schedule[i * 2];
+				const uint32 S1 = Schedule[i * 2 + 1];
+				for (int32 Lane = 0; Lane < 4; ++Lane)
+				{
+					V1[Lane] -= (((V0[Lane] << 4) ^ (V0[Lane] >> 5)) + V0[Lane]) ^ S1;
+				}
+				for (int32 Lane = 0; Lane < 4; ++Lane)
+				{
+					V0[Lane] -= (((V1[Lane] << 4) ^ (V1[Lane] >> 5)) + V1[Lane]) ^ S0;
+				}
+			}
+			for (int32 Lane = 0; Lane < 4; ++Lane)
+			{
+				StoreWord(V0[Lane], Out + Lane * BlockSize);
+				StoreWord(V1[Lane], Out + Lane * BlockSize + 4);
+			}
+		}
+
+		for (; Index < NumBlocks; ++Index)
+		{
+			uint32 V0 = LoadWord(InBuf + Index * BlockSize);
+			uint32 V1 = LoadWord(InBuf + Index * BlockSize + 4);
+			DecryptWords(Schedule, V0, V1);
+			StoreWord(V0, OutBuf + Index * BlockSize);
+			StoreWord(V1, OutBuf + Index * BlockSize + 4);
+		}
+	}
+
+	//Encrypt/Decrypt up to 4 independent blocks with the same key, 4 blocks are interleaved to fill the pipeline
+	template<bool bEncrypt>
+	FORCEINLINE void CryptWordsLanes(const uint32* Schedule, uint32* V0, uint32* V1, int32 Count)
+	{
+		if (Count == 4)
+		{
+			for (int32 n = 0; n < Cycles; ++n)
+			{
+				const int32 i = bEncrypt ? n : (Cycles - 1 - n);
+				const uint32 S0 = Schedule[i * 2];
+				const uint32 S1 = Schedule[i * 2 + 1];
+				if (bEncrypt)
+				{
+					for (int32 Lane = 0; Lane < 4; ++Lane)
+					{
+						V0[Lane] += (((V1[Lane] << 4) ^ (V1[Lane] >> 5)) + V1[Lane]) ^ S0;
+					}
+					for (int32 Lane = 0; Lane < 4; ++Lane)
+					{
+						V1[Lane] += (((V0[Lane] << 4) ^ (V0[Lane] >> 5)) + V0[Lane]) ^ S1;
+					}
+				}
+				else
+				{
+					for (int32 Lane = 0; Lane < 4; ++Lane)
+					{
+						V1[Lane] -= (((V0[Lane] << 4) ^ (V0[Lane] >> 5)) + V0[Lane]) ^ S1;
+					}
+					for (int32 Lane = 0; Lane < 4; ++Lane)
+					{
+						V0[Lane] -= (((V1[Lane] << 4) ^ (V1[Lane] >> 5)) + V1[Lane]) ^ S0;
+					}
+				}
+			}
+		}
+		else
+		{
+			for (int32 Lane = 0; Lane < Count; ++Lane)
+			{
+				if (bEncrypt)
+				{
+					EncryptWords(Schedule, V0[Lane], V1[Lane]);
+				}
+				else
+				{
+					DecryptWords(Schedule, V0[Lane], V1[Lane]);
+				}
+			}
+		}
+	}
+
+	//Collect single blocks from many buffers, and encrypt/decrypt them 4 at a time
+	template<bool bEncrypt>
+	struct TBlockGather
+	{
+		const uint32* Schedule;
+		const uint8* Ins[4];
+		uint8* Outs[4];
+		int32 Count;
+
+		explicit TBlockGather(const uint32* InSchedule) : Schedule(InSchedule), Count(0) {}
+
+		FORCEINLINE void Add(const uint8* In, uint8* Out)
+		{
+			Ins[Count] = In;
+			Outs[Count] = Out;
+			if (++Count == 4)
+			{
+				Flush();
+			}
+		}
+
+		void Flush()
+		{
+			uint32 V0[4], V1[4];
+			for (int32 Lane = 0; Lane < Count; ++Lane)
+			{
+				V0[Lane] = LoadWord(Ins[Lane]);
+				V1[Lane] = LoadWord(Ins[Lane] + 4);
+			}
+
+			CryptWordsLanes<bEncrypt>(Schedule, V0, V1, Count);
+
+			for (int32 Lane = 0; Lane < Count; ++Lane)
+			{
+				StoreWord(V0[Lane], Outs[Lane]);
+				StoreWord(V1[Lane], Outs[Lane] + 4);
+			}
+			Count = 0;
+		}
+	};
+
+	static constexpr int32 Lanes = 4;
+
+	//Interleave the schedules of 4 keys, so one round of all lanes reads continuous memory
+	FORCEINLINE void InterleaveSchedules(const uint32* const* Schedules, uint32* LaneSchedule)
+	{
+		for (int32 i = 0; i < ScheduleSize; ++i)
+		{
+			for (int32 Lane = 0; Lane < Lanes; ++Lane)
+			{
+				LaneSchedule[i * Lanes + Lane] = Schedules[Lane][i];
+			}
+		}
+	}
+
+	//Encrypt 4 blocks with 4 keys, the lane loops have no dependency between lanes so the compiler can vectorize them
+	FORCEINLINE void EncryptWordsLanes(const uint32* LaneSchedule, uint32* V0, uint32* V1)
+	{
+		for (int32 i = 0; i < Cycles; ++i)
+		{
+			const uint32* S0 = LaneSchedule + (i * 2) * Lanes;
+			const uint32* S1 = LaneSchedule + (i * 2 + 1) * Lanes;
+			for (int32 Lane = 0; Lane < Lanes; ++Lane)
+			{
+				V0[Lane] += (((V1[Lane] << 4) ^ (V1[Lane] >> 5)) + V1[Lane]) ^ S0[Lane];
+			}
+			for (int32 Lane = 0; Lane < Lanes; ++Lane)
+			{
+				V1[Lane] += (((V0[Lane] << 4) ^ (V0[Lane] >> 5)) + V0[Lane]) ^ S1[Lane];
+			}
+		}
+	}
+
+	//Encrypt the same data with many keys, every key has the same output as `FTinyEncrypt::Encrypt`.
+	//Each block of the plain data is loaded once and encrypted with 4 keys in parallel lanes.
+	inline int32 EncryptFanOut(const uint32* const* Schedules, int32 NumKeys, const uint8* InBuf, int32 InLen, uint8* const* OutBufs)
+	{
+		const int32 BlockCounts = InLen / BlockSize;
+		const int32 BlockBytes = BlockCounts * BlockSize;
+		const int32 PadLen = BlockSize - (InLen - BlockBytes);
+
+		//fill tail buf(last data and pad length)
+		uint8 TailBuff[BlockSize];
+		if (PadLen < BlockSize)
+		{
+			FMemory::Memcpy(TailBuff, InBuf + BlockBytes, BlockSize - PadLen);
+		}
+		FMemory::Memset(TailBuff + (BlockSize - PadLen), (uint8)PadLen, PadLen);
+
+		//Interleave the schedules of every 4 keys, the missing lanes of the last group reuse the first key
+		const int32 GroupCounts = (NumKeys + Lanes - 1) / Lanes;
+		TArray<uint32, TInlineAllocator<ScheduleSize * Lanes * 4>> LaneSchedules;
+		LaneSchedules.SetNumUninitialized(GroupCounts * ScheduleSize * Lanes);
+		for (int32 Group = 0; Group < GroupCounts; ++Group)
+		{
+			const uint32* GroupSchedules[Lanes];
+			for (int32 Lane = 0; Lane < Lanes; ++Lane)
+			{
+				const int32 KeyIndex = Group * Lanes + Lane;
+				GroupSchedules[Lane] = Schedules[KeyIndex < NumKeys ? KeyIndex : 0];
+			}
+			InterleaveSchedules(GroupSchedules, LaneSchedules.GetData() + Group * ScheduleSize * Lanes);
+		}
+
+		for (int32 Pos = 0; Pos <= BlockBytes; Pos += BlockSize)
+		{
+			const uint8* Block = (Pos < BlockBytes) ? (InBuf + Pos) : TailBuff;
+			const uint32 In0 = LoadWord(Block);
+			const uint32 In1 = LoadWord(Block + 4);
+
+			for (int32 Group = 0; Group < GroupCounts; ++Group)
+			{
+				uint32 V0[Lanes] = { In0, In0, In0, In0 };
+				uint32 V1[Lanes] = { In1, In1, In1, In1 };
+				EncryptWordsLanes(LaneSchedules.GetData() + Group * ScheduleSize * Lanes, V0, V1);
+
+				const int32 LaneCounts = FMath::Min(Lanes, NumKeys - Group * Lanes);
+				for (int32 Lane = 0; Lane < LaneCounts; ++Lane)
+				{
+					uint8* Out = OutBufs[Group * Lanes + Lane] + Pos;
+					StoreWord(V0[Lane], Out);
+					StoreWord(V1[Lane], Out + 4);
+				}
+			}
+		}
+		return BlockBytes + BlockSize;
+	}
+
+	//Process more blocks than int32 can count, in chunks of the int32 kernels
+	FORCEINLINE void EncryptBlocks64(const uint32* Schedule, const uint8* InBuf, uint8* OutBuf, int64 NumBlocks)
+	{
+		static constexpr int64 ChunkBlocks = 1 << 20;
+		for (int64 Done = 0; Done < NumBlocks; Done += ChunkBlocks)
+		{
+			EncryptBlocks(Schedule, InBuf + Done * BlockSize, OutBuf + Done * BlockSize, (int32)FMath::Min<int64>(NumBlocks - Done, ChunkBlocks));
+		}
+	}
+
+	FORCEINLINE void DecryptBlocks64(const uint32* Schedule, const uint8* InBuf, uint8* OutBuf, int64 NumBlocks)
+	{
+		static constexpr int64 ChunkBlocks = 1 << 20;
+		for (int64 Done = 0; Done < NumBlocks; Done += ChunkBlocks)
+		{
+			DecryptBlocks(Schedule, InBuf + Done * BlockSize, OutBuf + Done * BlockSize, (int32)FMath::Min<int64>(NumBlocks - Done, ChunkBlocks));
+		}
+	}
+
+	//Same output as `FTinyEncrypt::Encrypt`
+	FORCEINLINE int32 EncryptWithPadding(const uint32* Schedule, const uint8* InBuf, int32 InLen, uint8* OutBuf)
+	{
+		const int32 BlockCounts = InLen / BlockSize;
+		const int32 BlockBytes = BlockCounts * BlockSize;
+		EncryptBlocks(Schedule, InBuf, OutBuf, BlockCounts);
+
+		const int32 PadLen = BlockSize - (InLen - BlockBytes);
+
+		//fill tail buf(last data and pad length)
+		uint8 TailBuff[BlockSize];
+		if (PadLen < BlockSize)
+		{
+			FMemory::Memcpy(TailBuff, InBuf + BlockBytes, BlockSize - PadLen);
+		}
+		FMemory::Memset(TailBuff + (BlockSize - PadLen), (uint8)PadLen, PadLen);
+		EncryptBlocks(Schedule, TailBuff, OutBuf + BlockBytes, 1);
+
+		return BlockBytes + BlockSize;
+	}
+
+	//Same as `FTinyEncrypt::Decrypt`, but return -1 if the length or the padding is invalid
+	FORCEINLINE int32 DecryptWithPadding(const uint32* Schedule, const uint8* InBuf, int32 InLen, uint8* OutBuf)
+	{
+		if (InLen <= 0 || (InLen % BlockSize) != 0)
+		{
+			return -1;
+		}
+
+		const int32 BlockBytes = InLen - BlockSize;
+		DecryptBlocks(Schedule, InBuf, OutBuf, BlockBytes / BlockSize);
+
+		uint8 TailBuff[BlockSize];
+		DecryptBlocks(Schedule, InBuf + BlockBytes, TailBuff, 1);
+
+		const int32 PadLen = (int32)TailBuff[BlockSize - 1];
+		if (PadLen < 1 || PadLen > BlockSize)
+		{
+			return -1;
+		}
+
+		FMemory::Memcpy(OutBuf + BlockBytes, TailBuff, BlockSize - PadLen);
+		return BlockBytes + (BlockSize - PadLen);
+	}
+
+	//Keystream of counter mode: block N is the encrypted big-endian `InitialCounter + N`, StreamOffset is in bytes
+	FORCEINLINE void GenerateKeystream(const uint32* Schedule, uint64 InitialCounter, uint64 StreamOffset, uint8* OutBuf, int64 Len)
+	{
+		uint8 Blocks[BlockSize * Lanes];
+		uint64 BlockIndex = StreamOffset / BlockSize;
+		int32 Skip = (int32)(StreamOffset % BlockSize);
+
+		while (Len > 0)
+		{
+			for (int32 Lane = 0; Lane < Lanes; ++Lane)
+			{
+				const uint64 Counter = InitialCounter + BlockIndex + Lane;
+				StoreWord((uint32)(Counter >> 32), Blocks + Lane * BlockSize);
+				StoreWord((uint32)Counter, Blocks + Lane * BlockSize + 4);
+			}
+			EncryptBlocks(Schedule, Blocks, Blocks, Lanes);
+
+			const int32 CopyLen = (int32)FMath::Min<int64>(Len, BlockSize * Lanes - Skip);
+			FMemory::Memcpy(OutBuf, Blocks + Skip, CopyLen);
+
+			OutBuf += CopyLen;
+			Len -= CopyLen;
+			BlockIndex += Lanes;
+			Skip = 0;
+		}
+	}
+
+	//OutBuf = InBuf ^ Keystream, 8 bytes per step so the compiler can vectorize it, OutBuf can be InBuf
+	FORCEINLINE void XorBytes(const uint8* InBuf, const uint8* Keystream, uint8* OutBuf, int64 Len)
+	{
+		int64 i = 0;
+		for (; i + 8 <= Len; i += 8)
+		{
+			uint64 Data, Key;
+			FMemory::Memcpy(&Data, InBuf + i, 8);
+			FMemory::Memcpy(&Key, Keystream + i, 8);
+			Data ^= Key;
+			FMemory::Memcpy(OutBuf + i, &Data, 8);
+		}
+		for (; i < Len; ++i)
+		{
+			OutBuf[i] = InBuf[i] ^ Keystream[i];
+		}
+	}
+
+	//Counter mode encryption, the same function decrypts
+	FORCEINLINE void CryptCTR(const uint32* Schedule, uint64 InitialCounter, uint64 StreamOffset, const uint8* InBuf, uint8* OutBuf, int64 Len)
+	{
+		uint8 Keystream[256];
+		for (int64 Pos = 0; Pos < Len; Pos += sizeof(Keystream))
+		{
+			const int64 ChunkLen = FMath::Min<int64>(Len - Pos, sizeof(Keystream));
+			GenerateKeystream(Schedule, InitialCounter, StreamOffset + Pos, Keystream, ChunkLen);
+			XorBytes(InBuf + Pos, Keystream, OutBuf + Pos, ChunkLen);
+		}
+	}
+
+	static constexpr int64 InPlaceChunkSize = 1024 * 1024;
+
+	//Same output as `FTinyEncrypt::Encrypt`/`FTinyEncrypt::Decrypt`, the data is processed in place chunk by chunk and
+	//OnProgress is called between the chunks. Return false and empty the data if it is invalid or too large to encrypt
+	inline bool CryptInPlace(const FUInt128Ex& Key, bool bDecrypt, TArray<uint8>& Data, TFunctionRef<void(float)> OnProgress)
+	{
+		const int32 InputLen = Data.Num();
+		if (bDecrypt ? (InputLen == 0 || (InputLen % BlockSize) != 0) : InputLen > MAX_int32 - BlockSize)
+		{
+			Data.Empty();
+			return false;
+		}
+
+		uint32 KeyWords[4];
+		uint32 Schedule[ScheduleSize];
+		MakeKey(Key, KeyWords);
+		MakeSchedule(KeyWords, Schedule);
+
+		const int32 BlockBytes = bDecrypt ? InputLen - BlockSize : (InputLen / BlockSize) * BlockSize;
+		if (!bDecrypt)
+		{
+			//Room for the padding block
+			Data.SetNumUninitialized(BlockBytes + BlockSize);
+		}
+		uint8* Ptr = Data.GetData();
+
+		for (int64 Done = 0; Done < BlockBytes;)
+		{
+			const int64 Len = FMath::Min(InPlaceChunkSize, BlockBytes - Done);
+			if (bDecrypt)
+			{
+				DecryptBlocks64(Schedule, Ptr + Done, Ptr + Done, Len / BlockSize);
+			}
+			else
+			{
+				EncryptBlocks64(Schedule, Ptr + Done, Ptr + Done, Len / BlockSize);
+			}
+			Done += Len;
+
+			if (Done < BlockBytes)
+			{
+				OnProgress((float)((double)Done / ((double)BlockBytes + BlockSize)));
+			}
+		}
+
+		bool bSuccess = true;
+		if (!bDecrypt)
+		{
+			EncryptWithPadding(Schedule, Ptr + BlockBytes, InputLen - BlockBytes, Ptr + BlockBytes);
+		}
+		else
+		{
+			const int32 TailLen = DecryptWithPadding(Schedule, Ptr + BlockBytes, BlockSize, Ptr + BlockBytes);
+			if (TailLen < 0)
+			{
+				//Don't hand back the partly decrypted data
+				FMemory::Memzero(Ptr, InputLen);
+				Data.Empty();
+				bSuccess = false;
+			}
+			else
+			{
+				Data.SetNum(BlockBytes + TailLen, TINYENCRYPT_NO_SHRINK);
+			}
+		}
+
+		FMemory::Memzero(Schedule, sizeof(Schedule));
+		return bSuccess;
+	}
+}
@@ -0,0 +1,203 @@
+// Copyright (C) 2024 Neo Jin. All Rights Reserved.
+#include "TinyEncryptBufferPool.h"
+#include "TinyEncryptCompat.h"
+#include "Misc/ScopeLock.h"
+
+struct FTinyEncryptBufferThreadCache
+{
+	void* FreeBuffers[FTinyEncryptBufferPool::NumSizeClasses][FTinyEncryptBufferPool::MaxThreadCached];
+	int32 NumFree[FTinyEncryptBufferPool::NumSizeClasses] = { 0 };
+
+	~FTinyEncryptBufferThreadCache()
+	{
+		//The thread exits, share its buffers
+		FTinyEncryptBufferPool& Pool = FTinyEncryptBufferPool::Get();
+		for (int32 SizeClass = 0; SizeClass < FTinyEncryptBufferPool::NumSizeClasses; ++SizeClass)
+		{
+			Pool.GiveShared(SizeClass, FreeBuffers[SizeClass], NumFree[SizeClass]);
+			NumFree[SizeClass] = 0;
+		}
+	}
+};
+
+static thread_local FTinyEncryptBufferThreadCache TinyEncryptBufferThreadCache;
+
+FTinyEncryptBuffer::FTinyEncryptBuffer(FTinyEncryptBuffer&& Other)
+	: Data(Other.Data)
+	, Length(Other.Length)
+	, MaxLength(Other.MaxLength)
+	, Capacity(Other.Capacity)
+{
+	Other.Data = nullptr;
+	Other.Length = 0;
+	Other.MaxLength = 0;
+	Other.Capacity = 0;
+}
+
+FTinyEncryptBuffer& FTinyEncryptBuffer::operator=(FTinyEncryptBuffer&& Other)
+{
+	if (this != &Other)
+	{
+		Reset();
+		Data = Other.Data;
+		Length = Other.Length;
+		MaxLength = Other.MaxLength;
+		Capacity = Other.Capacity;
+		Other.Data = nullptr;
+		Other.Length = 0;
+		Other.MaxLength = 0;
+		Other.Capacity = 0;
+	}
+	return *this;
+}
+
+void FTinyEncryptBuffer::Reset()
+{
+	if (Data != nullptr)
+	{
+		//The buffer may hold decrypted data, don't leave it in the free memory
+		FMemory::Memzero(Data, MaxLength);
+		FTinyEncryptBufferPool::Get().Release(Data, Capacity);
+		Data = nullptr;
+		Length = 0;
+		MaxLength = 0;
+		Capacity = 0;
+	}
+}
+
+FTinyEncryptBufferPool& FTinyEncryptBufferPool::Get()
+{
+	//Never destroyed, the thread caches may be released after the static destructors
+	static FTinyEncryptBufferPool* Pool = new FTinyEncryptBufferPool();
+	return *Pool;
+}
+
+int32 FTinyEncryptBufferPool::GetSizeClass(int32 Size)
+{
+	if (Size > MaxPooledSize)
+	{
+		return -1;
+	}
+	if (Size <= MinClassSize)
+	{
+		return 0;
+	}
+	return (int32)FMath::CeilLogTwo((uint32)Size) - (int32)FMath::CeilLogTwo((uint32)MinClassSize);
+}
+
+FTinyEncryptBuffer FTinyEncryptBufferPool::Allocate(int32 Size)
+{
+	check(Size >= 0);
+
+	FTinyEncryptBuffer Buffer;
+	Buffer.Length = Size;
+	Buffer.MaxLength = Size;
+
+	const int32 SizeClass = GetSizeClass(Size);
+	if (SizeClass < 0)
+	{
+		//Not pooled, still a whole number of blocks
+		Buffer.Capacity = FMath::DivideAndRoundUp(Size, 8) * 8;
+		Buffer.Data = (uint8*)FMemory::Malloc(Buffer.Capacity, Alignment);
+		return Buffer;
+	}
+
+	Buffer.Capacity = GetClassSize(SizeClass);
+
+	FTinyEncryptBufferThreadCache& Cache = TinyEncryptBufferThreadCache;
+	if (Cache.NumFree[SizeClass] == 0)
+	{
+		//Refill half of the thread cache at once, so the lock is taken once for several buffers
+		Cache.NumFree[SizeClass] = TakeShared(SizeClass, Cache.FreeBuffers[SizeClass], FMath::Max(GetMaxThreadCached(SizeClass) / 2, 1));
+	}
+
+	if (Cache.NumFree[SizeClass] > 0)
+	{
+		Buffer.Data = (uint8*)Cache.FreeBuffers[SizeClass][--Cache.NumFree[SizeClass]];
+	}
+	else
+	{
+		Buffer.Data = (uint8*)FMemory::Malloc(Buffer.Capacity, Alignment);
+	}
+	return Buffer;
+}
+
+void FTinyEncryptBufferPool::Release(uint8* Data, int32 Capacity)
+{
+	const int32 SizeClass = GetSizeClass(Capacity);
+	if (SizeClass < 0)
+	{
+		FMemory::Free(Data);
+		return;
+	}
+
+	FTinyEncryptBufferThreadCache& Cache = TinyEncryptBufferThreadCache;
+	const int32 MaxCached = GetMaxThreadCached(SizeClass);
+	if (Cache.NumFree[SizeClass] == MaxCached)
+	{
+		//Share the older half
+		const int32 NumShared = FMath::Max(MaxCached / 2, 1);
+		GiveShared(SizeClass, Cache.FreeBuffers[SizeClass], NumShared);
+		FMemory::Memmove(Cache.FreeBuffers[SizeClass], Cache.FreeBuffers[SizeClass] + NumShared, (MaxCached - NumShared) * sizeof(void*));
+		Cache.NumFree[SizeClass] -= NumShared;
+	}
+	Cache.FreeBuffers[SizeClass][Cache.NumFree[SizeClass]++] = Data;
+}
+
+int32 FTinyEncryptBufferPool::TakeShared(int32 SizeClass, void** OutBuffers, int32 MaxCount)
+{
+	FSharedBucket& Bucket = Buckets[SizeClass];
+	FScopeLock Lock(&Bucket.Lock);
+
+	const int32 Count = FMath::Min(MaxCount, Bucket.FreeBuffers.Num());
+	if (Count == 0)
+	{
+		return 0;
+	}
+	const int32 First = Bucket.FreeBuffers.Num() - Count;
+	FMemory::Memcpy(OutBuffers, Bucket.FreeBuffers.GetData() + First, Count * sizeof(void*));
+	Bucket.FreeBuffers.SetNum(First, TINYENCRYPT_NO_SHRINK);
+	return Count;
+}
+
+void FTinyEncryptBufferPool::GiveShared(int32 SizeClass, void* const* Buffers, int32 Count)
+{
+	const int32 MaxShared = FMath::Max(MaxSharedBytes / GetClassSize(SizeClass), MaxThreadCached);
+
+	FSharedBucket& Bucket = Buckets[SizeClass];
+	FScopeLock Lock(&Bucket.Lock);
+	for (int32 i = 0; i < Count; ++i)
+	{
+		if (Bucket.FreeBuffers.Num() < MaxShared)
+		{
+			Bucket.FreeBuffers.Add(Buffers[i]);
+		}
+		else
+		{
+			FMemory::Free(Buffers[i]);
+		}
+	}
+}
+
+void FTinyEncryptBufferPool::Trim()
+{
+	FTinyEncryptBufferThreadCache& Cache = TinyEncryptBufferThreadCache;
+	for (int32 SizeClass = 0; SizeClass < NumSizeClasses; ++SizeClass)
+	{
+		for (int32 i = 0; i < Cache.NumFree[SizeClass]; ++i)
+		{
+			FMemory::Free(Cache.FreeBuffers[SizeClass][i]);
+		}
+		Cache.NumFree[SizeClass] = 0;
+	}
+
+	for (FSharedBucket& Bucket : Buckets)
+	{
+		FScopeLock Lock(&Bucket.Lock);
+		for (void* Buffer : Bucket.FreeBuffers)
+		{
+			FMemory::Free(Buffer);
+		}
+		Bucket.FreeBuffers.Empty();
+	}
+}
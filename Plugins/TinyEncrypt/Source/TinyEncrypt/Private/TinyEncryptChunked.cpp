@@ -0,0 +1,126 @@
+// Copyright (C) 2024 Neo Jin. All Rights Reserved.
+#include "TinyEncryptChunked.h"
+#include "TinyEncryptBlock.h"
+
+FTinyEncryptChunkedEncryptor::FTinyEncryptChunkedEncryptor(const FUInt128Ex& Key)
+	: PendingLen(0)
+	, TotalInput(0)
+{
+	static_assert(sizeof(Schedule) == TinyEncryptBlock::ScheduleSize * sizeof(uint32), "Schedule size mismatch");
+
+	uint32 KeyWords[4];
+	TinyEncryptBlock::MakeKey(Key, KeyWords);
+	TinyEncryptBlock::MakeSchedule(KeyWords, Schedule);
+}
+
+FTinyEncryptChunkedEncryptor::~FTinyEncryptChunkedEncryptor()
+{
+	//Don't leave the key in memory
+	FMemory::Memzero(Schedule, sizeof(Schedule));
+	FMemory::Memzero(Pending, sizeof(Pending));
+}
+
+int64 FTinyEncryptChunkedEncryptor::Update(const uint8* InBuf, int64 InLen, uint8* OutBuf)
+{
+	using namespace TinyEncryptBlock;
+
+	TotalInput += InLen;
+	int64 OutLen = 0;
+
+	//Complete the kept block first
+	if (PendingLen > 0)
+	{
+		const int32 CopyLen = (int32)FMath::Min<int64>(BlockSize - PendingLen, InLen);
+		FMemory::Memcpy(Pending + PendingLen, InBuf, CopyLen);
+		PendingLen += CopyLen;
+		InBuf += CopyLen;
+		InLen -= CopyLen;
+
+		if (PendingLen < BlockSize)
+		{
+			return 0;
+		}
+
+		EncryptBlocks(Schedule, Pending, OutBuf, 1);
+		PendingLen = 0;
+		OutLen = BlockSize;
+	}
+
+	const int64 BlockBytes = (InLen / BlockSize) * BlockSize;
+	EncryptBlocks64(Schedule, InBuf, OutBuf + OutLen, BlockBytes / BlockSize);
+	OutLen += BlockBytes;
+
+	PendingLen = (int32)(InLen - BlockBytes);
+	if (PendingLen > 0)
+	{
+		FMemory::Memcpy(Pending, InBuf + BlockBytes, PendingLen);
+	}
+	return OutLen;
+}
+
+int32 FTinyEncryptChunkedEncryptor::Finalize(uint8* OutBuf)
+{
+	const int32 OutLen = TinyEncryptBlock::EncryptWithPadding(Schedule, Pending, PendingLen, OutBuf);
+
+	PendingLen = 0;
+	TotalInput = 0;
+	return OutLen;
+}
+
+FTinyEncryptChunkedDecryptor::FTinyEncryptChunkedDecryptor(const FUInt128Ex& Key)
+	: PendingLen(0)
+{
+	uint32 KeyWords[4];
+	TinyEncryptBlock::MakeKey(Key, KeyWords);
+	TinyEncryptBlock::MakeSchedule(KeyWords, Schedule);
+}
+
+FTinyEncryptChunkedDecryptor::~FTinyEncryptChunkedDecryptor()
+{
+	//Don't leave the key in memory
+	FMemory::Memzero(Schedule, sizeof(Schedule));
+	FMemory::Memzero(Pending, sizeof(Pending));
+}
+
+int64 FTinyEncryptChunkedDecryptor::Update(const uint8* InBuf, int64 InLen, uint8* OutBuf)
+{
+	using namespace TinyEncryptBlock;
+
+	//Keep 1~8 bytes, the last block may be in the next chunk
+	const int64 Available = PendingLen + InLen;
+	if (Available <= BlockSize)
+	{
+		FMemory::Memcpy(Pending + PendingLen, InBuf, InLen);
+		PendingLen = (int32)Available;
+		return 0;
+	}
+	const int64 OutBytes = ((Available - 1) / BlockSize) * BlockSize;
+	int64 OutLen = 0;
+
+	if (PendingLen > 0)
+	{
+		const int32 CopyLen = BlockSize - PendingLen;
+		FMemory::Memcpy(Pending + PendingLen, InBuf, CopyLen);
+		InBuf += CopyLen;
+		InLen -= CopyLen;
+
+		DecryptBlocks(Schedule, Pending, OutBuf, 1);
+		PendingLen = 0;
+		OutLen = BlockSize;
+	}
+
+	const int64 BlockBytes = OutBytes - OutLen;
+	DecryptBlocks64(Schedule, InBuf, OutBuf + OutLen, BlockBytes / BlockSize);
+
+	PendingLen = (int32)(InLen - BlockBytes);
+	FMemory::Memcpy(Pending, InBuf + BlockBytes, PendingLen);
+	return OutBytes;
+}
+
+int32 FTinyEncryptChunkedDecryptor::Finalize(uint8* OutBuf)
+{
+	const int32 OutLen = TinyEncryptBlock::DecryptWithPadding(Schedule, Pending, PendingLen, OutBuf);
+
+	PendingLen = 0;
+	return OutLen;
+}
@@ -0,0 +1,141 @@
+// Copyright (C) 2024 Neo Jin. All Rights Reserved.
+#include "TinyEncryptCipher.h"
+#include "TinyEncryptAlgorithm.h"
+#include "TinyEncryptAES.h"
+
+namespace TinyEncryptCipher
+{
+	class FTEACipher final : public ITinyEncryptCipher
+	{
+	public:
+		FTEACipher(const FUInt128Ex& Key)
+			: TEA(Key)
+		{
+		}
+
+		virtual ETinyEncryptCipher GetCipherType() const override { return ETinyEncryptCipher::TEA; }
+		virtual int32 GetBlockSize() const override { return 8; }
+		virtual bool IsHardwareAccelerated() const override { return false; }
+
+		virtual int32 GetEncryptLength(int32 InLen) const override { return FTinyEncrypt::GetEncryptLength(InLen); }
+		virtual int32 GetDecryptLength(int32 InLen) const override { return FTinyEncrypt::GetDecryptLength(InLen); }
+
+		virtual int32 Encrypt(const uint8* InBuf, int32 InLen, uint8* OutBuf) const override
+		{
+			return TEA.Encrypt(InBuf, InLen, OutBuf);
+		}
+
+		virtual int32 Decrypt(const uint8* InBuf, int32 InLen, uint8* OutBuf) const override
+		{
+			//The 64-bit version checks the length and the padding
+			return (int32)TEA.Decrypt64(InBuf, InLen, OutBuf);
+		}
+
+	private:
+		FTinyEncrypt TEA;
+	};
+
+	class FAESCipher final : public ITinyEncryptCipher
+	{
+	public:
+		FAESCipher(const FUInt128Ex& Key, bool bAllowHardware)
+			: bHardware(bAllowHardware && TinyEncryptAES::IsHardwareSupported())
+		{
+			TinyEncryptAES::ExpandKey(Key, Schedule);
+		}
+
+		virtual ~FAESCipher()
+		{
+			//Don't leave the key in memory
+			FMemory::Memzero(&Schedule, sizeof(Schedule));
+		}
+
+		virtual ETinyEncryptCipher GetCipherType() const override { return ETinyEncryptCipher::AES128; }
+		virtual int32 GetBlockSize() const override { return TinyEncryptAES::BlockSize; }
+		virtual bool IsHardwareAccelerated() const override { return bHardware; }
+
+		virtual int32 GetEncryptLength(int32 InLen) const override
+		{
+			using namespace TinyEncryptAES;
+			return (InLen / BlockSize) * BlockSize + BlockSize;
+		}
+
+		virtual int32 GetDecryptLength(int32 InLen) const override
+		{
+			return InLen;
+		}
+
+		virtual int32 Encrypt(const uint8* InBuf, int32 InLen, uint8* OutBuf) const override
+		{
+			using namespace TinyEncryptAES;
+
+			const int32 BlockBytes = (InLen / BlockSize) * BlockSize;
+			const int32 PadLen = BlockSize - (InLen - BlockBytes);
+
+			//Copy the tail before the full blocks are written, the buffers may be the same
+			uint8 TailBuff[BlockSize];
+			if (PadLen < BlockSize)
+			{
+				FMemory::Memcpy(TailBuff, InBuf + BlockBytes, BlockSize - PadLen);
+			}
+			FMemory::Memset(TailBuff + (BlockSize - PadLen), PadLen, PadLen);
+
+			EncryptBlocks(Schedule, bHardware, InBuf, OutBuf, BlockBytes / BlockSize);
+			EncryptBlocks(Schedule, bHardware, TailBuff, OutBuf + BlockBytes, 1);
+			return BlockBytes + BlockSize;
+		}
+
+		virtual int32 Decrypt(const uint8* InBuf, int32 InLen, uint8* OutBuf) const override
+		{
+			using namespace TinyEncryptAES;
+
+			if (InBuf == nullptr || InLen < BlockSize || (InLen % BlockSize) != 0)
+			{
+				return -1;
+			}
+
+			const int32 BlockBytes = InLen - BlockSize;
+			uint8 TailBuff[BlockSize];
+			DecryptBlocks(Schedule, bHardware, InBuf + BlockBytes, TailBuff, 1);
+
+			const int32 PadLen = (int32)TailBuff[BlockSize - 1];
+			if (PadLen < 1 || PadLen > BlockSize)
+			{
+				return -1;
+			}
+
+			DecryptBlocks(Schedule, bHardware, InBuf, OutBuf, BlockBytes / BlockSize);
+			FMemory::Memcpy(OutBuf + BlockBytes, TailBuff, BlockSize - PadLen);
+			return BlockBytes + BlockSize - PadLen;
+		}
+
+	private:
+		TinyEncryptAES::FKeySchedule Schedule;
+		bool bHardware;
+	};
+}
+
+TUniquePtr<ITinyEncryptCipher> ITinyEncryptCipher::Create(ETinyEncryptCipher Type, const FUInt128Ex& Key, bool bAllowHardware)
+{
+	using namespace TinyEncryptCipher;
+
+	switch (Type)
+	{
+	case ETinyEncryptCipher::TEA:
+		return MakeUnique<FTEACipher>(Key);
+
+	case ETinyEncryptCipher::AES128:
+		return MakeUnique<FAESCipher>(Key, bAllowHardware);
+	}
+	return nullptr;
+}
+
+int32 ITinyEncryptCipher::GetCipherBlockSize(ETinyEncryptCipher Type)
+{
+	return (Type == ETinyEncryptCipher::AES128) ? TinyEncryptAES::BlockSize : 8;
+}
+
+bool ITinyEncryptCipher::IsHardwareAESSupported()
+{
+	return TinyEncryptAES::IsHardwareSupported();
+}
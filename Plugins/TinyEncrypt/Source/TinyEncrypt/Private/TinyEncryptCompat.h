@@ -0,0 +1,12 @@
+// Copyright (C) 2024 Neo Jin. All Rights Reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Runtime/Launch/Resources/Version.h"
+
+//Keep the allocation when an array shrinks. The bool overloads of SetNum/Pop/RemoveAt are deprecated since UE 5.4
+#if ENGINE_MAJOR_VERSION > 5 || (ENGINE_MAJOR_VERSION == 5 && ENGINE_MINOR_VERSION >= 4)
+#define TINYENCRYPT_NO_SHRINK EAllowShrinking::No
+#else
+#define TINYENCRYPT_NO_SHRINK false
+#endif
@@ -0,0 +1,264 @@
+// Copyright (C) 2024 Neo Jin. All Rights Reserved.
+#include "TinyEncryptCompression.h"
+#include "TinyEncryptBlock.h"
+#include "TinyEncryptCompat.h"
+#include "Misc/Compression.h"
+
+namespace TinyEncryptCompression
+{
+	static constexpr uint32 CompressedFlag = 0x80000000u;
+	static constexpr int32 ProbeSize = 4096;
+	static constexpr float MaxCompressibleEntropy = 7.5f;	//Bits per byte, random data is close to 8
+
+	FORCEINLINE void WriteUInt32(uint32 Value, uint8* Buf)
+	{
+		Buf[0] = (uint8)(Value);
+		Buf[1] = (uint8)(Value >> 8);
+		Buf[2] = (uint8)(Value >> 16);
+		Buf[3] = (uint8)(Value >> 24);
+	}
+
+	FORCEINLINE uint32 ReadUInt32(const uint8* Buf)
+	{
+		return ((uint32)Buf[0]) | ((uint32)Buf[1] << 8) | ((uint32)Buf[2] << 16) | ((uint32)Buf[3] << 24);
+	}
+
+	FORCEINLINE int32 GetEncryptLength(int32 InLen)
+	{
+		using TinyEncryptBlock::BlockSize;
+		return (InLen / BlockSize) * BlockSize + BlockSize;
+	}
+
+	//Decrypt InLen bytes, return the plain length, -1 if the padding is invalid or the plain length isn't ExpectedLen.
+	//Only ExpectedLen bytes are written to OutBuf
+	static int32 DecryptExact(const uint32* Schedule, const uint8* InBuf, int32 InLen, uint8* OutBuf, int32 ExpectedLen)
+	{
+		using namespace TinyEncryptBlock;
+
+		if (InLen != GetEncryptLength(ExpectedLen))
+		{
+			return -1;
+		}
+
+		const int32 BlockBytes = InLen - BlockSize;
+		uint8 TailBuff[BlockSize];
+		DecryptBlocks(Schedule, InBuf + BlockBytes, TailBuff, 1);
+		if ((int32)TailBuff[BlockSize - 1] != BlockSize - (ExpectedLen - BlockBytes))
+		{
+			return -1;
+		}
+
+		DecryptBlocks64(Schedule, InBuf, OutBuf, BlockBytes / BlockSize);
+		FMemory::Memcpy(OutBuf + BlockBytes, TailBuff, ExpectedLen - BlockBytes);
+		return ExpectedLen;
+	}
+}
+
+FTinyEncryptCompression::FTinyEncryptCompression(const FUInt128Ex& Key, FName InFormatName, int32 InBlockSize)
+	: FormatName(InFormatName)
+	, BlockSize(InBlockSize)
+{
+	static_assert(sizeof(Schedule) == TinyEncryptBlock::ScheduleSize * sizeof(uint32), "Schedule size mismatch");
+	check(BlockSize > 0);
+
+	uint32 KeyWords[4];
+	TinyEncryptBlock::MakeKey(Key, KeyWords);
+	TinyEncryptBlock::MakeSchedule(KeyWords, Schedule);
+}
+
+FTinyEncryptCompression::~FTinyEncryptCompression()
+{
+	//Don't leave the key in memory
+	FMemory::Memzero(Schedule, sizeof(Schedule));
+}
+
+bool FTinyEncryptCompression::IsLikelyCompressible(const uint8* Data, int32 Len)
+{
+	using namespace TinyEncryptCompression;
+
+	//Sample evenly spread 64 bytes runs, so a compressible head doesn't hide a random body
+	const int32 RunSize = 64;
+	const int32 NumRuns = FMath::Min(ProbeSize, Len) / RunSize;
+	if (NumRuns == 0)
+	{
+		return Len > 0;
+	}
+	const int32 Stride = Len / NumRuns;
+
+	uint32 Histogram[256] = { 0 };
+	for (int32 Run = 0; Run < NumRuns; ++Run)
+	{
+		const uint8* RunData = Data + (int64)Run * Stride;
+		for (int32 i = 0; i < RunSize; ++i)
+		{
+			Histogram[RunData[i]]++;
+		}
+	}
+
+	const float NumSamples = (float)(NumRuns * RunSize);
+	float Entropy = 0.f;
+	for (uint32 Count : Histogram)
+	{
+		if (Count > 0)
+		{
+			const float P = (float)Count / NumSamples;
+			Entropy -= P * FMath::Log2(P);
+		}
+	}
+
+	//A small sample can't reach 8 bits, scale the limit by the most entropy it can show
+	const float MaxEntropy = FMath::Min(8.f, FMath::Log2(NumSamples));
+	return Entropy < MaxCompressibleEntropy * MaxEntropy / 8.f;
+}
+
+int32 FTinyEncryptCompression::GetMaxEncodedLength(int32 InLen) const
+{
+	using namespace TinyEncryptCompression;
+
+	int32 Length = HeaderSize;
+	for (int32 Offset = 0; Offset < InLen; Offset += BlockSize)
+	{
+		const int32 RawLen = FMath::Min(BlockSize, InLen - Offset);
+		//Compressed into the output before it is known to be smaller
+		const int32 StoredLen = FMath::Max(RawLen, FCompression::CompressMemoryBound(FormatName, RawLen));
+		Length += BlockHeaderSize + GetEncryptLength(StoredLen);
+	}
+	return Length;
+}
+
+int32 FTinyEncryptCompression::GetDecodedLength(const uint8* InBuf, int32 InLen)
+{
+	if (InBuf == nullptr || InLen < HeaderSize)
+	{
+		return -1;
+	}
+	using namespace TinyEncryptCompression;
+
+	//The header is not authenticated, bound the raw size by the blocks InLen can hold before anything is allocated
+	const uint32 RawSize = ReadUInt32(InBuf);
+	const uint32 HeaderBlockSize = ReadUInt32(InBuf + 4);
+	const int64 MaxBlocks = (InLen - HeaderSize) / (BlockHeaderSize + TinyEncryptBlock::BlockSize);
+	if (RawSize > (uint32)MAX_int32 || HeaderBlockSize == 0 || (int64)RawSize > MaxBlocks * (int64)HeaderBlockSize)
+	{
+		return -1;
+	}
+	return (int32)RawSize;
+}
+
+int32 FTinyEncryptCompression::CompressAndEncrypt(const uint8* InBuf, int32 InLen, uint8* OutBuf, int32 OutCapacity) const
+{
+	using namespace TinyEncryptCompression;
+
+	if (OutCapacity < GetMaxEncodedLength(InLen))
+	{
+		return -1;
+	}
+
+	WriteUInt32((uint32)InLen, OutBuf);
+	WriteUInt32((uint32)BlockSize, OutBuf + 4);
+	int32 OutLen = HeaderSize;
+
+	for (int32 Offset = 0; Offset < InLen; Offset += BlockSize)
+	{
+		const uint8* RawData = InBuf + Offset;
+		const int32 RawLen = FMath::Min(BlockSize, InLen - Offset);
+		uint8* BlockHeader = OutBuf + OutLen;
+		uint8* StoredData = BlockHeader + BlockHeaderSize;
+
+		//Compress straight into the output, then encrypt in place
+		int32 StoredLen = FCompression::CompressMemoryBound(FormatName, RawLen);
+		bool bCompressed = IsLikelyCompressible(RawData, RawLen) &&
+			FCompression::CompressMemory(FormatName, StoredData, StoredLen, RawData, RawLen) &&
+			StoredLen < RawLen;
+
+		int32 EncryptLen = 0;
+		if (bCompressed)
+		{
+			EncryptLen = TinyEncryptBlock::EncryptWithPadding(Schedule, StoredData, StoredLen, StoredData);
+		}
+		else
+		{
+			StoredLen = RawLen;
+			EncryptLen = TinyEncryptBlock::EncryptWithPadding(Schedule, RawData, RawLen, StoredData);
+		}
+
+		WriteUInt32((uint32)StoredLen | (bCompressed ? CompressedFlag : 0u), BlockHeader);
+		OutLen += BlockHeaderSize + EncryptLen;
+	}
+	return OutLen;
+}
+
+int32 FTinyEncryptCompression::DecryptAndDecompress(const uint8* InBuf, int32 InLen, uint8* OutBuf, int32 OutCapacity)
+{
+	using namespace TinyEncryptCompression;
+
+	const int32 RawSize = GetDecodedLength(InBuf, InLen);
+	if (RawSize < 0 || RawSize > OutCapacity || (int32)ReadUInt32(InBuf + 4) != BlockSize)
+	{
+		return -1;
+	}
+
+	int32 InOffset = HeaderSize;
+	for (int32 Offset = 0; Offset < RawSize; Offset += BlockSize)
+	{
+		const int32 RawLen = FMath::Min(BlockSize, RawSize - Offset);
+		if (InLen - InOffset < BlockHeaderSize)
+		{
+			return -1;
+		}
+
+		const uint32 BlockInfo = ReadUInt32(InBuf + InOffset);
+		const bool bCompressed = (BlockInfo & CompressedFlag) != 0;
+		const int32 StoredLen = (int32)(BlockInfo & ~CompressedFlag);
+		const int32 EncryptLen = GetEncryptLength(StoredLen);
+		InOffset += BlockHeaderSize;
+		if (StoredLen > RawLen || EncryptLen > InLen - InOffset)
+		{
+			return -1;
+		}
+
+		const uint8* StoredData = InBuf + InOffset;
+		if (!bCompressed)
+		{
+			if (StoredLen != RawLen || DecryptExact(Schedule, StoredData, EncryptLen, OutBuf + Offset, RawLen) < 0)
+			{
+				return -1;
+			}
+		}
+		else
+		{
+			Scratch.SetNumUninitialized(StoredLen, TINYENCRYPT_NO_SHRINK);
+			if (DecryptExact(Schedule, StoredData, EncryptLen, Scratch.GetData(), StoredLen) < 0 ||
+				!FCompression::UncompressMemory(FormatName, OutBuf + Offset, RawLen, Scratch.GetData(), StoredLen))
+			{
+				return -1;
+			}
+		}
+		InOffset += EncryptLen;
+	}
+
+	return (InOffset == InLen) ? RawSize : -1;
+}
+
+bool FTinyEncryptCompression::CompressAndEncrypt(const uint8* InBuf, int32 InLen, TArray<uint8>& OutData) const
+{
+	OutData.SetNumUninitialized(GetMaxEncodedLength(InLen), TINYENCRYPT_NO_SHRINK);
+	const int32 OutLen = CompressAndEncrypt(InBuf, InLen, OutData.GetData(), OutData.Num());
+	OutData.SetNum(FMath::Max(OutLen, 0), TINYENCRYPT_NO_SHRINK);
+	return OutLen >= 0;
+}
+
+bool FTinyEncryptCompression::DecryptAndDecompress(const uint8* InBuf, int32 InLen, TArray<uint8>& OutData)
+{
+	const int32 RawSize = GetDecodedLength(InBuf, InLen);
+	if (RawSize < 0)
+	{
+		OutData.Reset();
+		return false;
+	}
+
+	OutData.SetNumUninitialized(RawSize, TINYENCRYPT_NO_SHRINK);
+	const int32 OutLen = DecryptAndDecompress(InBuf, InLen, OutData.GetData(), OutData.Num());
+	OutData.SetNum(FMath::Max(OutLen, 0), TINYENCRYPT_NO_SHRINK);
+	return OutLen >= 0;
+}
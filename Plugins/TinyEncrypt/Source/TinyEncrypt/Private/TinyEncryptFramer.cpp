@@ -0,0 +1,184 @@
+// Copyright (C) 2024 Neo Jin. All Rights Reserved.
+#include "TinyEncryptFramer.h"
+#include "TinyEncryptCompat.h"
+
+namespace TinyEncryptFramer
+{
+	static constexpr int32 MaxVarIntSize = 5;
+
+	FORCEINLINE int32 GetVarIntSize(uint32 Value)
+	{
+		int32 Size = 1;
+		while (Value >= 0x80)
+		{
+			Value >>= 7;
+			++Size;
+		}
+		return Size;
+	}
+
+	FORCEINLINE int32 WriteVarInt(uint32 Value, uint8* OutBuf)
+	{
+		int32 Size = 0;
+		while (Value >= 0x80)
+		{
+			OutBuf[Size++] = (uint8)(Value | 0x80);
+			Value >>= 7;
+		}
+		OutBuf[Size++] = (uint8)Value;
+		return Size;
+	}
+
+	//Return the size of the varint, 0 if the varint is truncated or too long
+	FORCEINLINE int32 ReadVarInt(const uint8* InBuf, int32 InLen, uint32& OutValue)
+	{
+		OutValue = 0;
+		for (int32 i = 0; i < InLen && i < MaxVarIntSize; i++)
+		{
+			OutValue |= (uint32)(InBuf[i] & 0x7F) << (i * 7);
+			if ((InBuf[i] & 0x80) == 0)
+			{
+				return i + 1;
+			}
+		}
+		return 0;
+	}
+}
+
+FTinyEncryptFramer::FTinyEncryptFramer(const FTinyEncrypt& InTEA, const FTinyEncryptFrameSettings& InSettings)
+	: TEA(InTEA)
+	, Settings(InSettings)
+	, NumFrames(0)
+	, PendingMessages(0)
+{
+	//The encrypted length is always a multiple of 8 and larger than the plain length
+	MaxPlainSize = FMath::Max((Settings.MaxFrameSize / 8) * 8 - 1, 0);
+}
+
+int32 FTinyEncryptFramer::GetMaxMessageSize() const
+{
+	int32 MaxSize = MaxPlainSize - 1;
+	while (MaxSize > 0 && TinyEncryptFramer::GetVarIntSize((uint32)MaxSize) + MaxSize > MaxPlainSize)
+	{
+		--MaxSize;
+	}
+	return FMath::Max(MaxSize, 0);
+}
+
+bool FTinyEncryptFramer::AddMessage(const uint8* Data, int32 Len)
+{
+	check(Len >= 0);
+
+	const int32 MessageSize = TinyEncryptFramer::GetVarIntSize((uint32)Len) + Len;
+	if (MessageSize > MaxPlainSize)
+	{
+		return false;
+	}
+
+	if (GetPendingSize() + MessageSize > MaxPlainSize)
+	{
+		Flush();
+	}
+
+	TArray<uint8>& Frame = GetPendingFrame();
+	const int32 Offset = Frame.Num();
+	Frame.AddUninitialized(MessageSize);
+
+	uint8* Dest = Frame.GetData() + Offset;
+	Dest += TinyEncryptFramer::WriteVarInt((uint32)Len, Dest);
+	if (Len > 0)
+	{
+		FMemory::Memcpy(Dest, Data, Len);
+	}
+	++PendingMessages;
+
+	if ((Settings.FlushSize > 0 && Frame.Num() >= Settings.FlushSize) ||
+		(Settings.MaxMessagesPerFrame > 0 && PendingMessages >= Settings.MaxMessagesPerFrame))
+	{
+		Flush();
+	}
+	return true;
+}
+
+bool FTinyEncryptFramer::Flush()
+{
+	if (PendingMessages == 0)
+	{
+		return false;
+	}
+
+	//Grow the frame to the encrypted length, then encrypt in place
+	TArray<uint8>& Frame = Frames[NumFrames];
+	const int32 PlainLen = Frame.Num();
+	Frame.SetNumUninitialized(FTinyEncrypt::GetEncryptLength(PlainLen), TINYENCRYPT_NO_SHRINK);
+	TEA.Encrypt(Frame.GetData(), PlainLen, Frame.GetData());
+
+	++NumFrames;
+	PendingMessages = 0;
+	return true;
+}
+
+void FTinyEncryptFramer::ClearFrames()
+{
+	if (NumFrames == 0)
+	{
+		return;
+	}
+
+	//Keep the buffers of the sent frames for reuse
+	int32 First = 0;
+	if (NumFrames < Frames.Num())
+	{
+		//Move the pending frame to the front
+		Swap(Frames[0], Frames[NumFrames]);
+		First = 1;
+	}
+	for (int32 i = First; i < First + NumFrames; i++)
+	{
+		Frames[i].Reset();
+	}
+	NumFrames = 0;
+}
+
+TArray<uint8>& FTinyEncryptFramer::GetPendingFrame()
+{
+	if (NumFrames == Frames.Num())
+	{
+		Frames.AddDefaulted_GetRef().Reserve(Settings.MaxFrameSize);
+	}
+	return Frames[NumFrames];
+}
+
+bool FTinyEncryptFramer::SplitFrame(const FTinyEncrypt& TEA, uint8* Frame, int32 FrameLen, TArray<TArrayView<const uint8>>& OutMessages)
+{
+	OutMessages.Reset();
+
+	if (FrameLen <= 0 || (FrameLen % 8) != 0)
+	{
+		return false;
+	}
+
+	const int32 PlainLen = TEA.Decrypt(Frame, FrameLen, Frame);
+	if (PlainLen <= 0 || PlainLen < FrameLen - 8 || PlainLen >= FrameLen)
+	{
+		//Invalid padding
+		return false;
+	}
+
+	int32 Offset = 0;
+	while (Offset < PlainLen)
+	{
+		uint32 MessageLen = 0;
+		const int32 VarIntSize = TinyEncryptFramer::ReadVarInt(Frame + Offset, PlainLen - Offset, MessageLen);
+		if (VarIntSize == 0 || MessageLen > (uint32)(PlainLen - Offset - VarIntSize))
+		{
+			OutMessages.Reset();
+			return false;
+		}
+
+		Offset += VarIntSize;
+		OutMessages.Emplace(Frame + Offset, (int32)MessageLen);
+		Offset += (int32)MessageLen;
+	}
+	return true;
+}
@@ -0,0 +1,203 @@
+// Copyright (C) 2024 Neo Jin. All Rights Reserved.
+#include "TinyEncryptIncremental.h"
+#include "TinyEncryptBlock.h"
+#include "TinyEncryptCompat.h"
+#include "Algo/BinarySearch.h"
+
+namespace TinyEncryptIncremental
+{
+	using namespace TinyEncryptBlock;
+
+	//Blocks per step, the tweaks and the whitened blocks stay on the stack
+	static constexpr int64 StepBlocks = 64;
+
+	//XEX of whole blocks, C = E(P ^ T) ^ T with T = E_Tweak(InitialCounter + BlockIndex)
+	template<bool bEncrypt>
+	static void CryptBlocksXEX(const uint32* Schedule, const uint32* TweakSchedule, uint64 InitialCounter, int64 FirstBlock, const uint8* InBuf, uint8* OutBuf, int64 NumBlocks)
+	{
+		uint8 Tweaks[StepBlocks * BlockSize];
+		uint8 Blocks[StepBlocks * BlockSize];
+
+		for (int64 Done = 0; Done < NumBlocks;)
+		{
+			const int64 Count = FMath::Min(StepBlocks, NumBlocks - Done);
+			const int64 Bytes = Count * BlockSize;
+
+			GenerateKeystream(TweakSchedule, InitialCounter, (uint64)(FirstBlock + Done) * BlockSize, Tweaks, Bytes);
+			XorBytes(InBuf + Done * BlockSize, Tweaks, Blocks, Bytes);
+			if (bEncrypt)
+			{
+				EncryptBlocks(Schedule, Blocks, Blocks, (int32)Count);
+			}
+			else
+			{
+				DecryptBlocks(Schedule, Blocks, Blocks, (int32)Count);
+			}
+			XorBytes(Blocks, Tweaks, OutBuf + Done * BlockSize, Bytes);
+			Done += Count;
+		}
+		FMemory::Memzero(Blocks, sizeof(Blocks));
+	}
+}
+
+FTinyEncryptIncremental::FTinyEncryptIncremental(const FUInt128Ex& Key, uint64 InInitialCounter, int64 InBlobSize)
+	: InitialCounter(InInitialCounter)
+	, BlobSize(InBlobSize)
+{
+	using namespace TinyEncryptBlock;
+	static_assert(sizeof(Schedule) == ScheduleSize * sizeof(uint32), "Schedule size mismatch");
+	check(BlobSize >= BlockSize);
+
+	uint32 KeyWords[4];
+	MakeKey(Key, KeyWords);
+	MakeSchedule(KeyWords, Schedule);
+
+	//Derive the tweak key from the key, so the tweaks and the data never share a key
+	static const uint8 TweakKeyConstant[16] = { 'T', 'i', 'n', 'y', 'E', 'n', 'c', '1', 'T', 'i', 'n', 'y', 'X', 'E', 'X', '3' };
+
+	uint8 TweakKeyBytes[16];
+	EncryptBlocks(Schedule, TweakKeyConstant, TweakKeyBytes, 2);
+	for (int32 i = 0; i < 4; i++)
+	{
+		KeyWords[i] = LoadWord(TweakKeyBytes + i * 4);
+	}
+	MakeSchedule(KeyWords, TweakSchedule);
+
+	FMemory::Memzero(KeyWords, sizeof(KeyWords));
+	FMemory::Memzero(TweakKeyBytes, sizeof(TweakKeyBytes));
+}
+
+FTinyEncryptIncremental::~FTinyEncryptIncremental()
+{
+	//Don't leave the key in memory
+	FMemory::Memzero(Schedule, sizeof(Schedule));
+	FMemory::Memzero(TweakSchedule, sizeof(TweakSchedule));
+}
+
+FTinyEncryptIncremental::FRange FTinyEncryptIncremental::WidenRange(int64 Offset, int64 Len) const
+{
+	using namespace TinyEncryptBlock;
+	check(Offset >= 0 && Len >= 0 && Offset + Len <= BlobSize);
+
+	FRange Range = { Offset - Offset % BlockSize, FMath::Min(Align(Offset + Len, BlockSize), BlobSize) };
+
+	//The last full block holds a part of the encrypted tail
+	const int64 StolenBegin = (BlobSize / BlockSize - 1) * BlockSize;
+	if ((BlobSize % BlockSize) != 0 && Range.End > StolenBegin)
+	{
+		Range.Begin = FMath::Min(Range.Begin, StolenBegin);
+		Range.End = BlobSize;
+	}
+	return Range;
+}
+
+template<bool bEncrypt>
+void FTinyEncryptIncremental::CryptRange(const uint8* InBlob, uint8* OutBlob, const FRange& Range) const
+{
+	using namespace TinyEncryptBlock;
+	using namespace TinyEncryptIncremental;
+
+	const int32 TailLen = (int32)(BlobSize % BlockSize);
+	const int64 StolenBlock = BlobSize / BlockSize - 1;
+	const bool bStealing = (TailLen > 0 && Range.End == BlobSize);
+
+	//Whole blocks before the stealing part
+	const int64 FirstBlock = Range.Begin / BlockSize;
+	const int64 EndBlock = bStealing ? StolenBlock : Range.End / BlockSize;
+	if (EndBlock > FirstBlock)
+	{
+		CryptBlocksXEX<bEncrypt>(Schedule, TweakSchedule, InitialCounter, FirstBlock, InBlob + FirstBlock * BlockSize, OutBlob + FirstBlock * BlockSize, EndBlock - FirstBlock);
+	}
+
+	if (bStealing)
+	{
+		//Ciphertext stealing of the last full block and the tail, the tail is read before anything is written
+		const int64 StolenOffset = StolenBlock * BlockSize;
+		const int64 TailOffset = StolenOffset + BlockSize;
+		uint8 Stolen[BlockSize], Last[BlockSize];
+
+		//Encrypt: Stolen = XEX(LastFull), Last = Tail + Stolen[TailLen..], output XEX(Last) + Stolen[0..TailLen]
+		//Decrypt: Stolen = XEX^-1(LastFull), Last = Tail + Stolen[TailLen..], output XEX^-1(Last) + Stolen[0..TailLen]
+		const int64 FirstIndex = bEncrypt ? StolenBlock : StolenBlock + 1;
+		const int64 SecondIndex = bEncrypt ? StolenBlock + 1 : StolenBlock;
+		CryptBlocksXEX<bEncrypt>(Schedule, TweakSchedule, InitialCounter, FirstIndex, InBlob + StolenOffset, Stolen, 1);
+		FMemory::Memcpy(Last, InBlob + TailOffset, TailLen);
+		FMemory::Memcpy(Last + TailLen, Stolen + TailLen, BlockSize - TailLen);
+
+		FMemory::Memcpy(OutBlob + TailOffset, Stolen, TailLen);
+		CryptBlocksXEX<bEncrypt>(Schedule, TweakSchedule, InitialCounter, SecondIndex, Last, OutBlob + StolenOffset, 1);
+
+		FMemory::Memzero(Stolen, sizeof(Stolen));
+		FMemory::Memzero(Last, sizeof(Last));
+	}
+}
+
+void FTinyEncryptIncremental::EncryptRange(const uint8* InBlob, uint8* OutBlob, int64 Offset, int64 Len) const
+{
+	if (Len > 0)
+	{
+		CryptRange<true>(InBlob, OutBlob, WidenRange(Offset, Len));
+	}
+}
+
+void FTinyEncryptIncremental::DecryptRange(const uint8* InBlob, uint8* OutBlob, int64 Offset, int64 Len) const
+{
+	if (Len > 0)
+	{
+		CryptRange<false>(InBlob, OutBlob, WidenRange(Offset, Len));
+	}
+}
+
+void FTinyEncryptIncremental::MarkDirty(int64 Offset, int64 Len)
+{
+	if (Len == 0)
+	{
+		return;
+	}
+
+	FRange NewRange = WidenRange(Offset, Len);
+
+	//First range which may touch the new range
+	int32 First = Algo::LowerBoundBy(DirtyRanges, NewRange.Begin, [](const FRange& Range) { return Range.End; });
+
+	//Merge all ranges which overlap or are adjacent to the new range
+	int32 Last = First;
+	while (Last < DirtyRanges.Num() && DirtyRanges[Last].Begin <= NewRange.End)
+	{
+		NewRange.Begin = FMath::Min(NewRange.Begin, DirtyRanges[Last].Begin);
+		NewRange.End = FMath::Max(NewRange.End, DirtyRanges[Last].End);
+		++Last;
+	}
+
+	if (Last > First)
+	{
+		DirtyRanges[First] = NewRange;
+		DirtyRanges.RemoveAt(First + 1, Last - First - 1, TINYENCRYPT_NO_SHRINK);
+	}
+	else
+	{
+		DirtyRanges.Insert(NewRange, First);
+	}
+}
+
+int64 FTinyEncryptIncremental::GetDirtyBytes() const
+{
+	int64 Bytes = 0;
+	for (const FRange& Range : DirtyRanges)
+	{
+		Bytes += Range.End - Range.Begin;
+	}
+	return Bytes;
+}
+
+int64 FTinyEncryptIncremental::Flush(const uint8* PlainBlob, uint8* EncryptedBlob)
+{
+	int64 Bytes = 0;
+	for (const FRange& Range : DirtyRanges)
+	{
+		CryptRange<true>(PlainBlob, EncryptedBlob, Range);
+		Bytes += Range.End - Range.Begin;
+	}
+	DirtyRanges.Reset();
+	return Bytes;
+}
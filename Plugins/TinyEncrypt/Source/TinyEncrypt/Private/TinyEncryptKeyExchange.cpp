@@ -1,6 +1,5 @@
 // Copyright (C) 2024 Neo Jin. All Rights Reserved.
 #include "TinyEncryptKeyExchange.h"
-#include "Misc/Base64.h"
 
 const FUInt128Ex FUInt128Ex::Zero = FUInt128Ex(0ULL, 0ULL);
 const FUInt128Ex FUInt128Ex::P = FUInt128Ex(0xffffffffffffffffULL, 0xffffffffffffff61ULL);
@@ -124,116 +123,374 @@ FUInt128Ex FUInt128Ex::PowerModP(FUInt128Ex A, const FUInt128Ex& B)
 	return PowerModPReduce(A, B);
 }
 
-TArray<uint8> FUInt128Ex::ToArray() const
+namespace TinyEncryptConstantTime
 {
-	TArray<uint8> Output;
-	Output.Init(0, 16);
+	//All ones if Bit is 1, zero if Bit is 0
+	FORCEINLINE uint64 MakeMask(uint64 Bit)
+	{
+		return (uint64)0 - Bit;
+	}
 
-	if (FGenericPlatformProperties::IsLittleEndian())
+	//Carry of X + Y without branch
+	FORCEINLINE uint64 AddWithCarry(uint64 X, uint64 Y, uint64 CarryIn, uint64& OutSum)
 	{
-		uint64 BigEndianHi = BYTESWAP_ORDER64(Hi);
-		FMemory::Memcpy(Output.GetData(), (const void*)(&BigEndianHi), sizeof(uint64));
+		const uint64 Sum = X + Y;
+		const uint64 Carry1 = (uint64)(Sum < X);
+		OutSum = Sum + CarryIn;
+		return Carry1 | (uint64)(OutSum < Sum);
+	}
 
-		uint64 BigEndianLo = BYTESWAP_ORDER64(Lo);
-		FMemory::Memcpy(Output.GetData() + sizeof(uint64), (const void*)(&BigEndianLo), sizeof(uint64));
+	//Return (XHi,XLo) + (YHi,YLo) mod P, X and Y should be less than P
+	FORCEINLINE void AddModP(uint64& XHi, uint64& XLo, uint64 YHi, uint64 YLo)
+	{
+		//P = 2^128 - 159, so subtracting P is adding 159 mod 2^128
+		uint64 SumHi, SumLo, AdjustHi, AdjustLo;
+		const uint64 CarryLo = AddWithCarry(XLo, YLo, 0, SumLo);
+		const uint64 Carry = AddWithCarry(XHi, YHi, CarryLo, SumHi);
+
+		const uint64 AdjustCarryLo = AddWithCarry(SumLo, 159, 0, AdjustLo);
+		const uint64 AdjustCarry = AddWithCarry(SumHi, 0, AdjustCarryLo, AdjustHi);
+
+		//Sum >= P if the sum overflows 2^128 or Sum + 159 overflows 2^128
+		const uint64 Mask = MakeMask(Carry | AdjustCarry);
+		XHi = (AdjustHi & Mask) | (SumHi & ~Mask);
+		XLo = (AdjustLo & Mask) | (SumLo & ~Mask);
 	}
-	else
+
+	//Reduce a value in [0, 2^128) to [0, P)
+	FORCEINLINE void ReduceModP(uint64& XHi, uint64& XLo)
+	{
+		uint64 AdjustHi, AdjustLo;
+		const uint64 AdjustCarryLo = AddWithCarry(XLo, 159, 0, AdjustLo);
+		const uint64 AdjustCarry = AddWithCarry(XHi, 0, AdjustCarryLo, AdjustHi);
+
+		const uint64 Mask = MakeMask(AdjustCarry);
+		XHi = (AdjustHi & Mask) | (XHi & ~Mask);
+		XLo = (AdjustLo & Mask) | (XLo & ~Mask);
+	}
+
+	FORCEINLINE void ConditionalSwap(uint64 Bit, uint64& AHi, uint64& ALo, uint64& BHi, uint64& BLo)
+	{
+		const uint64 Mask = MakeMask(Bit);
+		const uint64 DiffHi = (AHi ^ BHi) & Mask;
+		const uint64 DiffLo = (ALo ^ BLo) & Mask;
+		AHi ^= DiffHi;
+		BHi ^= DiffHi;
+		ALo ^= DiffLo;
+		BLo ^= DiffLo;
+	}
+}
+
+FUInt128Ex FUInt128Ex::MulModPConstantTime(const FUInt128Ex& A, const FUInt128Ex& B)
+{
+	using namespace TinyEncryptConstantTime;
+
+	uint64 AHi = A.Hi, ALo = A.Lo;
+	ReduceModP(AHi, ALo);
+
+	//Double and add from the highest bit of B, always 128 iterations
+	uint64 ResultHi = 0, ResultLo = 0;
+	for (int32 i = 127; i >= 0; --i)
+	{
+		AddModP(ResultHi, ResultLo, ResultHi, ResultLo);
+
+		const uint64 Bit = ((i >= 64 ? (B.Hi >> (i - 64)) : (B.Lo >> i))) & 1;
+		const uint64 Mask = MakeMask(Bit);
+		AddModP(ResultHi, ResultLo, AHi & Mask, ALo & Mask);
+	}
+	return FUInt128Ex(ResultHi, ResultLo);
+}
+
+FUInt128Ex FUInt128Ex::PowerModPConstantTime(const FUInt128Ex& A, const FUInt128Ex& B)
+{
+	using namespace TinyEncryptConstantTime;
+
+	//R0 = A^(k), R1 = A^(k+1) for the processed high bits k of B
+	FUInt128Ex R0(0ULL, 1ULL);
+	FUInt128Ex R1 = A;
+	ReduceModP(R1.Hi, R1.Lo);
+
+	for (int32 i = 127; i >= 0; --i)
+	{
+		const uint64 Bit = ((i >= 64 ? (B.Hi >> (i - 64)) : (B.Lo >> i))) & 1;
+
+		ConditionalSwap(Bit, R0.Hi, R0.Lo, R1.Hi, R1.Lo);
+		R1 = MulModPConstantTime(R0, R1);
+		R0 = MulModPConstantTime(R0, R0);
+		ConditionalSwap(Bit, R0.Hi, R0.Lo, R1.Hi, R1.Lo);
+	}
+	return R0;
+}
+
+bool FUInt128Ex::NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess)
+{
+	Ar << Hi;
+	Ar << Lo;
+	bOutSuccess = !Ar.IsError();
+	return true;
+}
+
+void FUInt128Ex::WriteBytes(uint8 OutBytes[ByteSize]) const
+{
+	uint64 BigEndianHi = Hi, BigEndianLo = Lo;
+	if (FGenericPlatformProperties::IsLittleEndian())
 	{
-		FMemory::Memcpy(Output.GetData(), (const void*)(&Hi), sizeof(uint64));
-		FMemory::Memcpy(Output.GetData() + sizeof(uint64), (const void*)(&Lo), sizeof(uint64));
+		BigEndianHi = BYTESWAP_ORDER64(Hi);
+		BigEndianLo = BYTESWAP_ORDER64(Lo);
 	}
+	FMemory::Memcpy(OutBytes, &BigEndianHi, sizeof(uint64));
+	FMemory::Memcpy(OutBytes + sizeof(uint64), &BigEndianLo, sizeof(uint64));
+}
+
+void FUInt128Ex::ReadBytes(const uint8 InBytes[ByteSize])
+{
+	FMemory::Memcpy(&Hi, InBytes, sizeof(uint64));
+	FMemory::Memcpy(&Lo, InBytes + sizeof(uint64), sizeof(uint64));
+	if (FGenericPlatformProperties::IsLittleEndian())
+	{
+		Hi = BYTESWAP_ORDER64(Hi);
+		Lo = BYTESWAP_ORDER64(Lo);
+	}
+}
+
+TArray<uint8> FUInt128Ex::ToArray() const
+{
+	TArray<uint8> Output;
+	Output.SetNumUninitialized(ByteSize);
+	WriteBytes(Output.GetData());
 	return Output;
 }
 
 void FUInt128Ex::MakeFromArray(const TArray<uint8>& Array)
 {
-	//reset
-	Hi = Lo = 0;
-	
-	int32 ArrayLen = Array.Num();
-	if (ArrayLen > 16)
+	//Short data is aligned to the low bytes, too many data, ignore data at the tail
+	uint8 Bytes[ByteSize] = { 0 };
+	const int32 ArrayLen = FMath::Min(Array.Num(), ByteSize);
+	if (ArrayLen > 0)
 	{
-		//Error!, too many data, ignore data at the tail 
-		ArrayLen = 16;
+		FMemory::Memcpy(Bytes + (ByteSize - ArrayLen), Array.GetData(), ArrayLen);
 	}
+	ReadBytes(Bytes);
+}
+
+namespace TinyEncryptCodec
+{
+	static const TCHAR HexChars[] = TEXT("0123456789abcdef");
+	static const TCHAR Base64Chars[] = TEXT("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/");
 
-	int32 Index = ArrayLen - 1;
-	for (uint8 Data : Array)
+	//Char to value, -1 if invalid
+	struct FDecodeTables
 	{
-		if (Index < 0) break;
-		if (Index > 7) 
+		int8 Hex[256];
+		int8 Base64[256];
+
+		constexpr FDecodeTables() : Hex(), Base64()
 		{
-			Hi += (((uint64)Data) << (Index - 8) * 8);
+			for (int32 i = 0; i < 256; i++)
+			{
+				Hex[i] = Base64[i] = -1;
+			}
+			for (int32 i = 0; i < 10; i++)
+			{
+				Hex['0' + i] = (int8)i;
+			}
+			for (int32 i = 0; i < 6; i++)
+			{
+				Hex['a' + i] = Hex['A' + i] = (int8)(10 + i);
+			}
+			for (int32 i = 0; i < 26; i++)
+			{
+				Base64['A' + i] = (int8)i;
+				Base64['a' + i] = (int8)(26 + i);
+			}
+			for (int32 i = 0; i < 10; i++)
+			{
+				Base64['0' + i] = (int8)(52 + i);
+			}
+			Base64['+'] = 62;
+			Base64['/'] = 63;
 		}
-		else
+	};
+	static constexpr FDecodeTables DecodeTables;
+
+	FORCEINLINE int32 DecodeHex(TCHAR C)
+	{
+		return ((uint32)C < 256) ? DecodeTables.Hex[(uint32)C] : -1;
+	}
+
+	FORCEINLINE int32 DecodeBase64(TCHAR C)
+	{
+		return ((uint32)C < 256) ? DecodeTables.Base64[(uint32)C] : -1;
+	}
+}
+
+void FUInt128Ex::ToHexChars(TCHAR* OutChars) const
+{
+	for (int32 i = 0; i < 16; i++)
+	{
+		OutChars[i] = TinyEncryptCodec::HexChars[(Hi >> ((15 - i) * 4)) & 0xF];
+		OutChars[i + 16] = TinyEncryptCodec::HexChars[(Lo >> ((15 - i) * 4)) & 0xF];
+	}
+}
+
+bool FUInt128Ex::MakeFromHexChars(const TCHAR* Chars, int32 Len)
+{
+	//reset
+	Hi = Lo = 0;
+
+	//Invalid format, ignore data at the tail
+	Len = FMath::Min(Len, HexLength);
+
+	uint64 NewHi = 0, NewLo = 0;
+	for (int32 i = 0; i < Len; i++)
+	{
+		const int32 V = TinyEncryptCodec::DecodeHex(Chars[i]);
+		if (V < 0)
 		{
-			Lo += (((uint64)Data) << Index * 8);
+			//Invalid format, return zero
+			return false;
 		}
-		Index--;
+		NewHi = (NewHi << 4) | (NewLo >> 60);
+		NewLo = (NewLo << 4) | (uint64)V;
 	}
+
+	Hi = NewHi;
+	Lo = NewLo;
+	return true;
 }
 
-FString FUInt128Ex::ToHexString() const
+void FUInt128Ex::ToBase64Chars(TCHAR* OutChars) const
 {
-	return FString::Printf(TEXT("%016llx%016llx"), HiPart(), LowPart());
+	using TinyEncryptCodec::Base64Chars;
+
+	uint8 Bytes[ByteSize];
+	WriteBytes(Bytes);
+
+	for (int32 i = 0; i < 5; i++)
+	{
+		const uint32 Triple = ((uint32)Bytes[i * 3] << 16) | ((uint32)Bytes[i * 3 + 1] << 8) | (uint32)Bytes[i * 3 + 2];
+		OutChars[i * 4] = Base64Chars[Triple >> 18];
+		OutChars[i * 4 + 1] = Base64Chars[(Triple >> 12) & 0x3F];
+		OutChars[i * 4 + 2] = Base64Chars[(Triple >> 6) & 0x3F];
+		OutChars[i * 4 + 3] = Base64Chars[Triple & 0x3F];
+	}
+
+	//The last byte
+	OutChars[20] = Base64Chars[Bytes[15] >> 2];
+	OutChars[21] = Base64Chars[(Bytes[15] & 0x3) << 4];
+	OutChars[22] = TEXT('=');
+	OutChars[23] = TEXT('=');
 }
 
-void FUInt128Ex::MakeFromHexString(const FString& HexString)
+bool FUInt128Ex::MakeFromBase64Chars(const TCHAR* Chars, int32 Len)
 {
 	//reset
 	Hi = Lo = 0;
 
-	int32 CharLen = HexString.Len();
-	if (CharLen > 32)
+	if ((Len % 4) != 0)
 	{
-		CharLen = 32; //Invalid format, ignore data at the tail
+		//invalid format
+		return false;
 	}
 
-	uint64 _Hi = 0, _Lo = 0;
-	int32 Index = CharLen - 1;
-	for (auto It = HexString.CreateConstIterator(); It; ++It)
+	//Same as `MakeFromArray`, only the first 16 bytes are used
+	uint64 NewHi = 0, NewLo = 0;
+	int32 NumBytes = 0;
+	for (int32 i = 0; i < Len; i += 4)
 	{
-		if (Index < 0) break;
-		TCHAR C = *It;
-		uint64 V = 0;
-		if (C >= '0' && C <= '9') { V = (uint64)(C - '0'); }
-		else if (C >= 'a' && C <= 'f') { V = (uint64)(C - 'a' + 10); }
-		else if (C >= 'A' && C <= 'F') { V = (uint64)(C - 'A' + 10); }
-		else
+		int32 PadLen = 0;
+		if (i + 4 == Len && Chars[i + 3] == TEXT('='))
 		{
-			//Invalid format, return zero
-			return;
+			PadLen = (Chars[i + 2] == TEXT('=')) ? 2 : 1;
 		}
-		if (Index > 15)
+
+		uint32 Quad = 0;
+		for (int32 j = 0; j < 4 - PadLen; j++)
 		{
-			_Hi += V << ((Index - 16) * 4);
+			const int32 V = TinyEncryptCodec::DecodeBase64(Chars[i + j]);
+			if (V < 0)
+			{
+				//invalid format
+				return false;
+			}
+			Quad = (Quad << 6) | (uint32)V;
 		}
-		else
+		Quad <<= PadLen * 6;
+
+		for (int32 j = 0; j < 3 - PadLen && NumBytes < 16; j++, NumBytes++)
 		{
-			_Lo += V << Index * 4;
+			NewHi = (NewHi << 8) | (NewLo >> 56);
+			NewLo = (NewLo << 8) | ((Quad >> ((2 - j) * 8)) & 0xFF);
 		}
-		Index--;
 	}
 
-	Hi = _Hi;
-	Lo = _Lo;
+	Hi = NewHi;
+	Lo = NewLo;
+	return true;
 }
 
-FString FUInt128Ex::ToBase64() const
+void FUInt128Ex::ToHexChars(TArrayView<const FUInt128Ex> Values, TCHAR* OutChars)
 {
-	return FBase64::Encode(ToArray());
+	for (const FUInt128Ex& Value : Values)
+	{
+		Value.ToHexChars(OutChars);
+		OutChars += HexLength;
+	}
 }
 
-void FUInt128Ex::MakeFromBase64(const FString& Base64String)
+void FUInt128Ex::ToBase64Chars(TArrayView<const FUInt128Ex> Values, TCHAR* OutChars)
 {
-	//reset
-	Hi = Lo = 0;
+	for (const FUInt128Ex& Value : Values)
+	{
+		Value.ToBase64Chars(OutChars);
+		OutChars += Base64Length;
+	}
+}
 
-	TArray<uint8> DataArray;
-	if (!FBase64::Decode(Base64String, DataArray))
+int32 FUInt128Ex::MakeFromHexChars(const TCHAR* Chars, TArrayView<FUInt128Ex> OutValues)
+{
+	int32 ValidCounts = 0;
+	for (FUInt128Ex& Value : OutValues)
 	{
-		//invalid format
-		return;
+		ValidCounts += Value.MakeFromHexChars(Chars, HexLength) ? 1 : 0;
+		Chars += HexLength;
+	}
+	return ValidCounts;
+}
+
+int32 FUInt128Ex::MakeFromBase64Chars(const TCHAR* Chars, TArrayView<FUInt128Ex> OutValues)
+{
+	int32 ValidCounts = 0;
+	for (FUInt128Ex& Value : OutValues)
+	{
+		ValidCounts += Value.MakeFromBase64Chars(Chars, Base64Length) ? 1 : 0;
+		Chars += Base64Length;
 	}
-	MakeFromArray(DataArray);
+	return ValidCounts;
+}
+
+FString FUInt128Ex::ToHexString() const
+{
+	TCHAR Chars[HexLength + 1];
+	ToHexChars(Chars);
+	Chars[HexLength] = 0;
+	return FString(Chars);
+}
+
+void FUInt128Ex::MakeFromHexString(const FString& HexString)
+{
+	MakeFromHexChars(*HexString, HexString.Len());
+}
+
+FString FUInt128Ex::ToBase64() const
+{
+	TCHAR Chars[Base64Length + 1];
+	ToBase64Chars(Chars);
+	Chars[Base64Length] = 0;
+	return FString(Chars);
+}
+
+void FUInt128Ex::MakeFromBase64(const FString& Base64String)
+{
+	MakeFromBase64Chars(*Base64String, Base64String.Len());
 }
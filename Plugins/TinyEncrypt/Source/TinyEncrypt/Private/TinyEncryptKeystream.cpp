@@ -0,0 +1,113 @@
+// Copyright (C) 2024 Neo Jin. All Rights Reserved.
+#include "TinyEncryptKeystream.h"
+#include "TinyEncryptBlock.h"
+#include "Async/Async.h"
+
+FTinyEncryptKeystream::FTinyEncryptKeystream(const FUInt128Ex& Key, uint64 InInitialCounter, int32 InCapacity, int32 InLowWatermark)
+	: InitialCounter(InInitialCounter)
+	, ReadPos(0)
+	, WritePos(0)
+	, bRefilling(false)
+{
+	static_assert(sizeof(Schedule) == TinyEncryptBlock::ScheduleSize * sizeof(uint32), "Schedule size mismatch");
+
+	uint32 KeyWords[4];
+	TinyEncryptBlock::MakeKey(Key, KeyWords);
+	TinyEncryptBlock::MakeSchedule(KeyWords, Schedule);
+
+	Capacity = (int64)FMath::RoundUpToPowerOfTwo((uint32)FMath::Max(InCapacity, 64));
+	LowWatermark = FMath::Clamp<int64>(InLowWatermark, 0, Capacity);
+	Ring.SetNumUninitialized(Capacity);
+}
+
+FTinyEncryptKeystream::~FTinyEncryptKeystream()
+{
+	//Don't leave the key in memory
+	FMemory::Memzero(Schedule, sizeof(Schedule));
+	FMemory::Memzero(Ring.GetData(), Ring.Num());
+}
+
+int64 FTinyEncryptKeystream::GetReadyBytes() const
+{
+	const uint64 Read = ReadPos.load(std::memory_order_relaxed);
+	const uint64 Written = WritePos.load(std::memory_order_acquire);
+	return Written > Read ? (int64)(Written - Read) : 0;
+}
+
+uint64 FTinyEncryptKeystream::Encrypt(const uint8* InBuf, int32 InLen, uint8* OutBuf)
+{
+	const uint64 Offset = ReadPos.load(std::memory_order_relaxed);
+	const uint64 Written = WritePos.load(std::memory_order_acquire);
+	const int64 Ready = (Written > Offset) ? FMath::Min<int64>(Written - Offset, InLen) : 0;
+
+	//Precomputed part, may wrap around the ring
+	const int64 Mask = Capacity - 1;
+	int64 Done = 0;
+	while (Done < Ready)
+	{
+		const int64 Index = (int64)((Offset + Done) & Mask);
+		const int64 ChunkLen = FMath::Min<int64>(Ready - Done, Capacity - Index);
+		TinyEncryptBlock::XorBytes(InBuf + Done, Ring.GetData() + Index, OutBuf + Done, ChunkLen);
+		Done += ChunkLen;
+	}
+
+	//The ring runs out, compute the rest inline
+	if (Done < InLen)
+	{
+		TinyEncryptBlock::CryptCTR(Schedule, InitialCounter, Offset + Done, InBuf + Done, OutBuf + Done, InLen - Done);
+	}
+
+	//Release the ring slots to the refill
+	ReadPos.store(Offset + InLen, std::memory_order_release);
+
+	const int64 ReadyAfter = (Written > Offset + InLen) ? (int64)(Written - Offset - InLen) : 0;
+	if (ReadyAfter < LowWatermark)
+	{
+		RefillAsync();
+	}
+	return Offset;
+}
+
+void FTinyEncryptKeystream::Refill()
+{
+	bool bExpected = false;
+	if (!bRefilling.compare_exchange_strong(bExpected, true))
+	{
+		return;
+	}
+
+	//The slots of [Read, Read + Capacity) are not read by the consumer until they are published,
+	//skip the keystream behind the cursor if the consumer computed it inline
+	const int64 Mask = Capacity - 1;
+	const uint64 Read = ReadPos.load(std::memory_order_acquire);
+	const uint64 End = Read + Capacity;
+	uint64 Write = FMath::Max(WritePos.load(std::memory_order_relaxed), Read);
+
+	while (Write < End)
+	{
+		//Publish in small chunks, so the consumer can use the keystream before the ring is full
+		const int64 Index = (int64)(Write & Mask);
+		const int64 ChunkLen = FMath::Min<int64>(FMath::Min<int64>(End - Write, Capacity - Index), 1024);
+		TinyEncryptBlock::GenerateKeystream(Schedule, InitialCounter, Write, Ring.GetData() + Index, ChunkLen);
+
+		Write += ChunkLen;
+		WritePos.store(Write, std::memory_order_release);
+	}
+
+	bRefilling.store(false, std::memory_order_release);
+}
+
+void FTinyEncryptKeystream::RefillAsync()
+{
+	if (bRefilling.load(std::memory_order_relaxed) || !DoesSharedInstanceExist())
+	{
+		return;
+	}
+
+	//Keep the object alive until the refill is done
+	TSharedRef<FTinyEncryptKeystream, ESPMode::ThreadSafe> This = AsShared();
+	AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [This]()
+	{
+		This->Refill();
+	});
+}
@@ -0,0 +1,173 @@
+// Copyright (C) 2024 Neo Jin. All Rights Reserved.
+#include "TinyEncryptSessionTable.h"
+#include "TinyEncryptBlock.h"
+#include "TinyEncryptAlgorithm.h"
+#include "TinyEncryptCompat.h"
+
+FTinyEncryptSessionTable::FTinyEncryptSessionTable(int32 InitialCapacity)
+{
+	Schedules.Reserve(InitialCapacity * TinyEncryptBlock::ScheduleSize);
+	Generations.Reserve(InitialCapacity);
+	ConnectionIds.Reserve(InitialCapacity);
+	ConnectionIndex.Reserve(InitialCapacity);
+}
+
+FTinyEncryptSessionHandle FTinyEncryptSessionTable::Add(uint64 ConnectionId, const FUInt128Ex& Key)
+{
+	//One session per connection
+	Remove(Find(ConnectionId));
+
+	uint32 Index;
+	if (FreeSlots.Num() > 0)
+	{
+		Index = FreeSlots.Pop(TINYENCRYPT_NO_SHRINK);
+	}
+	else
+	{
+		Index = (uint32)Generations.Num();
+		Generations.Add(0);
+		ConnectionIds.Add(0);
+		Schedules.AddUninitialized(TinyEncryptBlock::ScheduleSize);
+	}
+
+	const uint32 Generation = ++Generations[Index];
+	ConnectionIds[Index] = ConnectionId;
+	ConnectionIndex.Add(ConnectionId, Index);
+
+	FTinyEncryptSessionHandle Handle(Index, Generation);
+	SetKey(Handle, Key);
+	return Handle;
+}
+
+bool FTinyEncryptSessionTable::Remove(FTinyEncryptSessionHandle Handle)
+{
+	if (!IsValid(Handle))
+	{
+		return false;
+	}
+
+	ConnectionIndex.Remove(ConnectionIds[Handle.Index]);
+	++Generations[Handle.Index];
+
+	//Don't leave the key in memory
+	FMemory::Memzero(&Schedules[Handle.Index * TinyEncryptBlock::ScheduleSize], TinyEncryptBlock::ScheduleSize * sizeof(uint32));
+
+	FreeSlots.Add(Handle.Index);
+	return true;
+}
+
+bool FTinyEncryptSessionTable::SetKey(FTinyEncryptSessionHandle Handle, const FUInt128Ex& Key)
+{
+	if (!IsValid(Handle))
+	{
+		return false;
+	}
+
+	uint32 KeyWords[4];
+	TinyEncryptBlock::MakeKey(Key, KeyWords);
+	TinyEncryptBlock::MakeSchedule(KeyWords, &Schedules[Handle.Index * TinyEncryptBlock::ScheduleSize]);
+	return true;
+}
+
+bool FTinyEncryptSessionTable::IsValid(FTinyEncryptSessionHandle Handle) const
+{
+	return Handle.IsValid() && Generations.IsValidIndex(Handle.Index) && Generations[Handle.Index] == Handle.Generation;
+}
+
+FTinyEncryptSessionHandle FTinyEncryptSessionTable::Find(uint64 ConnectionId) const
+{
+	const uint32* Index = ConnectionIndex.Find(ConnectionId);
+	if (Index == nullptr)
+	{
+		return FTinyEncryptSessionHandle();
+	}
+	return FTinyEncryptSessionHandle(*Index, Generations[*Index]);
+}
+
+const uint32* FTinyEncryptSessionTable::GetSchedule(FTinyEncryptSessionHandle Handle) const
+{
+	if (!IsValid(Handle))
+	{
+		return nullptr;
+	}
+	return &Schedules[Handle.Index * TinyEncryptBlock::ScheduleSize];
+}
+
+int32 FTinyEncryptSessionTable::Encrypt(FTinyEncryptSessionHandle Handle, const uint8* InBuf, int32 InLen, uint8* OutBuf) const
+{
+	const uint32* Schedule = GetSchedule(Handle);
+	if (Schedule == nullptr)
+	{
+		return -1;
+	}
+	return TinyEncryptBlock::EncryptWithPadding(Schedule, InBuf, InLen, OutBuf);
+}
+
+int32 FTinyEncryptSessionTable::Decrypt(FTinyEncryptSessionHandle Handle, const uint8* InBuf, int32 InLen, uint8* OutBuf) const
+{
+	const uint32* Schedule = GetSchedule(Handle);
+	if (Schedule == nullptr)
+	{
+		return -1;
+	}
+	return TinyEncryptBlock::DecryptWithPadding(Schedule, InBuf, InLen, OutBuf);
+}
+
+void FTinyEncryptSessionTable::EncryptBatch(TArrayView<FTinyEncryptSessionPacket> Packets) const
+{
+	FTinyEncryptSessionHandle LastHandle;
+	const uint32* Schedule = nullptr;
+
+	for (FTinyEncryptSessionPacket& Packet : Packets)
+	{
+		if (!(Packet.Session == LastHandle))
+		{
+			LastHandle = Packet.Session;
+			Schedule = GetSchedule(Packet.Session);
+		}
+
+		Packet.OutLen = (Schedule != nullptr) ? TinyEncryptBlock::EncryptWithPadding(Schedule, Packet.InBuf, Packet.InLen, Packet.OutBuf) : -1;
+	}
+}
+
+void FTinyEncryptSessionTable::DecryptBatch(TArrayView<FTinyEncryptSessionPacket> Packets) const
+{
+	FTinyEncryptSessionHandle LastHandle;
+	const uint32* Schedule = nullptr;
+
+	for (FTinyEncryptSessionPacket& Packet : Packets)
+	{
+		if (!(Packet.Session == LastHandle))
+		{
+			LastHandle = Packet.Session;
+			Schedule = GetSchedule(Packet.Session);
+		}
+
+		Packet.OutLen = (Schedule != nullptr) ? TinyEncryptBlock::DecryptWithPadding(Schedule, Packet.InBuf, Packet.InLen, Packet.OutBuf) : -1;
+	}
+}
+
+int32 FTinyEncryptSessionTable::EncryptFanOut(const uint8* InBuf, int32 InLen, TArrayView<const FTinyEncryptSessionHandle> Sessions, TArrayView<uint8* const> OutBufs) const
+{
+	check(Sessions.Num() == OutBufs.Num());
+
+	TArray<const uint32*, TInlineAllocator<64>> ValidSchedules;
+	TArray<uint8*, TInlineAllocator<64>> ValidOutBufs;
+	ValidSchedules.Reserve(Sessions.Num());
+	ValidOutBufs.Reserve(Sessions.Num());
+
+	for (int32 i = 0; i < Sessions.Num(); i++)
+	{
+		if (const uint32* Schedule = GetSchedule(Sessions[i]))
+		{
+			ValidSchedules.Add(Schedule);
+			ValidOutBufs.Add(OutBufs[i]);
+		}
+	}
+
+	if (ValidSchedules.Num() == 0)
+	{
+		return FTinyEncrypt::GetEncryptLength(InLen);
+	}
+	return TinyEncryptBlock::EncryptFanOut(ValidSchedules.GetData(), ValidSchedules.Num(), InBuf, InLen, ValidOutBufs.GetData());
+}
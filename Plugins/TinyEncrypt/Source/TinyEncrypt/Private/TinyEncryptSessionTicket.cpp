@@ -0,0 +1,124 @@
+// Copyright (C) 2024 Neo Jin. All Rights Reserved.
+#include "TinyEncryptSessionTicket.h"
+#include "Misc/DateTime.h"
+
+static_assert(FTinyEncryptTicket::Size == (FTinyEncryptTicket::PlainSize / 8 + 1) * 8 + 8, "Ticket size must match FTinyEncrypt::GetEncryptAndTagLength");
+
+FTinyEncryptTicketIssuer::FTinyEncryptTicketIssuer(const FUInt128Ex& TicketKey)
+	: TicketTEA(TicketKey)
+{
+}
+
+namespace TinyEncryptSessionTicket
+{
+	//Tickets of one batch step, the plain data stays on the stack
+	static constexpr int32 BatchSize = 64;
+
+	static void PackPlainData(const FUInt128Ex& SecretKey, int64 ExpireTime, uint8* OutPlainData)
+	{
+		const uint64 Words[3] = { SecretKey.HiPart(), SecretKey.LowPart(), (uint64)ExpireTime };
+		for (int32 i = 0; i < 3; i++)
+		{
+			for (int32 j = 0; j < 8; j++)
+			{
+				OutPlainData[i * 8 + j] = (uint8)(Words[i] >> ((7 - j) * 8));
+			}
+		}
+	}
+
+	static bool UnpackPlainData(const uint8* PlainData, int64 Now, FUInt128Ex& OutSecretKey)
+	{
+		uint64 Words[3] = { 0 };
+		for (int32 i = 0; i < 3; i++)
+		{
+			for (int32 j = 0; j < 8; j++)
+			{
+				Words[i] = (Words[i] << 8) | PlainData[i * 8 + j];
+			}
+		}
+
+		if ((int64)Words[2] < Now)
+		{
+			//Expired
+			return false;
+		}
+
+		OutSecretKey = FUInt128Ex(Words[0], Words[1]);
+		return true;
+	}
+}
+
+void FTinyEncryptTicketIssuer::IssueTicket(const FUInt128Ex& SecretKey, int64 ExpireTime, FTinyEncryptTicket& OutTicket) const
+{
+	IssueTickets(MakeArrayView(&SecretKey, 1), ExpireTime, MakeArrayView(&OutTicket, 1));
+}
+
+bool FTinyEncryptTicketIssuer::ValidateTicket(const FTinyEncryptTicket& Ticket, int64 Now, FUInt128Ex& OutSecretKey) const
+{
+	return ValidateTickets(MakeArrayView(&Ticket, 1), Now, MakeArrayView(&OutSecretKey, 1)) == 1;
+}
+
+void FTinyEncryptTicketIssuer::IssueTickets(TArrayView<const FUInt128Ex> SecretKeys, int64 ExpireTime, TArrayView<FTinyEncryptTicket> OutTickets) const
+{
+	using namespace TinyEncryptSessionTicket;
+	check(SecretKeys.Num() == OutTickets.Num());
+
+	uint8 PlainData[BatchSize][FTinyEncryptTicket::PlainSize];
+	FTinyEncryptBatchItem Items[BatchSize];
+
+	for (int32 First = 0; First < SecretKeys.Num(); First += BatchSize)
+	{
+		const int32 Count = FMath::Min(BatchSize, SecretKeys.Num() - First);
+		for (int32 i = 0; i < Count; i++)
+		{
+			PackPlainData(SecretKeys[First + i], ExpireTime, PlainData[i]);
+			Items[i].InBuf = PlainData[i];
+			Items[i].InLen = FTinyEncryptTicket::PlainSize;
+			Items[i].OutBuf = OutTickets[First + i].Data;
+		}
+
+		//The schedules are built once per batch step and the tickets are encrypted in parallel lanes
+		TicketTEA.EncryptAndTagBatch(MakeArrayView(Items, Count));
+	}
+	FMemory::Memzero(PlainData, sizeof(PlainData));
+}
+
+int32 FTinyEncryptTicketIssuer::ValidateTickets(TArrayView<const FTinyEncryptTicket> Tickets, int64 Now, TArrayView<FUInt128Ex> OutSecretKeys) const
+{
+	using namespace TinyEncryptSessionTicket;
+	check(Tickets.Num() == OutSecretKeys.Num());
+
+	uint8 PlainData[BatchSize][FTinyEncryptTicket::Size];
+	FTinyEncryptBatchItem Items[BatchSize];
+
+	int32 ValidCounts = 0;
+	for (int32 First = 0; First < Tickets.Num(); First += BatchSize)
+	{
+		const int32 Count = FMath::Min(BatchSize, Tickets.Num() - First);
+		for (int32 i = 0; i < Count; i++)
+		{
+			Items[i].InBuf = Tickets[First + i].Data;
+			Items[i].InLen = FTinyEncryptTicket::Size;
+			Items[i].OutBuf = PlainData[i];
+		}
+
+		TicketTEA.DecryptAndVerifyBatch(MakeArrayView(Items, Count));
+
+		for (int32 i = 0; i < Count; i++)
+		{
+			FUInt128Ex& OutSecretKey = OutSecretKeys[First + i];
+			OutSecretKey = FUInt128Ex::Zero;
+			if (Items[i].OutLen == FTinyEncryptTicket::PlainSize && UnpackPlainData(PlainData[i], Now, OutSecretKey))
+			{
+				ValidCounts++;
+			}
+		}
+	}
+	FMemory::Memzero(PlainData, sizeof(PlainData));
+	return ValidCounts;
+}
+
+int64 FTinyEncryptTicketIssuer::GetNow()
+{
+	return FDateTime::UtcNow().ToUnixTimestamp();
+}
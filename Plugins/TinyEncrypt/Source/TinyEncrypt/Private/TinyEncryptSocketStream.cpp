@@ -0,0 +1,150 @@
+// Copyright (C) 2024 Neo Jin. All Rights Reserved.
+#include "TinyEncryptSocketStream.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+
+FTinyEncryptSocketStream::FTinyEncryptSocketStream(FSocket* InSocket, TUniquePtr<ITinyEncryptCipher>&& InCipher, const FTinyEncryptSocketStreamSettings& InSettings)
+	: Socket(InSocket)
+	, Cipher(MoveTemp(InCipher))
+	, Settings(InSettings)
+	, SendBegin(0)
+	, SendEnd(0)
+	, ReceiveBegin(0)
+	, ReceiveEnd(0)
+	, bClosed(false)
+{
+	check(Socket != nullptr && Cipher.IsValid());
+
+	MaxFrameSize = HeaderSize + Cipher->GetEncryptLength(Settings.MaxMessageSize);
+	check(Settings.SendBufferSize >= MaxFrameSize && Settings.ReceiveBufferSize >= MaxFrameSize);
+
+	//Every byte is written before it is sent or decrypted, no need to zero
+	SendBuffer.SetNumUninitialized(Settings.SendBufferSize);
+	ReceiveBuffer.SetNumUninitialized(Settings.ReceiveBufferSize);
+
+	Socket->SetNonBlocking(true);
+}
+
+ETinyEncryptSendResult FTinyEncryptSocketStream::Send(const uint8* Data, int32 Len)
+{
+	if (Len < 0 || Len > Settings.MaxMessageSize)
+	{
+		return ETinyEncryptSendResult::TooLarge;
+	}
+
+	const int32 EncryptLength = Cipher->GetEncryptLength(Len);
+	const int32 FrameSize = HeaderSize + EncryptLength;
+	if (SendBuffer.Num() - SendEnd < FrameSize)
+	{
+		if (!Flush())
+		{
+			return ETinyEncryptSendResult::Failed;
+		}
+		if (SendBuffer.Num() - SendEnd < FrameSize)
+		{
+			return ETinyEncryptSendResult::WouldBlock;
+		}
+	}
+
+	uint8* Frame = SendBuffer.GetData() + SendEnd;
+	Frame[0] = (uint8)EncryptLength;
+	Frame[1] = (uint8)(EncryptLength >> 8);
+	Frame[2] = (uint8)(EncryptLength >> 16);
+	Frame[3] = (uint8)(EncryptLength >> 24);
+	Cipher->Encrypt(Data, Len, Frame + HeaderSize);
+
+	SendEnd += FrameSize;
+	return ETinyEncryptSendResult::Queued;
+}
+
+bool FTinyEncryptSocketStream::Flush()
+{
+	while (SendBegin < SendEnd)
+	{
+		int32 Sent = 0;
+		if (!Socket->Send(SendBuffer.GetData() + SendBegin, SendEnd - SendBegin, Sent))
+		{
+			if (ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->GetLastErrorCode() == SE_EWOULDBLOCK)
+			{
+				break;
+			}
+			return false;
+		}
+		if (Sent <= 0)
+		{
+			break;
+		}
+		SendBegin += Sent;
+	}
+
+	//Move the unsent bytes to the front, only when the socket can't keep up
+	if (SendBegin == SendEnd)
+	{
+		SendBegin = 0;
+		SendEnd = 0;
+	}
+	else if (SendBegin > 0)
+	{
+		FMemory::Memmove(SendBuffer.GetData(), SendBuffer.GetData() + SendBegin, SendEnd - SendBegin);
+		SendEnd -= SendBegin;
+		SendBegin = 0;
+	}
+	return true;
+}
+
+bool FTinyEncryptSocketStream::Receive(TArray<TArrayView<const uint8>>& OutMessages)
+{
+	OutMessages.Reset();
+
+	//The messages of the last call are consumed, keep the incomplete frame only
+	if (ReceiveBegin > 0)
+	{
+		FMemory::Memmove(ReceiveBuffer.GetData(), ReceiveBuffer.GetData() + ReceiveBegin, ReceiveEnd - ReceiveBegin);
+		ReceiveEnd -= ReceiveBegin;
+		ReceiveBegin = 0;
+	}
+
+	while (!bClosed && ReceiveEnd < ReceiveBuffer.Num())
+	{
+		int32 Read = 0;
+		if (!Socket->Recv(ReceiveBuffer.GetData() + ReceiveEnd, ReceiveBuffer.Num() - ReceiveEnd, Read))
+		{
+			//The peer may have sent its last messages before closing, hand them out first
+			bClosed = true;
+			break;
+		}
+		if (Read <= 0)
+		{
+			break;
+		}
+		ReceiveEnd += Read;
+	}
+
+	const int32 BlockSize = Cipher->GetBlockSize();
+	while (ReceiveEnd - ReceiveBegin >= HeaderSize)
+	{
+		uint8* Frame = ReceiveBuffer.GetData() + ReceiveBegin;
+		const uint32 EncryptLength = (uint32)Frame[0] | ((uint32)Frame[1] << 8) | ((uint32)Frame[2] << 16) | ((uint32)Frame[3] << 24);
+		if (EncryptLength == 0 || EncryptLength > (uint32)(MaxFrameSize - HeaderSize) || (EncryptLength % BlockSize) != 0)
+		{
+			return false;
+		}
+
+		const int32 FrameSize = HeaderSize + (int32)EncryptLength;
+		if (ReceiveEnd - ReceiveBegin < FrameSize)
+		{
+			break;
+		}
+
+		const int32 MessageLength = Cipher->Decrypt(Frame + HeaderSize, (int32)EncryptLength, Frame + HeaderSize);
+		if (MessageLength < 0)
+		{
+			return false;
+		}
+		OutMessages.Emplace(Frame + HeaderSize, MessageLength);
+		ReceiveBegin += FrameSize;
+	}
+
+	//The close is reported once all the complete frames are handed out
+	return !bClosed || OutMessages.Num() > 0;
+}
@@ -1,6 +1,7 @@
 // Copyright (C) 2024 Neo Jin. All Rights Reserved.
 #include "TinyEncryptUtilities.h"
 #include "TinyEncryptAlgorithm.h"
+#include "TinyEncryptXXTEA.h"
 
 FUInt128Ex UTinyEncryptUtilities::MakeRandomUInt128()
 {
@@ -63,6 +64,11 @@ bool UTinyEncryptUtilities::EqualEqual_UInt128(const FUInt128Ex& A, const FUInt1
 	return A == B;
 }
 
+FUInt128Ex UTinyEncryptUtilities::DeriveTEAKey(const FUInt128Ex& SecretKey, int64 Epoch)
+{
+	return FTinyEncrypt::DeriveKey(SecretKey, (uint64)Epoch);
+}
+
 TArray<uint8> UTinyEncryptUtilities::EncryptWithTEA(const TArray<uint8>& InputData, const FUInt128Ex& Key)
 {
 	FTinyEncrypt TEA(Key);
@@ -71,8 +77,9 @@ TArray<uint8> UTinyEncryptUtilities::EncryptWithTEA(const TArray<uint8>& InputDa
 	const uint8* InputDataPtr = InputData.GetData();
 	const int32 EncryptLength = FTinyEncrypt::GetEncryptLength(InputLen);
 
+	//Every byte is written by Encrypt, no need to zero
 	TArray<uint8> OutputData;
-	OutputData.Init(0, EncryptLength);
+	OutputData.SetNumUninitialized(EncryptLength);
 	TEA.Encrypt(InputDataPtr, InputLen, OutputData.GetData());
 
 	return OutputData;
@@ -87,7 +94,7 @@ TArray<uint8> UTinyEncryptUtilities::DecryptWithTEA(const TArray<uint8>& InputDa
 	const int32 DecryptLength = FTinyEncrypt::GetDecryptLength(InputLen);
 
 	TArray<uint8> OutputData;
-	OutputData.Init(0, DecryptLength);
+	OutputData.SetNumUninitialized(DecryptLength);
 	int32 OutputLength = 0;
 	if (InputDataPtr != nullptr && InputLen > 0)
 	{
@@ -97,3 +104,53 @@ TArray<uint8> UTinyEncryptUtilities::DecryptWithTEA(const TArray<uint8>& InputDa
 	OutputData.SetNum(OutputLength);
 	return OutputData;
 }
+
+TArray<uint8> UTinyEncryptUtilities::EncryptWithXXTEA(const TArray<uint8>& InputData, const FUInt128Ex& Key)
+{
+	FTinyEncryptXXTEA XXTEA(Key);
+
+	const int32 InputLen = InputData.Num();
+	TArray<uint8> OutputData;
+	OutputData.SetNumUninitialized(FTinyEncryptXXTEA::GetEncryptLength(InputLen));
+	XXTEA.Encrypt(InputData.GetData(), InputLen, OutputData.GetData());
+
+	return OutputData;
+}
+
+TArray<uint8> UTinyEncryptUtilities::DecryptWithXXTEA(const TArray<uint8>& InputData, const FUInt128Ex& Key)
+{
+	FTinyEncryptXXTEA XXTEA(Key);
+
+	const int32 InputLen = InputData.Num();
+	TArray<uint8> OutputData;
+	OutputData.SetNumUninitialized(FTinyEncryptXXTEA::GetDecryptLength(InputLen));
+	const int32 OutputLength = XXTEA.Decrypt(InputData.GetData(), InputLen, OutputData.GetData());
+
+	OutputData.SetNum(FMath::Max(OutputLength, 0));
+	return OutputData;
+}
+
+TArray64<uint8> UTinyEncryptUtilities::EncryptWithTEA64(const TArray64<uint8>& InputData, const FUInt128Ex& Key)
+{
+	FTinyEncrypt TEA(Key);
+
+	const int64 InputLen = InputData.Num();
+	TArray64<uint8> OutputData;
+	OutputData.SetNumUninitialized(FTinyEncrypt::GetEncryptLength64(InputLen));
+	TEA.Encrypt64(InputData.GetData(), InputLen, OutputData.GetData());
+
+	return OutputData;
+}
+
+TArray64<uint8> UTinyEncryptUtilities::DecryptWithTEA64(const TArray64<uint8>& InputData, const FUInt128Ex& Key)
+{
+	FTinyEncrypt TEA(Key);
+
+	const int64 InputLen = InputData.Num();
+	TArray64<uint8> OutputData;
+	OutputData.SetNumUninitialized(FTinyEncrypt::GetDecryptLength64(InputLen));
+	const int64 OutputLength = TEA.Decrypt64(InputData.GetData(), InputLen, OutputData.GetData());
+
+	OutputData.SetNum(FMath::Max<int64>(OutputLength, 0));
+	return OutputData;
+}
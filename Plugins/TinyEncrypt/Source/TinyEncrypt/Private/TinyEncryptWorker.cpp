@@ -0,0 +1,159 @@
+// Copyright (C) 2024 Neo Jin. All Rights Reserved.
+#include "TinyEncryptWorker.h"
+#include "TinyEncryptCompat.h"
+#include "HAL/Event.h"
+#include "HAL/RunnableThread.h"
+#include "HAL/PlatformProcess.h"
+
+FTinyEncryptWorker::FTinyEncryptWorker(uint32 QueueCapacity)
+	: EncryptDirection(true, QueueCapacity)
+	, DecryptDirection(false, QueueCapacity)
+	, WakeEvent(nullptr)
+	, Thread(nullptr)
+	, bStopping(false)
+{
+	if (FPlatformProcess::SupportsMultithreading())
+	{
+		WakeEvent = FPlatformProcess::GetSynchEventFromPool(false);
+		Thread = FRunnableThread::Create(this, TEXT("TinyEncryptWorker"), 0, TPri_AboveNormal);
+	}
+}
+
+FTinyEncryptWorker::~FTinyEncryptWorker()
+{
+	if (Thread != nullptr)
+	{
+		Thread->Kill(true);
+		delete Thread;
+		Thread = nullptr;
+	}
+
+	if (WakeEvent != nullptr)
+	{
+		FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+		WakeEvent = nullptr;
+	}
+}
+
+bool FTinyEncryptWorker::EnqueueEncrypt(FTinyEncryptJob&& Job)
+{
+	check(Job.TEA != nullptr);
+	if (!EncryptDirection.Requests.Enqueue(MoveTemp(Job)))
+	{
+		return false;
+	}
+
+	if (WakeEvent != nullptr)
+	{
+		WakeEvent->Trigger();
+	}
+	return true;
+}
+
+bool FTinyEncryptWorker::EnqueueDecrypt(FTinyEncryptJob&& Job)
+{
+	check(Job.TEA != nullptr);
+	if (!DecryptDirection.Requests.Enqueue(MoveTemp(Job)))
+	{
+		return false;
+	}
+
+	if (WakeEvent != nullptr)
+	{
+		WakeEvent->Trigger();
+	}
+	return true;
+}
+
+bool FTinyEncryptWorker::DequeueEncrypted(FTinyEncryptJob& OutJob)
+{
+	if (Thread == nullptr)
+	{
+		ProcessDirection(EncryptDirection);
+	}
+	return EncryptDirection.Completions.Dequeue(OutJob);
+}
+
+bool FTinyEncryptWorker::DequeueDecrypted(FTinyEncryptJob& OutJob)
+{
+	if (Thread == nullptr)
+	{
+		ProcessDirection(DecryptDirection);
+	}
+	return DecryptDirection.Completions.Dequeue(OutJob);
+}
+
+uint32 FTinyEncryptWorker::Run()
+{
+	while (!bStopping)
+	{
+		const bool bEncryptBusy = ProcessDirection(EncryptDirection);
+		const bool bDecryptBusy = ProcessDirection(DecryptDirection);
+
+		if (!bEncryptBusy && !bDecryptBusy)
+		{
+			//Poll the full completion rings, otherwise sleep until new requests arrive
+			const bool bHasHeldJob = EncryptDirection.bHasHeldJob || DecryptDirection.bHasHeldJob;
+			WakeEvent->Wait(bHasHeldJob ? 1 : 100);
+		}
+	}
+	return 0;
+}
+
+void FTinyEncryptWorker::Stop()
+{
+	bStopping = true;
+	if (WakeEvent != nullptr)
+	{
+		WakeEvent->Trigger();
+	}
+}
+
+bool FTinyEncryptWorker::ProcessDirection(FDirection& Direction)
+{
+	bool bProcessed = false;
+	for (;;)
+	{
+		if (!Direction.bHasHeldJob)
+		{
+			if (!Direction.Requests.Dequeue(Direction.HeldJob))
+			{
+				break;
+			}
+			ProcessJob(Direction.HeldJob, Direction.bEncrypt);
+			Direction.bHasHeldJob = true;
+		}
+
+		if (!Direction.Completions.Enqueue(MoveTemp(Direction.HeldJob)))
+		{
+			//Wait for the consumer
+			break;
+		}
+		Direction.bHasHeldJob = false;
+		bProcessed = true;
+	}
+	return bProcessed;
+}
+
+void FTinyEncryptWorker::ProcessJob(FTinyEncryptJob& Job, bool bEncrypt)
+{
+	const int32 InLen = Job.Data.Num();
+	if (bEncrypt)
+	{
+		//Grow the buffer to the encrypted length, then encrypt in place
+		Job.Data.SetNumUninitialized(FTinyEncrypt::GetEncryptLength(InLen), TINYENCRYPT_NO_SHRINK);
+		Job.Result = Job.TEA->Encrypt(Job.Data.GetData(), InLen, Job.Data.GetData());
+		return;
+	}
+
+	Job.Result = -1;
+	if (InLen > 0 && (InLen % 8) == 0)
+	{
+		const int32 PlainLen = Job.TEA->Decrypt(Job.Data.GetData(), InLen, Job.Data.GetData());
+		if (PlainLen >= 0 && PlainLen >= InLen - 8 && PlainLen < InLen)
+		{
+			Job.Result = PlainLen;
+		}
+	}
+	Job.Data.SetNum(FMath::Max(Job.Result, 0), TINYENCRYPT_NO_SHRINK);
+}
@@ -0,0 +1,163 @@
+// Copyright (C) 2024 Neo Jin. All Rights Reserved.
+#include "TinyEncryptXXTEA.h"
+#include "TinyEncryptBlock.h"
+
+namespace TinyEncryptXXTEA
+{
+	static constexpr int32 WordSize = 4;
+	static constexpr int32 MinWords = 2;
+	static constexpr int32 MaxPadLen = MinWords * WordSize;
+
+	FORCEINLINE uint32 Mix(uint32 Sum, uint32 Y, uint32 Z, const uint32* Key, int32 P, uint32 E)
+	{
+		return (((Z >> 5) ^ (Y << 2)) + ((Y >> 3) ^ (Z << 4))) ^ ((Sum ^ Y) + (Key[(P & 3) ^ E] ^ Z));
+	}
+
+	FORCEINLINE int32 GetCycles(int32 NumWords)
+	{
+		return 6 + 52 / NumWords;
+	}
+
+	//Convert the big-endian words of the buffer to native words in place, or back. The same swap does both
+	FORCEINLINE void SwapWords(uint8* Buf, int32 NumWords)
+	{
+#if PLATFORM_LITTLE_ENDIAN
+		for (int32 i = 0; i < NumWords; ++i)
+		{
+			uint32 Word;
+			FMemory::Memcpy(&Word, Buf + i * WordSize, WordSize);
+			Word = BYTESWAP_ORDER32(Word);
+			FMemory::Memcpy(Buf + i * WordSize, &Word, WordSize);
+		}
+#endif
+	}
+
+	//Native word access, the buffer may not be 4 bytes aligned
+	FORCEINLINE uint32 GetWord(const uint8* Buf, int32 Index)
+	{
+		uint32 Word;
+		FMemory::Memcpy(&Word, Buf + Index * WordSize, WordSize);
+		return Word;
+	}
+
+	FORCEINLINE uint32 SetWord(uint8* Buf, int32 Index, uint32 Word)
+	{
+		FMemory::Memcpy(Buf + Index * WordSize, &Word, WordSize);
+		return Word;
+	}
+}
+
+FTinyEncryptXXTEA::FTinyEncryptXXTEA(const FUInt128Ex& _Key)
+{
+	TinyEncryptBlock::MakeKey(_Key, Key);
+}
+
+FTinyEncryptXXTEA::~FTinyEncryptXXTEA()
+{
+	//Don't leave the key in memory
+	FMemory::Memzero(Key, sizeof(Key));
+}
+
+int32 FTinyEncryptXXTEA::GetEncryptLength(int32 InLen)
+{
+	using namespace TinyEncryptXXTEA;
+	return FMath::Max((InLen / WordSize + 1) * WordSize, MaxPadLen);
+}
+
+int32 FTinyEncryptXXTEA::GetDecryptLength(int32 InLen)
+{
+	return InLen;
+}
+
+void FTinyEncryptXXTEA::EncryptWords(uint8* Buf, int32 NumWords) const
+{
+	using namespace TinyEncryptXXTEA;
+
+	//The rounds run on native words, the buffer is converted in place once in each direction
+	SwapWords(Buf, NumWords);
+
+	uint32 Sum = 0;
+	uint32 Z = GetWord(Buf, NumWords - 1);
+	for (int32 Cycle = GetCycles(NumWords); Cycle > 0; --Cycle)
+	{
+		Sum += TinyEncryptBlock::Delta;
+		const uint32 E = (Sum >> 2) & 3;
+
+		//Z is the new value of the previous word, Y is the old value of the next word
+		int32 P = 0;
+		for (; P < NumWords - 1; ++P)
+		{
+			Z = SetWord(Buf, P, GetWord(Buf, P) + Mix(Sum, GetWord(Buf, P + 1), Z, Key, P, E));
+		}
+		Z = SetWord(Buf, P, GetWord(Buf, P) + Mix(Sum, GetWord(Buf, 0), Z, Key, P, E));
+	}
+
+	SwapWords(Buf, NumWords);
+}
+
+void FTinyEncryptXXTEA::DecryptWords(uint8* Buf, int32 NumWords) const
+{
+	using namespace TinyEncryptXXTEA;
+
+	SwapWords(Buf, NumWords);
+
+	const int32 Cycles = GetCycles(NumWords);
+	uint32 Sum = (uint32)Cycles * TinyEncryptBlock::Delta;
+	uint32 Y = GetWord(Buf, 0);
+	for (int32 Cycle = Cycles; Cycle > 0; --Cycle)
+	{
+		const uint32 E = (Sum >> 2) & 3;
+
+		//Y is the old value of the next word, Z is the encrypted value of the previous word
+		int32 P = NumWords - 1;
+		for (; P > 0; --P)
+		{
+			Y = SetWord(Buf, P, GetWord(Buf, P) - Mix(Sum, Y, GetWord(Buf, P - 1), Key, P, E));
+		}
+		Y = SetWord(Buf, 0, GetWord(Buf, 0) - Mix(Sum, Y, GetWord(Buf, NumWords - 1), Key, P, E));
+
+		Sum -= TinyEncryptBlock::Delta;
+	}
+
+	SwapWords(Buf, NumWords);
+}
+
+int32 FTinyEncryptXXTEA::Encrypt(const uint8* InBuf, int32 InLen, uint8* OutBuf) const
+{
+	using namespace TinyEncryptXXTEA;
+
+	const int32 OutLen = GetEncryptLength(InLen);
+	const int32 PadLen = OutLen - InLen;
+
+	if (InLen > 0 && InBuf != OutBuf)
+	{
+		FMemory::Memmove(OutBuf, InBuf, InLen);
+	}
+	FMemory::Memset(OutBuf + InLen, (uint8)PadLen, PadLen);
+
+	EncryptWords(OutBuf, OutLen / WordSize);
+	return OutLen;
+}
+
+int32 FTinyEncryptXXTEA::Decrypt(const uint8* InBuf, int32 InLen, uint8* OutBuf) const
+{
+	using namespace TinyEncryptXXTEA;
+
+	if (InBuf == nullptr || InLen < MinWords * WordSize || (InLen % WordSize) != 0)
+	{
+		return -1;
+	}
+
+	if (InBuf != OutBuf)
+	{
+		FMemory::Memmove(OutBuf, InBuf, InLen);
+	}
+	DecryptWords(OutBuf, InLen / WordSize);
+
+	const int32 PadLen = (int32)OutBuf[InLen - 1];
+	if (PadLen < 1 || PadLen > MaxPadLen || PadLen > InLen)
+	{
+		return -1;
+	}
+	return InLen - PadLen;
+}
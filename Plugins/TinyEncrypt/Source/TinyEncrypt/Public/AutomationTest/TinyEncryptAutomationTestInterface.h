@@ -11,5 +11,9 @@
 bool TINYENCRYPT_API TestTinyEncryptUInt128(FString& Detail);
 bool TINYENCRYPT_API TestTinyEncryptExchange(FString& Detail);
 bool TINYENCRYPT_API TestTinyEncryptEncrypt(FString& Detail);
+bool TINYENCRYPT_API TestTinyEncryptSessionTable(FString& Detail);
+bool TINYENCRYPT_API TestTinyEncryptFramer(FString& Detail);
+bool TINYENCRYPT_API TestTinyEncryptWorker(FString& Detail);
+bool TINYENCRYPT_API TestTinyEncryptSocketStream(FString& Detail);
 
 #endif
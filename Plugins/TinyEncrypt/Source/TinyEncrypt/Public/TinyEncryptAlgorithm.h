@@ -3,6 +3,18 @@
 
 #include "CoreMinimal.h"
 #include "TinyEncryptKeyExchange.h"
+#include "TinyEncryptBufferPool.h"
+
+/*
+One message of `FTinyEncrypt::EncryptBatch`/`FTinyEncrypt::DecryptBatch` and the authenticated batch versions
+*/
+struct TINYENCRYPT_API FTinyEncryptBatchItem
+{
+	const uint8* InBuf = nullptr;
+	int32 InLen = 0;
+	uint8* OutBuf = nullptr;	//Should have `GetEncryptLength(InLen)`/`GetDecryptLength(InLen)` bytes
+	int32 OutLen = 0;			//Result length, -1 if the data is invalid
+};
 
 /*
 The Tiny Encryption Algorithm(TEA) Implementation
@@ -17,14 +29,81 @@ public:
 	static int32 GetDecryptLength(int32 InLen);
 
 	//Encrypt data, the length of output buf should get from `GetEncryptLength`
-	int32 Encrypt(const uint8* InBuf, int32 InLen, uint8* OutBuf);
+	int32 Encrypt(const uint8* InBuf, int32 InLen, uint8* OutBuf) const;
 	//Decrypt data
-	int32 Decrypt(const uint8* InBuf, int32 InLen, uint8* OutBuf);
+	int32 Decrypt(const uint8* InBuf, int32 InLen, uint8* OutBuf) const;
+
+	//64-bit length versions for the data larger than 2GB, the output is the same as the int32 versions.
+	//Decrypt64 returns -1 if the length or the padding is invalid
+	static int64 GetEncryptLength64(int64 InLen);
+	static int64 GetDecryptLength64(int64 InLen);
+	int64 Encrypt64(const uint8* InBuf, int64 InLen, uint8* OutBuf) const;
+	int64 Decrypt64(const uint8* InBuf, int64 InLen, uint8* OutBuf) const;
+
+	//Block level pieces of `Encrypt64`/`Decrypt64`, for data processed chunk by chunk or on several threads. The full
+	//blocks go through EncryptBlocks/DecryptBlocks in any order, then the last 0~7 bytes through EncryptTail or the last
+	//block through DecryptTail. InBuf and OutBuf can be the same buffer
+	static constexpr int32 BlockSize = 8;
+	void EncryptBlocks(const uint8* InBuf, uint8* OutBuf, int64 NumBlocks) const;
+	void DecryptBlocks(const uint8* InBuf, uint8* OutBuf, int64 NumBlocks) const;
+	//Encrypt the last 0~7 bytes and the padding into one block, return BlockSize
+	int32 EncryptTail(const uint8* InBuf, int32 InLen, uint8* OutBuf) const;
+	//Decrypt the last block, return the plain length(0~7), or -1 if the padding is invalid
+	int32 DecryptTail(const uint8* InBuf, uint8* OutBuf) const;
+
+	//Encrypt/Decrypt into a buffer of `FTinyEncryptBufferPool`, no allocation and no zero filling when the pool has
+	//a free buffer. DecryptPooled returns an invalid buffer if the length or the padding is invalid
+	FTinyEncryptBuffer EncryptPooled(const uint8* InBuf, int32 InLen) const;
+	FTinyEncryptBuffer DecryptPooled(const uint8* InBuf, int32 InLen) const;
+
+	//Ciphertext stealing mode, no padding block, the encrypted data has the same length as the input data.
+	//The input data should be at least 8 bytes, otherwise return -1
+	static int32 GetEncryptLengthCTS(int32 InLen);
+	static int32 GetDecryptLengthCTS(int32 InLen);
+
+	//Encrypt data in ciphertext stealing mode, InBuf and OutBuf can be the same buffer
+	int32 EncryptCTS(const uint8* InBuf, int32 InLen, uint8* OutBuf) const;
+	//Decrypt data in ciphertext stealing mode, InBuf and OutBuf can be the same buffer
+	int32 DecryptCTS(const uint8* InBuf, int32 InLen, uint8* OutBuf) const;
+
+	//Authenticated mode, an 8 bytes tag computed from the encrypted data is appended after the encrypted data
+	static int32 GetEncryptAndTagLength(int32 InLen);
+	static int32 GetDecryptAndVerifyLength(int32 InLen);
+
+	//Encrypt data and append the tag in one pass, the length of output buf should get from `GetEncryptAndTagLength`
+	int32 EncryptAndTag(const uint8* InBuf, int32 InLen, uint8* OutBuf) const;
+	//Verify the tag, then decrypt data. Return -1 and leave the output buf untouched if the data has been tampered,
+	//InBuf and OutBuf can be the same buffer
+	int32 DecryptAndVerify(const uint8* InBuf, int32 InLen, uint8* OutBuf) const;
+	//Authenticated mode for many messages, 4 messages are processed in parallel lanes. The output of each message is
+	//the same as `EncryptAndTag`/`DecryptAndVerify`, OutBuf should have `GetEncryptAndTagLength(InLen)`/`InLen` bytes
+	void EncryptAndTagBatch(TArrayView<FTinyEncryptBatchItem> Items) const;
+	void DecryptAndVerifyBatch(TArrayView<FTinyEncryptBatchItem> Items) const;
+
+	//Counter mode, the data is XORed with the encrypted counter blocks `InitialCounter + N`, no padding and the output
+	//has the same length as the input. StreamOffset is the byte position in the keystream, a keystream position of
+	//(key, InitialCounter) must never be used for different data. InBuf and OutBuf can be the same buffer
+	int32 EncryptCTR(const uint8* InBuf, int32 InLen, uint8* OutBuf, uint64 InitialCounter, uint64 StreamOffset = 0) const;
+	int32 DecryptCTR(const uint8* InBuf, int32 InLen, uint8* OutBuf, uint64 InitialCounter, uint64 StreamOffset = 0) const;
+
+	//Encrypt/Decrypt many small messages in one call, the blocks of different messages are processed together
+	//to fill the pipeline. The output of each message is the same as `Encrypt`/`Decrypt`
+	void EncryptBatch(TArrayView<FTinyEncryptBatchItem> Items) const;
+	void DecryptBatch(TArrayView<FTinyEncryptBatchItem> Items) const;
+
+	//Encrypt the same data with many keys(e.g. broadcast to many clients), the plain data is loaded once and
+	//several keys are encrypted in parallel lanes. OutBufs[i] is encrypted by Ciphers[i], and should have
+	//`GetEncryptLength(InLen)` bytes, return the encrypted length
+	static int32 EncryptFanOut(const uint8* InBuf, int32 InLen, TArrayView<const FTinyEncrypt> Ciphers, TArrayView<uint8* const> OutBufs);
+
+	//Derive the key of an epoch from the DH secret key, both peers get the same key without a new key exchange.
+	//The derivation is one-way, a leaked epoch key doesn't expose the secret key or the other epoch keys
+	static FUInt128Ex DeriveKey(const FUInt128Ex& SecretKey, uint64 Epoch);
 private:
 	//Encrypt data block(8 bytes)
-	void EncryptBlock(const uint8* InBuf, uint8* OutBuf);
+	void EncryptBlock(const uint8* InBuf, uint8* OutBuf) const;
 	//Decrypt data block(8 bytes)
-	void DecryptBlock(const uint8* InBuf, uint8* OutBuf);
+	void DecryptBlock(const uint8* InBuf, uint8* OutBuf) const;
 
 public:
 	FTinyEncrypt(const FUInt128Ex& _Key);
@@ -0,0 +1,46 @@
+// Copyright (C) 2024 Neo Jin. All Rights Reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Kismet/BlueprintAsyncActionBase.h"
+#include "TinyEncryptKeyExchange.h"
+#include "TinyEncryptAsyncAction.generated.h"
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FTinyEncryptAsyncProgress, float, Progress);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FTinyEncryptAsyncCompleted, const TArray<uint8>&, OutputData, bool, bSuccess);
+
+/*
+Encrypt/Decrypt a large array with TEA on a background thread, the output is the same as `Encrypt With TEA`/`Decrypt With TEA`.
+The array is processed in place in 1MB chunks, OnProgress and OnCompleted are fired on the game thread.
+*/
+UCLASS()
+class TINYENCRYPT_API UTinyEncryptAsyncAction : public UBlueprintAsyncActionBase
+{
+	GENERATED_BODY()
+
+public:
+	//Progress in [0, 1], fired after every chunk and before OnCompleted
+	UPROPERTY(BlueprintAssignable)
+	FTinyEncryptAsyncProgress OnProgress;
+
+	//bSuccess is false and OutputData is empty if the data to decrypt is invalid, or the data to encrypt is close to 2GB
+	UPROPERTY(BlueprintAssignable)
+	FTinyEncryptAsyncCompleted OnCompleted;
+
+	UFUNCTION(BlueprintCallable, Category = "TinyEncrypt", meta = (BlueprintInternalUseOnly = "true", WorldContext = "WorldContextObject", DisplayName = "Encrypt With TEA (Async)"))
+	static UTinyEncryptAsyncAction* EncryptWithTEAAsync(UObject* WorldContextObject, const TArray<uint8>& InputData, const FUInt128Ex& Key);
+
+	UFUNCTION(BlueprintCallable, Category = "TinyEncrypt", meta = (BlueprintInternalUseOnly = "true", WorldContext = "WorldContextObject", DisplayName = "Decrypt With TEA (Async)"))
+	static UTinyEncryptAsyncAction* DecryptWithTEAAsync(UObject* WorldContextObject, const TArray<uint8>& InputData, const FUInt128Ex& Key);
+
+	//For C++ callers, the data is moved instead of copied
+	static UTinyEncryptAsyncAction* Create(UObject* WorldContextObject, TArray<uint8>&& InputData, const FUInt128Ex& Key, bool bDecrypt);
+
+	// UBlueprintAsyncActionBase interface
+	virtual void Activate() override;
+
+private:
+	TArray<uint8> Data;
+	FUInt128Ex Key;
+	bool bDecrypt = false;
+};
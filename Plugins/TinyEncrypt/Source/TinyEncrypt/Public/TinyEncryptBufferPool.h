@@ -0,0 +1,106 @@
+// Copyright (C) 2024 Neo Jin. All Rights Reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+
+/*
+Output buffer from `FTinyEncryptBufferPool`, the memory goes back to the pool when the buffer is destroyed or reset.
+The content is not initialized. Move only.
+The bytes up to the largest length of the buffer are zeroed when it is reset, so decrypted data doesn't stay in the
+free memory. Bytes written past `Num()` without `SetNum` are not zeroed.
+*/
+class TINYENCRYPT_API FTinyEncryptBuffer
+{
+public:
+	FTinyEncryptBuffer() = default;
+	~FTinyEncryptBuffer() { Reset(); }
+
+	FTinyEncryptBuffer(FTinyEncryptBuffer&& Other);
+	FTinyEncryptBuffer& operator=(FTinyEncryptBuffer&& Other);
+	FTinyEncryptBuffer(const FTinyEncryptBuffer&) = delete;
+	FTinyEncryptBuffer& operator=(const FTinyEncryptBuffer&) = delete;
+
+	bool IsValid() const { return Data != nullptr; }
+	uint8* GetData() { return Data; }
+	const uint8* GetData() const { return Data; }
+	int32 Num() const { return Length; }
+	//Size of the memory, a multiple of the TEA block size
+	int32 GetCapacity() const { return Capacity; }
+
+	//Change the length without touching the content, up to the capacity
+	void SetNum(int32 NewLength)
+	{
+		check(NewLength >= 0 && NewLength <= Capacity);
+		Length = NewLength;
+		MaxLength = FMath::Max(MaxLength, NewLength);
+	}
+
+	TArrayView<uint8> GetView() { return TArrayView<uint8>(Data, Length); }
+	TArrayView<const uint8> GetView() const { return TArrayView<const uint8>(Data, Length); }
+
+	//Zero the used bytes and give the memory back to the pool
+	void Reset();
+
+private:
+	friend class FTinyEncryptBufferPool;
+
+	uint8* Data = nullptr;
+	int32 Length = 0;
+	int32 MaxLength = 0;	//Bytes zeroed by Reset
+	int32 Capacity = 0;
+};
+
+/*
+Pool of aligned buffers for the encryption results, avoid the allocation and the zero filling per message.
+
+The sizes are rounded up to power of two size classes(64 bytes ~ 1MB), every thread keeps a few free buffers of
+each class without lock(fewer of the large classes), the rest are shared by all threads. Larger buffers are not pooled.
+
+	FTinyEncryptBuffer Encrypted = TEA.EncryptPooled(Data, DataLen);
+	Send(Encrypted.GetData(), Encrypted.Num());
+	//The memory goes back to the pool here
+*/
+class TINYENCRYPT_API FTinyEncryptBufferPool
+{
+public:
+	static constexpr int32 Alignment = 32;				//Suited to 16/32 bytes SIMD loads
+	static constexpr int32 MinClassSize = 64;
+	static constexpr int32 NumSizeClasses = 15;			//64 bytes ~ 1MB
+	static constexpr int32 MaxPooledSize = MinClassSize << (NumSizeClasses - 1);
+	static constexpr int32 MaxThreadCached = 8;			//Free buffers per class per thread
+	static constexpr int32 MaxThreadCachedBytes = 128 * 1024;	//Free memory per class per thread, at least one buffer
+	static constexpr int32 MaxSharedBytes = 4 * 1024 * 1024;	//Shared free memory per class
+
+	static FTinyEncryptBufferPool& Get();
+
+	//Allocate Size bytes, not initialized
+	FTinyEncryptBuffer Allocate(int32 Size);
+
+	//Free the shared buffers and the buffers cached by the calling thread, the caches of the other threads are kept
+	void Trim();
+
+	//-1 if the size is not pooled
+	static int32 GetSizeClass(int32 Size);
+	static int32 GetClassSize(int32 SizeClass) { return MinClassSize << SizeClass; }
+	//Free buffers of the class kept by one thread
+	static int32 GetMaxThreadCached(int32 SizeClass) { return FMath::Clamp(MaxThreadCachedBytes / GetClassSize(SizeClass), 1, MaxThreadCached); }
+
+private:
+	friend class FTinyEncryptBuffer;
+	friend struct FTinyEncryptBufferThreadCache;
+
+	FTinyEncryptBufferPool() = default;
+
+	void Release(uint8* Data, int32 Capacity);
+
+	//Move buffers between a thread cache and the shared lists
+	int32 TakeShared(int32 SizeClass, void** OutBuffers, int32 MaxCount);
+	void GiveShared(int32 SizeClass, void* const* Buffers, int32 Count);
+
+	struct FSharedBucket
+	{
+		FCriticalSection Lock;
+		TArray<void*> FreeBuffers;
+	};
+	FSharedBucket Buckets[NumSizeClasses];
+};
@@ -0,0 +1,62 @@
+// Copyright (C) 2024 Neo Jin. All Rights Reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TinyEncryptKeyExchange.h"
+
+/*
+Encrypt a stream chunk by chunk, the concatenated output is the same as `FTinyEncrypt::Encrypt` of the whole stream.
+The chunks can have any length, so a multi-GB payload can be read, encrypted and written with a small buffer.
+*/
+class TINYENCRYPT_API FTinyEncryptChunkedEncryptor
+{
+public:
+	explicit FTinyEncryptChunkedEncryptor(const FUInt128Ex& Key);
+	~FTinyEncryptChunkedEncryptor();
+
+	//Max output length of `Update`
+	static int64 GetMaxUpdateLength(int64 InLen) { return InLen + 8; }
+	//Output length of `Finalize`
+	static constexpr int32 FinalizeLength = 8;
+
+	//Encrypt the next chunk, return the output length. The last partial block is kept until the next call
+	int64 Update(const uint8* InBuf, int64 InLen, uint8* OutBuf);
+	//Encrypt the kept data with the padding, then restart a new stream
+	int32 Finalize(uint8* OutBuf);
+
+	//Bytes of input data since the stream start
+	int64 GetTotalInput() const { return TotalInput; }
+
+private:
+	uint32 Schedule[64];	//Round schedule of the key
+	uint8 Pending[8];
+	int32 PendingLen;
+	int64 TotalInput;
+};
+
+/*
+Decrypt a stream encrypted by `FTinyEncrypt::Encrypt` or FTinyEncryptChunkedEncryptor chunk by chunk.
+The last block holds the padding, so it is kept until `Finalize`.
+*/
+class TINYENCRYPT_API FTinyEncryptChunkedDecryptor
+{
+public:
+	explicit FTinyEncryptChunkedDecryptor(const FUInt128Ex& Key);
+	~FTinyEncryptChunkedDecryptor();
+
+	//Max output length of `Update`
+	static int64 GetMaxUpdateLength(int64 InLen) { return InLen + 8; }
+	//Max output length of `Finalize`
+	static constexpr int32 FinalizeLength = 8;
+
+	//Decrypt the next chunk, return the output length
+	int64 Update(const uint8* InBuf, int64 InLen, uint8* OutBuf);
+	//Decrypt the last block and remove the padding, then restart a new stream.
+	//Return the output length, -1 if the stream length or the padding is invalid
+	int32 Finalize(uint8* OutBuf);
+
+private:
+	uint32 Schedule[64];	//Round schedule of the key
+	uint8 Pending[8];
+	int32 PendingLen;
+};
@@ -0,0 +1,48 @@
+// Copyright (C) 2024 Neo Jin. All Rights Reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TinyEncryptKeyExchange.h"
+
+enum class ETinyEncryptCipher : uint8
+{
+	TEA,		//FTinyEncrypt, 8 bytes blocks
+	AES128,		//AES-128, 16 bytes blocks, AES-NI/ARMv8 crypto extension if the CPU supports it, otherwise a software fallback which is not constant-time
+};
+
+/*
+Cipher backend with the same shape as `FTinyEncrypt`, chosen per connection.
+
+The 128-bit DH secret key is used directly as the TEA or AES-128 key, both peers must create the same cipher type.
+Encrypt pads the data to whole blocks(the pad bytes are the pad length, 1~BlockSize bytes) like `FTinyEncrypt::Encrypt`.
+
+	TUniquePtr<ITinyEncryptCipher> Cipher = ITinyEncryptCipher::Create(ETinyEncryptCipher::AES128, SecretKey);
+	Cipher->Encrypt(InBuf, InLen, OutBuf);
+*/
+class TINYENCRYPT_API ITinyEncryptCipher
+{
+public:
+	virtual ~ITinyEncryptCipher() {}
+
+	virtual ETinyEncryptCipher GetCipherType() const = 0;
+	virtual int32 GetBlockSize() const = 0;
+	//True if the cipher runs on the CPU crypto instructions
+	virtual bool IsHardwareAccelerated() const = 0;
+
+	virtual int32 GetEncryptLength(int32 InLen) const = 0;
+	virtual int32 GetDecryptLength(int32 InLen) const = 0;
+
+	//Encrypt data, the length of output buf should get from `GetEncryptLength`, InBuf and OutBuf can be the same buffer
+	virtual int32 Encrypt(const uint8* InBuf, int32 InLen, uint8* OutBuf) const = 0;
+	//Decrypt data, return -1 if the length or the padding is invalid. InBuf and OutBuf can be the same buffer
+	virtual int32 Decrypt(const uint8* InBuf, int32 InLen, uint8* OutBuf) const = 0;
+
+public:
+	//Create the cipher of Type with the key. bAllowHardware = false forces the software implementation
+	static TUniquePtr<ITinyEncryptCipher> Create(ETinyEncryptCipher Type, const FUInt128Ex& Key, bool bAllowHardware = true);
+
+	static int32 GetCipherBlockSize(ETinyEncryptCipher Type);
+	//True if AES-128 runs on the crypto instructions of this CPU. Otherwise AES-128 uses the software fallback, its table
+	//lookups are not constant-time and can leak the key through cache timing, prefer TEA then
+	static bool IsHardwareAESSupported();
+};
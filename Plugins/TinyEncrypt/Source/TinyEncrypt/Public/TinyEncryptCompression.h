@@ -0,0 +1,59 @@
+// Copyright (C) 2024 Neo Jin. All Rights Reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TinyEncryptKeyExchange.h"
+
+/*
+Compress then encrypt in one pass, block by block, into a caller-owned buffer(and the reverse).
+
+Every block is compressed by `FCompression` straight into the output buffer and encrypted in place, so there is
+no intermediate buffer. Blocks which look incompressible(high byte entropy of a sample) or don't get smaller are
+stored without compression. Both sides should use the same compression format.
+
+	FTinyEncryptCompression Pipeline(SecretKey);
+	TArray<uint8> Packed;		//Reused, keeps its memory between calls
+	Pipeline.CompressAndEncrypt(Payload, PayloadLen, Packed);
+	...
+	TArray<uint8> Unpacked;
+	Pipeline.DecryptAndDecompress(Packed.GetData(), Packed.Num(), Unpacked);
+
+Layout: raw size(4 bytes) + block size(4 bytes), then every block: stored length and compressed flag(4 bytes) +
+the stored bytes encrypted with padding(same as `FTinyEncrypt::Encrypt`).
+Not thread-safe: `DecryptAndDecompress` decrypts into a scratch buffer owned by the object, use one object per thread.
+`CompressAndEncrypt` is const and can be called from several threads.
+*/
+class TINYENCRYPT_API FTinyEncryptCompression
+{
+public:
+	static constexpr int32 HeaderSize = 8;
+	static constexpr int32 BlockHeaderSize = 4;
+	static constexpr int32 DefaultBlockSize = 64 * 1024;
+
+	FTinyEncryptCompression(const FUInt128Ex& Key, FName InFormatName = NAME_Zlib, int32 InBlockSize = DefaultBlockSize);
+	~FTinyEncryptCompression();
+
+	//Size of the output buffer needed by `CompressAndEncrypt`, the real output is usually much smaller
+	int32 GetMaxEncodedLength(int32 InLen) const;
+	//The raw size stored in the header, -1 if the data is invalid or InLen can't hold the blocks of the raw size
+	static int32 GetDecodedLength(const uint8* InBuf, int32 InLen);
+
+	//Compress and encrypt InBuf into OutBuf, return the output length, or -1 if OutCapacity is not enough
+	int32 CompressAndEncrypt(const uint8* InBuf, int32 InLen, uint8* OutBuf, int32 OutCapacity) const;
+	//Decrypt and decompress InBuf into OutBuf, return the raw length, or -1 if the data is invalid or OutCapacity is not enough
+	int32 DecryptAndDecompress(const uint8* InBuf, int32 InLen, uint8* OutBuf, int32 OutCapacity);
+
+	//TArray versions, OutData is resized to the result and its allocation is reused. Return false if the data is invalid
+	bool CompressAndEncrypt(const uint8* InBuf, int32 InLen, TArray<uint8>& OutData) const;
+	bool DecryptAndDecompress(const uint8* InBuf, int32 InLen, TArray<uint8>& OutData);
+
+	//Cheap probe: true unless the byte entropy of a sample of the data is close to random data
+	static bool IsLikelyCompressible(const uint8* Data, int32 Len);
+
+private:
+	FName FormatName;
+	int32 BlockSize;
+	uint32 Schedule[64];		//Round schedule of the key
+
+	TArray<uint8> Scratch;		//Decrypted compressed block, reused
+};
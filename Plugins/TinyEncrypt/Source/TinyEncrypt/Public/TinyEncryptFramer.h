@@ -0,0 +1,63 @@
+// Copyright (C) 2024 Neo Jin. All Rights Reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TinyEncryptAlgorithm.h"
+
+/*
+Settings of FTinyEncryptFramer
+*/
+struct TINYENCRYPT_API FTinyEncryptFrameSettings
+{
+	//Max length of an encrypted frame, a message which can't fit in an empty frame is rejected
+	int32 MaxFrameSize = 1024;
+	//Encrypt the pending messages when the plain frame reaches this length, 0 means only flush when the frame is full or `Flush` is called
+	int32 FlushSize = 0;
+	//Encrypt the pending messages when the frame has this many messages, 0 means no limit
+	int32 MaxMessagesPerFrame = 0;
+};
+
+/*
+Coalesce small messages into frames, each frame is encrypted once.
+
+Plain frame: [varint length][message] [varint length][message] ...
+The frame is padded once by `FTinyEncrypt::Encrypt`, instead of once per message.
+*/
+class TINYENCRYPT_API FTinyEncryptFramer
+{
+public:
+	FTinyEncryptFramer(const FTinyEncrypt& InTEA, const FTinyEncryptFrameSettings& InSettings = FTinyEncryptFrameSettings());
+
+	//Append a message to the pending frame, the pending frame is flushed first if the message doesn't fit.
+	//Return false if the message is larger than an empty frame
+	bool AddMessage(const uint8* Data, int32 Len);
+	//Encrypt the pending messages into a frame(e.g. at the end of the tick), return false if nothing is pending
+	bool Flush();
+
+	int32 GetPendingMessages() const { return PendingMessages; }
+	int32 GetPendingSize() const { return NumFrames < Frames.Num() ? Frames[NumFrames].Num() : 0; }
+	//Max plain length of a message which fits in an empty frame
+	int32 GetMaxMessageSize() const;
+
+	//Encrypted frames ready to send
+	int32 GetNumFrames() const { return NumFrames; }
+	TArrayView<const uint8> GetFrame(int32 Index) const { return Frames[Index]; }
+	//Remove the sent frames, the frame buffers are kept for reuse
+	void ClearFrames();
+
+	//Decrypt a received frame in place, and split it into messages. The messages point into the frame buffer,
+	//valid until the frame buffer is modified. Return false if the frame is invalid
+	static bool SplitFrame(const FTinyEncrypt& TEA, uint8* Frame, int32 FrameLen, TArray<TArrayView<const uint8>>& OutMessages);
+
+private:
+	TArray<uint8>& GetPendingFrame();
+
+private:
+	FTinyEncrypt TEA;
+	FTinyEncryptFrameSettings Settings;
+	int32 MaxPlainSize;		//Max length of a plain frame, at least one padding byte is needed
+
+	TArray<TArray<uint8>> Frames;	//Frames[0, NumFrames) are encrypted, Frames[NumFrames] is the pending frame
+	int32 NumFrames;
+	int32 PendingMessages;
+};
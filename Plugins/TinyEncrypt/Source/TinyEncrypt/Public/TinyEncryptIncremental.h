@@ -0,0 +1,73 @@
+// Copyright (C) 2024 Neo Jin. All Rights Reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TinyEncryptKeyExchange.h"
+
+/*
+Position-independent encryption of a large blob, with dirty-range tracking.
+
+Every 8-byte block is encrypted in XEX mode, C = E(P ^ T) ^ T, where the tweak T is the encrypted block position
+under a tweak key derived from Key. Any block range can be decrypted or re-encrypted alone, and re-encrypting a
+block with new data doesn't expose the XOR of the old and new data like a reused counter mode keystream would.
+Ranges are widened to whole blocks. If the blob length is not a multiple of 8, the last full block and the tail
+are encrypted together with ciphertext stealing.
+Mark the modified ranges with `MarkDirty`, then `Flush` re-encrypts only those ranges.
+
+	//Keep a plain copy and an encrypted copy
+	Tracker.MarkDirty(Offset, Len);
+	Tracker.Flush(PlainBlob, EncryptedBlob);
+
+	//Or modify the encrypted blob in place
+	Tracker.DecryptRange(Blob, Offset, Len);
+	... modify Blob[Offset, Offset + Len) ...
+	Tracker.MarkDirty(Offset, Len);
+	Tracker.Flush(Blob, Blob);
+*/
+class TINYENCRYPT_API FTinyEncryptIncremental
+{
+public:
+	//The blob should be at least 8 bytes. Never use the same (Key, InitialCounter) for two different blobs
+	FTinyEncryptIncremental(const FUInt128Ex& Key, uint64 InitialCounter, int64 InBlobSize);
+	~FTinyEncryptIncremental();
+
+	//Encrypt/Decrypt the widened range of [Offset, Offset + Len), from InBlob to OutBlob, they can be the same buffer.
+	//All the bytes of the widened range are read from InBlob
+	void EncryptRange(const uint8* InBlob, uint8* OutBlob, int64 Offset, int64 Len) const;
+	void DecryptRange(const uint8* InBlob, uint8* OutBlob, int64 Offset, int64 Len) const;
+	//In place version
+	void EncryptRange(uint8* Blob, int64 Offset, int64 Len) const { EncryptRange(Blob, Blob, Offset, Len); }
+	void DecryptRange(uint8* Blob, int64 Offset, int64 Len) const { DecryptRange(Blob, Blob, Offset, Len); }
+
+	//Mark the bytes [Offset, Offset + Len) modified, the range is widened to whole blocks, overlapped and adjacent
+	//ranges are merged
+	void MarkDirty(int64 Offset, int64 Len);
+	bool IsDirty() const { return DirtyRanges.Num() > 0; }
+	int64 GetDirtyBytes() const;
+	void ClearDirty() { DirtyRanges.Reset(); }
+
+	//Encrypt the dirty ranges of the plain blob into the encrypted blob, then clear the dirty ranges.
+	//PlainBlob and EncryptedBlob can be the same buffer. Return the bytes encrypted
+	int64 Flush(const uint8* PlainBlob, uint8* EncryptedBlob);
+
+	int64 GetBlobSize() const { return BlobSize; }
+
+private:
+	struct FRange
+	{
+		int64 Begin;
+		int64 End;
+	};
+
+	//Range of whole blocks, the last full block and the tail are always in the same range
+	FRange WidenRange(int64 Offset, int64 Len) const;
+	template<bool bEncrypt>
+	void CryptRange(const uint8* InBlob, uint8* OutBlob, const FRange& Range) const;
+
+	uint32 Schedule[64];		//Round schedule of the key
+	uint32 TweakSchedule[64];	//Round schedule of the tweak key
+	uint64 InitialCounter;
+	int64 BlobSize;
+
+	TArray<FRange> DirtyRanges;		//Sorted, never overlapped or adjacent
+};
@@ -121,13 +121,30 @@ public:
 	//return A^B mod P
 	static FUInt128Ex PowerModP(FUInt128Ex A, const FUInt128Ex& B);
 
+	//Constant time version, the running time doesn't depend on the values of A and B:
+	//fixed 128 iterations, conditional add/swap by masks instead of branches
+	//return A*B mod P
+	static FUInt128Ex MulModPConstantTime(const FUInt128Ex& A, const FUInt128Ex& B);
+	//return A^B mod P, Montgomery ladder
+	static FUInt128Ex PowerModPConstantTime(const FUInt128Ex& A, const FUInt128Ex& B);
+
 	// Serialization
 	friend FArchive& operator<<(FArchive& Ar, FUInt128Ex& Value)
 	{
 		return Ar << Value.Hi << Value.Lo;
 	}
 
+	// Network serialization, always 16 bytes
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+
 public:
+	static constexpr int32 ByteSize = 16;
+
+	// Write 16 bytes big-endian, same as `ToArray`
+	void WriteBytes(uint8 OutBytes[ByteSize]) const;
+	// Read 16 bytes big-endian, same as `MakeFromArray` of 16 bytes
+	void ReadBytes(const uint8 InBytes[ByteSize]);
+
 	// Convert to TArray<uint8>
 	TArray<uint8> ToArray() const;
 	// Make from TArray<uint8>
@@ -143,6 +160,26 @@ public:
 	// Make from Base64
 	void MakeFromBase64(const FString& Base64String);
 
+	// Fixed length text codecs, write to or parse from a char buffer without allocation
+	static constexpr int32 HexLength = 32;		//Lower case hex chars
+	static constexpr int32 Base64Length = 24;	//Base64 of 16 bytes big-endian, with padding
+
+	// Write `HexLength` chars, no null terminator
+	void ToHexChars(TCHAR* OutChars) const;
+	// Same rules as `MakeFromHexString`, return false and make zero if the chars are invalid
+	bool MakeFromHexChars(const TCHAR* Chars, int32 Len);
+	// Write `Base64Length` chars, no null terminator
+	void ToBase64Chars(TCHAR* OutChars) const;
+	// Same rules as `MakeFromBase64`, return false and make zero if the chars are invalid
+	bool MakeFromBase64Chars(const TCHAR* Chars, int32 Len);
+
+	// Batch version, OutChars should have `Values.Num() * HexLength`(or `Base64Length`) chars
+	static void ToHexChars(TArrayView<const FUInt128Ex> Values, TCHAR* OutChars);
+	static void ToBase64Chars(TArrayView<const FUInt128Ex> Values, TCHAR* OutChars);
+	// Batch version, Chars has `OutValues.Num()` fixed length values, return the number of valid values
+	static int32 MakeFromHexChars(const TCHAR* Chars, TArrayView<FUInt128Ex> OutValues);
+	static int32 MakeFromBase64Chars(const TCHAR* Chars, TArrayView<FUInt128Ex> OutValues);
+
 public:
 	static const FUInt128Ex Zero;		//Zero value
 
@@ -152,6 +189,22 @@ public:
 	static const FUInt128Ex G;			// A small prime number G = 5
 };
 
+template<>
+struct TStructOpsTypeTraits<FUInt128Ex> : public TStructOpsTypeTraitsBase2<FUInt128Ex>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
+
+//Exponentiation used by FDiffieHellmanKeyPair, both give the same keys
+enum class EDiffieHellmanPowerMode : uint8
+{
+	Fast,			//Square and multiply, the time depends on the key bits
+	ConstantTime,	//Montgomery ladder, the same time for every key, no timing side channel
+};
+
 USTRUCT(BlueprintType, meta = (
 	HasNativeMake  = "/Script/TinyEncrypt.TinyEncryptUtilities.MakeRandomDHKeyPair",
 	HasNativeBreak = "/Script/TinyEncrypt.TinyEncryptUtilities.BreakDHKeyPair"))
@@ -164,20 +217,25 @@ public:
 	FUInt128Ex PrivateKey;
 
 public:
-	FORCEINLINE void GenerateRandomKeyPair()
+	FORCEINLINE void GenerateRandomKeyPair(EDiffieHellmanPowerMode Mode = EDiffieHellmanPowerMode::Fast)
 	{
 		//Generate random private key
 		PrivateKey.MakeRandom();
 
 		//Generate public key from private key 
 		// PublicKey = G^PrivateKey mod P
-		PublicKey = FUInt128Ex::PowerModP(FUInt128Ex::G, PrivateKey);
+		PublicKey = Power(FUInt128Ex::G, PrivateKey, Mode);
 	}
 
-	FORCEINLINE FUInt128Ex GenerateSecretKey(const FUInt128Ex& AnotherPublicKey)
+	FORCEINLINE FUInt128Ex GenerateSecretKey(const FUInt128Ex& AnotherPublicKey, EDiffieHellmanPowerMode Mode = EDiffieHellmanPowerMode::Fast)
 	{
 		// SecretKey = AnotherPublicKey^PrivateKey mod P
-		return FUInt128Ex::PowerModP(AnotherPublicKey, PrivateKey);
+		return Power(AnotherPublicKey, PrivateKey, Mode);
+	}
+
+	FORCEINLINE static FUInt128Ex Power(const FUInt128Ex& A, const FUInt128Ex& B, EDiffieHellmanPowerMode Mode)
+	{
+		return (Mode == EDiffieHellmanPowerMode::ConstantTime) ? FUInt128Ex::PowerModPConstantTime(A, B) : FUInt128Ex::PowerModP(A, B);
 	}
 
 public:
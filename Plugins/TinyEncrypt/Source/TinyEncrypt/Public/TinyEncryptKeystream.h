@@ -0,0 +1,52 @@
+// Copyright (C) 2024 Neo Jin. All Rights Reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TinyEncryptKeyExchange.h"
+#include <atomic>
+
+/*
+Precomputed counter mode keystream of one session, the output is the same as `FTinyEncrypt::EncryptCTR`.
+
+The keystream doesn't depend on the data, so it is generated ahead into a ring buffer, and encryption on the
+send path is only a XOR. When the ready keystream is less than the low watermark, a background task refills
+the ring(only if the object is owned by a TSharedPtr, e.g. created by MakeShared), or call `Refill` on idle.
+If the ring runs out, the missing keystream is computed inline.
+
+`Encrypt`/`Decrypt` must be called from one thread, `Refill` can be called from any thread.
+*/
+class TINYENCRYPT_API FTinyEncryptKeystream : public TSharedFromThis<FTinyEncryptKeystream, ESPMode::ThreadSafe>
+{
+public:
+	//Capacity is rounded up to a power of two
+	FTinyEncryptKeystream(const FUInt128Ex& Key, uint64 InitialCounter, int32 Capacity = 16 * 1024, int32 LowWatermark = 4 * 1024);
+	~FTinyEncryptKeystream();
+
+	//Encrypt data with the next keystream bytes and advance the cursor, return the stream offset of the data
+	//which is needed by `FTinyEncrypt::DecryptCTR`. InBuf and OutBuf can be the same buffer
+	uint64 Encrypt(const uint8* InBuf, int32 InLen, uint8* OutBuf);
+	//Decrypt data of a stream which is received in order
+	uint64 Decrypt(const uint8* InBuf, int32 InLen, uint8* OutBuf) { return Encrypt(InBuf, InLen, OutBuf); }
+
+	//Generate the keystream until the ring is full, do nothing if another refill is running
+	void Refill();
+
+	uint64 GetStreamOffset() const { return ReadPos.load(std::memory_order_relaxed); }
+	//Precomputed bytes after the cursor
+	int64 GetReadyBytes() const;
+
+private:
+	void RefillAsync();
+
+private:
+	uint32 Schedule[64];		//Round schedule of the key
+	uint64 InitialCounter;
+
+	TArray<uint8> Ring;
+	int64 Capacity;
+	int64 LowWatermark;
+
+	std::atomic<uint64> ReadPos;	//Stream offset of the cursor, written by the consumer
+	std::atomic<uint64> WritePos;	//Keystream before this offset is ready, written by the refill
+	std::atomic<bool> bRefilling;
+};
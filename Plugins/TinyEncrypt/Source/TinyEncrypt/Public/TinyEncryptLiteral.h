@@ -0,0 +1,186 @@
+// Copyright (C) 2024 Neo Jin. All Rights Reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TinyEncryptAlgorithm.h"
+#include <type_traits>
+
+/*
+String/byte literals encrypted at compile time, decrypted on first access.
+
+	const TCHAR* Endpoint = *TINYENCRYPT_LITERAL(TEXT("https://example.com/login"));
+	const auto& Blob = TINYENCRYPT_LITERAL("\x12\x34\x00\x56");
+	Blob.GetBytes(); Blob.NumBytes();
+
+Only the encrypted bytes(`FTinyEncrypt::Encrypt` format) are stored in the binary. The first access decrypts into
+a static buffer(thread-safe), the next accesses return the same buffer. The key of every literal is derived from
+TINYENCRYPT_LITERAL_SEED and its position in the source, define your own seed in the Build.cs of your project:
+	PublicDefinitions.Add("TINYENCRYPT_LITERAL_SEED=0x0123456789abcdefULL");
+It hides the literals from string scanning, the key is in the same binary, so it is not a protection for secrets.
+Keep the literals short(up to a few hundred bytes), they are encrypted by the compiler.
+*/
+#ifndef TINYENCRYPT_LITERAL_SEED
+	#define TINYENCRYPT_LITERAL_SEED 0x9e3779b97f4a7c15ULL
+#endif
+
+namespace TinyEncryptLiteral
+{
+	struct FKey
+	{
+		uint64 Hi = 0;
+		uint64 Lo = 0;
+	};
+
+	template<int32 NumBytes>
+	struct TEncrypted
+	{
+		static constexpr int32 EncryptLength = (NumBytes / 8) * 8 + 8;
+
+		uint8 Data[EncryptLength] = {};
+		FKey Key;
+	};
+
+	constexpr uint64 Mix(uint64 Value)
+	{
+		//splitmix64 finalizer
+		Value = (Value ^ (Value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		Value = (Value ^ (Value >> 27)) * 0x94d049bb133111ebULL;
+		return Value ^ (Value >> 31);
+	}
+
+	constexpr FKey MakeKey(const char* File, int32 Line, int32 Counter)
+	{
+		//FNV-1a of the file name
+		uint64 Hash = 0xcbf29ce484222325ULL;
+		for (; *File != 0; ++File)
+		{
+			Hash = (Hash ^ (uint8)*File) * 0x100000001b3ULL;
+		}
+
+		FKey Key;
+		Key.Hi = Mix(Hash ^ TINYENCRYPT_LITERAL_SEED ^ ((uint64)Line << 32));
+		Key.Lo = Mix(Key.Hi ^ (uint64)Counter ^ TINYENCRYPT_LITERAL_SEED);
+		return Key;
+	}
+
+	//Same as `FTinyEncrypt::EncryptBlock`
+	constexpr void EncryptBlock(const uint32 (&Key)[4], uint8* Block)
+	{
+		uint32 V0 = ((uint32)Block[0] << 24) | ((uint32)Block[1] << 16) | ((uint32)Block[2] << 8) | (uint32)Block[3];
+		uint32 V1 = ((uint32)Block[4] << 24) | ((uint32)Block[5] << 16) | ((uint32)Block[6] << 8) | (uint32)Block[7];
+
+		uint32 Sum = 0;
+		for (int32 i = 0; i < 32; ++i)
+		{
+			V0 += (((V1 << 4) ^ (V1 >> 5)) + V1) ^ (Sum + Key[Sum & 3]);
+			Sum += 0x9E3779B9;
+			V1 += (((V0 << 4) ^ (V0 >> 5)) + V0) ^ (Sum + Key[(Sum >> 11) & 3]);
+		}
+
+		for (int32 i = 0; i < 4; ++i)
+		{
+			Block[i] = (uint8)(V0 >> (24 - i * 8));
+			Block[4 + i] = (uint8)(V1 >> (24 - i * 8));
+		}
+	}
+
+	//Encrypt the chars(including the terminator) in memory layout, the output is the same as `FTinyEncrypt::Encrypt`
+	template<typename CharType, int32 N>
+	constexpr TEncrypted<N * (int32)sizeof(CharType)> Encrypt(const CharType (&Str)[N], const FKey& Key)
+	{
+		constexpr int32 NumBytes = N * (int32)sizeof(CharType);
+		TEncrypted<NumBytes> Result;
+		Result.Key = Key;
+
+		for (int32 i = 0; i < N; ++i)
+		{
+			const uint64 Char = (uint64)(typename std::make_unsigned<CharType>::type)Str[i];
+			for (int32 Byte = 0; Byte < (int32)sizeof(CharType); ++Byte)
+			{
+#if PLATFORM_LITTLE_ENDIAN
+				const int32 Shift = Byte * 8;
+#else
+				const int32 Shift = ((int32)sizeof(CharType) - 1 - Byte) * 8;
+#endif
+				Result.Data[i * (int32)sizeof(CharType) + Byte] = (uint8)(Char >> Shift);
+			}
+		}
+
+		//Pad bytes are the pad length
+		const int32 PadLen = Result.EncryptLength - NumBytes;
+		for (int32 i = NumBytes; i < Result.EncryptLength; ++i)
+		{
+			Result.Data[i] = (uint8)PadLen;
+		}
+
+		const uint32 KeyWords[4] = { (uint32)Key.Lo, (uint32)(Key.Lo >> 32), (uint32)Key.Hi, (uint32)(Key.Hi >> 32) };
+		for (int32 i = 0; i < Result.EncryptLength; i += 8)
+		{
+			EncryptBlock(KeyWords, Result.Data + i);
+		}
+		return Result;
+	}
+}
+
+/*
+The decrypted literal, N chars including the terminator
+*/
+template<typename CharType, int32 N>
+class TTinyEncryptLiteral
+{
+public:
+	using FEncrypted = TinyEncryptLiteral::TEncrypted<N * (int32)sizeof(CharType)>;
+
+	explicit TTinyEncryptLiteral(const FEncrypted& Encrypted)
+	{
+		uint8 Plain[FEncrypted::EncryptLength];
+		FTinyEncrypt TEA(FUInt128Ex(Encrypted.Key.Hi, Encrypted.Key.Lo));
+		const int32 PlainLen = TEA.Decrypt(Encrypted.Data, FEncrypted::EncryptLength, Plain);
+		check(PlainLen == (int32)sizeof(Chars));
+
+		FMemory::Memcpy(Chars, Plain, sizeof(Chars));
+		FMemory::Memzero(Plain, sizeof(Plain));
+	}
+
+	~TTinyEncryptLiteral()
+	{
+		FMemory::Memzero(Chars, sizeof(Chars));
+	}
+
+	TTinyEncryptLiteral(const TTinyEncryptLiteral&) = delete;
+	TTinyEncryptLiteral& operator=(const TTinyEncryptLiteral&) = delete;
+
+	const CharType* operator*() const { return Chars; }
+	const CharType* GetData() const { return Chars; }
+	//Number of chars, not including the terminator
+	int32 Len() const { return N - 1; }
+
+	//The chars as bytes, not including the terminator
+	const uint8* GetBytes() const { return (const uint8*)Chars; }
+	int32 NumBytes() const { return (N - 1) * (int32)sizeof(CharType); }
+
+private:
+	CharType Chars[N];
+};
+
+namespace TinyEncryptLiteral
+{
+	template<typename ArrayType>
+	struct TLiteralOf;
+
+	template<typename CharType, int32 N>
+	struct TLiteralOf<const CharType(&)[N]>
+	{
+		using Type = TTinyEncryptLiteral<CharType, N>;
+	};
+}
+
+//Encrypt a string literal at compile time, return `const TTinyEncryptLiteral&` which is decrypted on first access.
+//The plain literal is only used in constant expressions, so it isn't stored in the binary
+#define TINYENCRYPT_LITERAL(Str) \
+	([]() -> const typename TinyEncryptLiteral::TLiteralOf<decltype(Str)>::Type& \
+	{ \
+		static constexpr auto Encrypted = TinyEncryptLiteral::Encrypt(Str, TinyEncryptLiteral::MakeKey(__FILE__, __LINE__, __COUNTER__)); \
+		static const typename TinyEncryptLiteral::TLiteralOf<decltype(Str)>::Type Literal(Encrypted); \
+		return Literal; \
+	}())
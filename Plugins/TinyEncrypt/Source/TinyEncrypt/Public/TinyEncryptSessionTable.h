@@ -0,0 +1,83 @@
+// Copyright (C) 2024 Neo Jin. All Rights Reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TinyEncryptKeyExchange.h"
+
+/*
+Handle of a session in FTinyEncryptSessionTable, a removed session's handle never becomes valid again
+*/
+struct TINYENCRYPT_API FTinyEncryptSessionHandle
+{
+	uint32 Index;
+	uint32 Generation;	//0 means invalid handle
+
+	FTinyEncryptSessionHandle() : Index(0), Generation(0) {}
+	FTinyEncryptSessionHandle(uint32 InIndex, uint32 InGeneration) : Index(InIndex), Generation(InGeneration) {}
+
+	FORCEINLINE bool IsValid() const { return Generation != 0; }
+	FORCEINLINE bool operator==(const FTinyEncryptSessionHandle& Other) const { return Index == Other.Index && Generation == Other.Generation; }
+};
+
+/*
+One packet of a batch call, OutBuf must have `FTinyEncrypt::GetEncryptLength(InLen)` bytes for encrypt
+*/
+struct TINYENCRYPT_API FTinyEncryptSessionPacket
+{
+	FTinyEncryptSessionHandle Session;
+	const uint8* InBuf = nullptr;
+	int32 InLen = 0;
+	uint8* OutBuf = nullptr;
+	int32 OutLen = 0;		//Result length, -1 if the session or the data is invalid
+};
+
+/*
+TEA cipher contexts of many connections.
+
+Sessions are stored in slots of structure-of-arrays, the round schedules of all sessions are packed in
+one continuous array, so the batch calls touch only the schedule of the packets' sessions.
+The output is the same as `FTinyEncrypt` with the same key.
+*/
+class TINYENCRYPT_API FTinyEncryptSessionTable
+{
+public:
+	FTinyEncryptSessionTable() = default;
+	explicit FTinyEncryptSessionTable(int32 InitialCapacity);
+
+	//Add a session, the removed slots are reused first. Return the handle of the session
+	FTinyEncryptSessionHandle Add(uint64 ConnectionId, const FUInt128Ex& Key);
+	//Remove a session, return false if the handle is invalid
+	bool Remove(FTinyEncryptSessionHandle Handle);
+	//Replace the key of a session
+	bool SetKey(FTinyEncryptSessionHandle Handle, const FUInt128Ex& Key);
+
+	bool IsValid(FTinyEncryptSessionHandle Handle) const;
+	//Find the session of the connection, return invalid handle if not exist
+	FTinyEncryptSessionHandle Find(uint64 ConnectionId) const;
+	int32 Num() const { return ConnectionIndex.Num(); }
+
+public:
+	//Encrypt data with the session key, return -1 if the handle is invalid
+	int32 Encrypt(FTinyEncryptSessionHandle Handle, const uint8* InBuf, int32 InLen, uint8* OutBuf) const;
+	//Decrypt data with the session key, return -1 if the handle or the data is invalid
+	int32 Decrypt(FTinyEncryptSessionHandle Handle, const uint8* InBuf, int32 InLen, uint8* OutBuf) const;
+
+	//Encrypt/Decrypt the outbound/inbound packets of many sessions in one pass.
+	//Packets of the same session should be adjacent to reuse the cached schedule.
+	void EncryptBatch(TArrayView<FTinyEncryptSessionPacket> Packets) const;
+	void DecryptBatch(TArrayView<FTinyEncryptSessionPacket> Packets) const;
+
+	//Encrypt the same data for many sessions(broadcast), OutBufs[i] is encrypted by Sessions[i].
+	//Return the encrypted length, the output of invalid sessions is untouched
+	int32 EncryptFanOut(const uint8* InBuf, int32 InLen, TArrayView<const FTinyEncryptSessionHandle> Sessions, TArrayView<uint8* const> OutBufs) const;
+
+private:
+	const uint32* GetSchedule(FTinyEncryptSessionHandle Handle) const;
+
+private:
+	TArray<uint32> Schedules;		//Round schedule of each slot
+	TArray<uint32> Generations;		//Generation of each slot, odd value means the slot is in use
+	TArray<uint64> ConnectionIds;	//Connection id of each slot
+	TArray<uint32> FreeSlots;		//Removed slots, reused first
+	TMap<uint64, uint32> ConnectionIndex;
+};
@@ -0,0 +1,47 @@
+// Copyright (C) 2024 Neo Jin. All Rights Reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TinyEncryptKeyExchange.h"
+#include "TinyEncryptAlgorithm.h"
+
+/*
+Session resumption ticket, an authenticated encrypted block of (secret key, expire time).
+The server gives it to the client after the DH key exchange, the client presents it on reconnect,
+then the server recovers the secret key without a new key exchange.
+*/
+struct TINYENCRYPT_API FTinyEncryptTicket
+{
+	static constexpr int32 PlainSize = 16 + 8;		//SecretKey + ExpireTime
+	static constexpr int32 Size = 40;				//FTinyEncrypt::GetEncryptAndTagLength(PlainSize)
+
+	uint8 Data[Size];
+};
+
+/*
+Issue and validate tickets with a server side key only known by the servers.
+The issuer is immutable after construction, one issuer can be shared by all threads without lock.
+Create a new issuer to rotate the ticket key.
+*/
+class TINYENCRYPT_API FTinyEncryptTicketIssuer
+{
+public:
+	explicit FTinyEncryptTicketIssuer(const FUInt128Ex& TicketKey);
+
+	//Issue a ticket, ExpireTime is a unix timestamp in seconds
+	void IssueTicket(const FUInt128Ex& SecretKey, int64 ExpireTime, FTinyEncryptTicket& OutTicket) const;
+	//Validate a ticket, return false if the ticket is tampered or expired
+	bool ValidateTicket(const FTinyEncryptTicket& Ticket, int64 Now, FUInt128Ex& OutSecretKey) const;
+
+	//Batch version, the tickets are encrypted in parallel with the cipher schedules built once.
+	//OutTickets should have the same number of elements as SecretKeys
+	void IssueTickets(TArrayView<const FUInt128Ex> SecretKeys, int64 ExpireTime, TArrayView<FTinyEncryptTicket> OutTickets) const;
+	//Batch version, return the number of valid tickets, the secret key of an invalid ticket is zero
+	int32 ValidateTickets(TArrayView<const FTinyEncryptTicket> Tickets, int64 Now, TArrayView<FUInt128Ex> OutSecretKeys) const;
+
+	//Current unix timestamp in seconds
+	static int64 GetNow();
+
+private:
+	FTinyEncrypt TicketTEA;
+};
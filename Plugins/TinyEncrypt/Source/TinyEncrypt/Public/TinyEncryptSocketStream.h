@@ -0,0 +1,86 @@
+// Copyright (C) 2024 Neo Jin. All Rights Reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TinyEncryptCipher.h"
+
+class FSocket;
+
+//Result of `FTinyEncryptSocketStream::Send`
+enum class ETinyEncryptSendResult : uint8
+{
+	Queued,			//The message is in the send buffer, it goes out with the next `Flush`
+	WouldBlock,		//The send buffer is full and the socket can't take more now, try again after a later `Flush`
+	TooLarge,		//The message is larger than MaxMessageSize, it will never fit
+	Failed,			//The socket failed, drop the connection
+};
+
+/*
+Settings of FTinyEncryptSocketStream
+*/
+struct TINYENCRYPT_API FTinyEncryptSocketStreamSettings
+{
+	//Max plain length of a message, a larger received frame is rejected
+	int32 MaxMessageSize = 64 * 1024;
+	//Encrypted frames wait in the send buffer until `Flush`, at least one frame of MaxMessageSize
+	int32 SendBufferSize = 256 * 1024;
+	//Received bytes are decrypted in the receive buffer, at least one frame of MaxMessageSize
+	int32 ReceiveBufferSize = 256 * 1024;
+};
+
+/*
+Encrypted message stream over a connected TCP socket, the stream owns the session cipher.
+
+Frame on the wire: [uint32 encrypted length, little endian][encrypted message]
+Messages are encrypted straight into the send buffer, `Flush` sends all the buffered frames with as few `FSocket::Send`
+calls as possible. Received frames are decrypted in place in the receive buffer, no temporary arrays.
+
+	if (Stream.Send(Data, Len) == ETinyEncryptSendResult::WouldBlock)
+	{
+		//The peer reads slower than we send, keep the message and send it later
+	}
+	Stream.Flush();		//e.g. at the end of the tick
+
+	TArray<TArrayView<const uint8>> Messages;
+	if (!Stream.Receive(Messages))
+	{
+		//Closed or invalid frame, drop the connection
+	}
+*/
+class TINYENCRYPT_API FTinyEncryptSocketStream
+{
+public:
+	static constexpr int32 HeaderSize = 4;
+
+	//The socket is not owned, it is switched to non-blocking mode. Both peers should create the same cipher type
+	FTinyEncryptSocketStream(FSocket* InSocket, TUniquePtr<ITinyEncryptCipher>&& InCipher, const FTinyEncryptSocketStreamSettings& InSettings = FTinyEncryptSocketStreamSettings());
+
+	//Encrypt a message into the send buffer, the send buffer is flushed first if the frame doesn't fit.
+	//The message is not queued unless the result is Queued
+	ETinyEncryptSendResult Send(const uint8* Data, int32 Len);
+	//Send the buffered frames, return false if the socket failed. The bytes which would block stay in the send buffer
+	bool Flush();
+	int32 GetPendingSendBytes() const { return SendEnd - SendBegin; }
+
+	//Read the available bytes without blocking, and decrypt the complete frames in place. The messages point into the
+	//receive buffer, valid until the next Receive. Return false if a frame is invalid, or the connection is closed and
+	//there is no message left: the frames which arrived before the close are returned first, the close by the next call
+	bool Receive(TArray<TArrayView<const uint8>>& OutMessages);
+
+	const ITinyEncryptCipher& GetCipher() const { return *Cipher; }
+
+private:
+	FSocket* Socket;
+	TUniquePtr<ITinyEncryptCipher> Cipher;
+	FTinyEncryptSocketStreamSettings Settings;
+	int32 MaxFrameSize;		//Header and the encrypted message of MaxMessageSize
+
+	TArray<uint8> SendBuffer;
+	int32 SendBegin;		//First unsent byte
+	int32 SendEnd;
+
+	TArray<uint8> ReceiveBuffer;
+	int32 ReceiveBegin;		//First byte of the incomplete frame
+	int32 ReceiveEnd;
+	bool bClosed;			//Recv failed, no more bytes will arrive
+};
@@ -60,9 +60,25 @@ public:
 		return FUInt128Ex::PowerModP(AnotherPublicKey, PrivateKey);
 	}
 
+	//Derive the TEA key of an epoch from the DH secret key, used to rotate the session key without a new key exchange
+	UFUNCTION(BlueprintPure, Category = "TinyEncrypt", DisplayName = "Derive TEA Key")
+	static FUInt128Ex DeriveTEAKey(const FUInt128Ex& SecretKey, int64 Epoch);
+
 	UFUNCTION(BlueprintCallable, Category = "TinyEncrypt", DisplayName = "Encrypt With TEA")
 	static TArray<uint8> EncryptWithTEA(const TArray<uint8>& InputData, const FUInt128Ex& Key);
 
 	UFUNCTION(BlueprintCallable, Category = "TinyEncrypt", DisplayName = "Decrypt With TEA")
 	static TArray<uint8> DecryptWithTEA(const TArray<uint8>& InputData, const FUInt128Ex& Key);
+
+	//XXTEA, fewer rounds per byte than TEA for large data
+	UFUNCTION(BlueprintCallable, Category = "TinyEncrypt", DisplayName = "Encrypt With XXTEA")
+	static TArray<uint8> EncryptWithXXTEA(const TArray<uint8>& InputData, const FUInt128Ex& Key);
+
+	//Return empty array if the data is invalid
+	UFUNCTION(BlueprintCallable, Category = "TinyEncrypt", DisplayName = "Decrypt With XXTEA")
+	static TArray<uint8> DecryptWithXXTEA(const TArray<uint8>& InputData, const FUInt128Ex& Key);
+
+	//64-bit version for the data larger than 2GB, not exposed to blueprints. Decrypt returns empty array if the data is invalid
+	static TArray64<uint8> EncryptWithTEA64(const TArray64<uint8>& InputData, const FUInt128Ex& Key);
+	static TArray64<uint8> DecryptWithTEA64(const TArray64<uint8>& InputData, const FUInt128Ex& Key);
 };
@@ -0,0 +1,82 @@
+// Copyright (C) 2024 Neo Jin. All Rights Reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "Containers/CircularQueue.h"
+#include "TinyEncryptAlgorithm.h"
+#include <atomic>
+
+class FEvent;
+class FRunnableThread;
+
+/*
+One buffer processed by FTinyEncryptWorker
+*/
+struct TINYENCRYPT_API FTinyEncryptJob
+{
+	//Cipher of the connection, must be valid until the job is completed
+	const FTinyEncrypt* TEA = nullptr;
+	//Plain data of encrypt job or encrypted data of decrypt job, replaced by the result in place
+	TArray<uint8> Data;
+	//Result length, -1 if the encrypted data is invalid
+	int32 Result = 0;
+	//Passed through to the completion, e.g. the connection id
+	uint64 UserData = 0;
+};
+
+/*
+Background thread which encrypts outbound buffers and decrypts inbound buffers.
+
+Each direction has a request ring and a completion ring, all rings are lock-free single-producer/single-consumer queues:
+	the outbound thread(e.g. game thread) calls `EnqueueEncrypt` and `DequeueEncrypted`,
+	the inbound thread(e.g. network thread) calls `EnqueueDecrypt` and `DequeueDecrypted`, which can be the same thread.
+The completion order of each direction is the same as the request order.
+Reuse the `Data` of the completed jobs to avoid allocation.
+*/
+class TINYENCRYPT_API FTinyEncryptWorker final : public FRunnable
+{
+public:
+	explicit FTinyEncryptWorker(uint32 QueueCapacity = 1024);
+	virtual ~FTinyEncryptWorker();
+
+	//Push a job, return false if the request ring is full
+	bool EnqueueEncrypt(FTinyEncryptJob&& Job);
+	bool EnqueueDecrypt(FTinyEncryptJob&& Job);
+
+	//Pop a completed job, return false if no job is completed
+	bool DequeueEncrypted(FTinyEncryptJob& OutJob);
+	bool DequeueDecrypted(FTinyEncryptJob& OutJob);
+
+	//Whether the jobs run on the worker thread, otherwise the jobs run in `Dequeue*` on the consumer thread
+	bool IsThreaded() const { return Thread != nullptr; }
+
+	// FRunnable interface
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+
+private:
+	struct FDirection
+	{
+		const bool bEncrypt;
+		TCircularQueue<FTinyEncryptJob> Requests;
+		TCircularQueue<FTinyEncryptJob> Completions;
+		FTinyEncryptJob HeldJob;		//Processed job waiting for a free completion slot
+		bool bHasHeldJob;
+
+		FDirection(bool bInEncrypt, uint32 QueueCapacity)
+			: bEncrypt(bInEncrypt), Requests(QueueCapacity + 1), Completions(QueueCapacity + 1), bHasHeldJob(false) {}
+	};
+
+	//Process the requests until the request ring is empty or the completion ring is full, return true if any job is completed
+	static bool ProcessDirection(FDirection& Direction);
+	static void ProcessJob(FTinyEncryptJob& Job, bool bEncrypt);
+
+private:
+	FDirection EncryptDirection;
+	FDirection DecryptDirection;
+
+	FEvent* WakeEvent;
+	FRunnableThread* Thread;
+	std::atomic<bool> bStopping;
+};
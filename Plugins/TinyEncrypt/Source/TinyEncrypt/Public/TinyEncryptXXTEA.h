@@ -0,0 +1,43 @@
+// Copyright (C) 2024 Neo Jin. All Rights Reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TinyEncryptKeyExchange.h"
+
+/*
+The Corrected Block TEA(XXTEA) Implementation
+
+The whole message is encrypted as one block of 32-bit words, 6 + 52/n cycles over n words, so large messages
+need several times fewer rounds per byte than `FTinyEncrypt`. The message is padded to whole words(at least 2 words),
+the pad bytes are the pad length(1~8). Use the same 128-bit key as `FTinyEncrypt`.
+*/
+class TINYENCRYPT_API FTinyEncryptXXTEA
+{
+private:
+	uint32 Key[4];	//Encrypt or Decrypt key
+
+public:
+	static int32 GetEncryptLength(int32 InLen);
+	static int32 GetDecryptLength(int32 InLen);
+
+	//Encrypt data, the length of output buf should get from `GetEncryptLength`. InBuf and OutBuf can be the same buffer
+	//if it has `GetEncryptLength` bytes
+	int32 Encrypt(const uint8* InBuf, int32 InLen, uint8* OutBuf) const;
+	//Decrypt data, return -1 if the length or the padding is invalid. InBuf and OutBuf can be the same buffer
+	int32 Decrypt(const uint8* InBuf, int32 InLen, uint8* OutBuf) const;
+
+private:
+	//Encrypt/Decrypt NumWords(>= 2) words in place
+	void EncryptWords(uint8* Buf, int32 NumWords) const;
+	void DecryptWords(uint8* Buf, int32 NumWords) const;
+
+public:
+	FTinyEncryptXXTEA(const FUInt128Ex& _Key);
+	~FTinyEncryptXXTEA();
+
+	// Default constructors.
+	FORCEINLINE FTinyEncryptXXTEA(const FTinyEncryptXXTEA&) = default;
+	FORCEINLINE FTinyEncryptXXTEA(FTinyEncryptXXTEA&&) = default;
+	FORCEINLINE FTinyEncryptXXTEA& operator=(FTinyEncryptXXTEA const&) = default;
+	FORCEINLINE FTinyEncryptXXTEA& operator=(FTinyEncryptXXTEA&&) = default;
+};
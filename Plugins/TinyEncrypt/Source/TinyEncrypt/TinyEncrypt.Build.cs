@@ -37,6 +37,7 @@ public class TinyEncrypt : ModuleRules
 				"Engine",
 				"Slate",
 				"SlateCore",
+				"Sockets",
 				// ... add private dependencies that you statically link with here ...	
 			}
 			);
@@ -0,0 +1,81 @@
+// Copyright (C) 2024 Neo Jin. All Rights Reserved.
+#include "TinyEncryptCommandlet.h"
+#include "TinyEncryptAlgorithm.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "AutomationTest/TinyEncryptEditorTestInterface.h"
+#include "Misc/AutomationTest.h"
+#include "Runtime/Launch/Resources/Version.h"
+
+#if !UE_BUILD_SHIPPING
+
+//Encrypt a file with the commandlet and decrypt it back, the encrypted file is the same as `FTinyEncrypt::Encrypt`
+static bool TestFileRoundTrip(FString& Detail, int32 FileSize)
+{
+	const FString PlainPath = FPaths::Combine(FPaths::AutomationTransientDir(), TEXT("TinyEncryptPlain.bin"));
+	const FString EncryptedPath = FPaths::Combine(FPaths::AutomationTransientDir(), TEXT("TinyEncryptEncrypted.bin"));
+	const FString DecryptedPath = FPaths::Combine(FPaths::AutomationTransientDir(), TEXT("TinyEncryptDecrypted.bin"));
+
+	TArray<uint8> PlainData;
+	PlainData.SetNumUninitialized(FileSize);
+	for (int32 i = 0; i < FileSize; i++)
+	{
+		PlainData[i] = (uint8)(i * 31 + (i >> 11));
+	}
+	TEST_TRUE_WITH_AUTONAME(FFileHelper::SaveArrayToFile(PlainData, *PlainPath));
+
+	FUInt128Ex RandomKey;
+	RandomKey.MakeRandom();
+	const FString KeyParam = FString::Printf(TEXT(" -key=%s -chunk=1"), *RandomKey.ToHexString());
+
+	UTinyEncryptCommandlet* Commandlet = NewObject<UTinyEncryptCommandlet>();
+	TEST_TRUE_WITH_AUTONAME(Commandlet->Main(FString::Printf(TEXT("-in=\"%s\" -out=\"%s\""), *PlainPath, *EncryptedPath) + KeyParam) == 0);
+
+	TArray<uint8> EncryptedData;
+	TEST_TRUE_WITH_AUTONAME(FFileHelper::LoadFileToArray(EncryptedData, *EncryptedPath));
+	TArray<uint8> ExpectData;
+	ExpectData.SetNumUninitialized(FTinyEncrypt::GetEncryptLength(FileSize));
+	FTinyEncrypt TEA(RandomKey);
+	TEST_TRUE_WITH_AUTONAME(TEA.Encrypt(PlainData.GetData(), FileSize, ExpectData.GetData()) == ExpectData.Num());
+	TEST_TRUE_WITH_AUTONAME(EncryptedData == ExpectData);
+
+	TEST_TRUE_WITH_AUTONAME(Commandlet->Main(FString::Printf(TEXT("-in=\"%s\" -out=\"%s\" -decrypt"), *EncryptedPath, *DecryptedPath) + KeyParam) == 0);
+
+	TArray<uint8> DecryptedData;
+	TEST_TRUE_WITH_AUTONAME(FFileHelper::LoadFileToArray(DecryptedData, *DecryptedPath));
+	TEST_TRUE_WITH_AUTONAME(DecryptedData == PlainData);
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	PlatformFile.DeleteFile(*PlainPath);
+	PlatformFile.DeleteFile(*EncryptedPath);
+	PlatformFile.DeleteFile(*DecryptedPath);
+	return true;
+}
+
+bool TestTinyEncryptCommandlet(FString& Detail)
+{
+	//Empty file, one block, and several 1MB chunks with a partial tail
+	return TestFileRoundTrip(Detail, 0) &&
+		TestFileRoundTrip(Detail, 8) &&
+		TestFileRoundTrip(Detail, 5 * 1024 * 1024 / 2 + 3);
+}
+
+#endif //!UE_BUILD_SHIPPING
+
+#if WITH_DEV_AUTOMATION_TESTS && !UE_BUILD_SHIPPING
+
+#if (ENGINE_MAJOR_VERSION >= 5 && ENGINE_MINOR_VERSION >= 5)
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST(FTinyEncryptTestCommandlet, FAutomationTestBase, "TinyEncrypt.Commandlet", EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+#else
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST(FTinyEncryptTestCommandlet, FAutomationTestBase, "TinyEncrypt.Commandlet", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+#endif
+bool FTinyEncryptTestCommandlet::RunTest(const FString& Parameters)
+{
+	FString Detail;
+	bool bSuccess = TestTinyEncryptCommandlet(Detail);
+	TestTrue(Detail, bSuccess);
+	return true;
+}
+
+#endif
@@ -0,0 +1,237 @@
+// Copyright (C) 2024 Neo Jin. All Rights Reserved.
+#include "TinyEncryptCommandlet.h"
+#include "TinyEncryptAlgorithm.h"
+#include "Async/Async.h"
+#include "Async/AsyncFileHandle.h"
+#include "Async/ParallelFor.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/Parse.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogTinyEncryptCommandlet, Log, All);
+
+namespace TinyEncryptCommandlet
+{
+	static constexpr int32 NumSlots = 3;
+	static constexpr int64 MinTaskBytes = 256 * 1024;
+
+	struct FSlot
+	{
+		TArray64<uint8> Buffer;
+		IAsyncReadRequest* ReadRequest = nullptr;
+		TFuture<bool> WriteResult;
+	};
+
+	//Encrypt/Decrypt full blocks in place on all cores
+	static void ProcessBlocks(const FTinyEncrypt& TEA, bool bDecrypt, uint8* Data, int64 NumBlocks)
+	{
+		const int64 BlocksPerTask = MinTaskBytes / FTinyEncrypt::BlockSize;
+		const int32 NumTasks = (int32)FMath::DivideAndRoundUp(NumBlocks, BlocksPerTask);
+		ParallelFor(NumTasks, [&TEA, bDecrypt, Data, NumBlocks, BlocksPerTask](int32 TaskIndex)
+		{
+			const int64 FirstBlock = TaskIndex * BlocksPerTask;
+			const int64 TaskBlocks = FMath::Min(BlocksPerTask, NumBlocks - FirstBlock);
+			uint8* TaskData = Data + FirstBlock * FTinyEncrypt::BlockSize;
+			if (bDecrypt)
+			{
+				TEA.DecryptBlocks(TaskData, TaskData, TaskBlocks);
+			}
+			else
+			{
+				TEA.EncryptBlocks(TaskData, TaskData, TaskBlocks);
+			}
+		});
+	}
+
+	//Return false if the read failed, the buffer doesn't hold the chunk
+	static bool WaitRead(FSlot& Slot)
+	{
+		if (Slot.ReadRequest == nullptr)
+		{
+			return true;
+		}
+		const bool bResult = Slot.ReadRequest->WaitCompletion() && Slot.ReadRequest->GetReadResults() != nullptr;
+		delete Slot.ReadRequest;
+		Slot.ReadRequest = nullptr;
+		return bResult;
+	}
+
+	static bool WaitWrite(FSlot& Slot)
+	{
+		if (!Slot.WriteResult.IsValid())
+		{
+			return true;
+		}
+		const bool bResult = Slot.WriteResult.Get();
+		Slot.WriteResult = TFuture<bool>();
+		return bResult;
+	}
+}
+
+UTinyEncryptCommandlet::UTinyEncryptCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UTinyEncryptCommandlet::Main(const FString& Params)
+{
+	using namespace TinyEncryptCommandlet;
+	constexpr int32 BlockSize = FTinyEncrypt::BlockSize;
+
+	FString InPath, OutPath, KeyString;
+	if (!FParse::Value(*Params, TEXT("in="), InPath) || !FParse::Value(*Params, TEXT("out="), OutPath) || !FParse::Value(*Params, TEXT("key="), KeyString))
+	{
+		UE_LOG(LogTinyEncryptCommandlet, Error, TEXT("Usage: -run=TinyEncrypt -in=<File> -out=<File> -key=<32 hex chars> [-decrypt] [-chunk=<MB>]"));
+		return 1;
+	}
+
+	FUInt128Ex Key;
+	Key.MakeFromHexString(KeyString);
+	if (KeyString.Len() != 32 || Key.ToHexString() != KeyString.ToLower())
+	{
+		UE_LOG(LogTinyEncryptCommandlet, Error, TEXT("Invalid key '%s', expect 32 hex chars"), *KeyString);
+		return 1;
+	}
+
+	const bool bDecrypt = FParse::Param(*Params, TEXT("decrypt"));
+	int32 ChunkMB = 16;
+	FParse::Value(*Params, TEXT("chunk="), ChunkMB);
+	const int64 ChunkSize = (int64)FMath::Clamp(ChunkMB, 1, 1024) * 1024 * 1024;
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	const int64 FileSize = PlatformFile.FileSize(*InPath);
+	if (FileSize < 0)
+	{
+		UE_LOG(LogTinyEncryptCommandlet, Error, TEXT("Can't open '%s'"), *InPath);
+		return 1;
+	}
+	if (bDecrypt && (FileSize == 0 || (FileSize % BlockSize) != 0))
+	{
+		UE_LOG(LogTinyEncryptCommandlet, Error, TEXT("'%s' is not an encrypted file, size %lld"), *InPath, FileSize);
+		return 1;
+	}
+
+	TUniquePtr<IAsyncReadFileHandle> ReadHandle(PlatformFile.OpenAsyncRead(*InPath));
+	TUniquePtr<IFileHandle> WriteHandle(PlatformFile.OpenWrite(*OutPath));
+	if (!ReadHandle.IsValid() || !WriteHandle.IsValid())
+	{
+		UE_LOG(LogTinyEncryptCommandlet, Error, TEXT("Can't open '%s' or '%s'"), *InPath, *OutPath);
+		return 1;
+	}
+
+	const FTinyEncrypt TEA(Key);
+
+	//An empty file is encrypted to one padding block
+	const int64 NumChunks = FMath::Max<int64>(FMath::DivideAndRoundUp(FileSize, ChunkSize), 1);
+	auto GetChunkLength = [FileSize, ChunkSize](int64 ChunkIndex)
+	{
+		return FMath::Min(ChunkSize, FileSize - ChunkIndex * ChunkSize);
+	};
+
+	FSlot Slots[NumSlots];
+	auto IssueRead = [&](int64 ChunkIndex)
+	{
+		if (ChunkIndex < NumChunks)
+		{
+			FSlot& Slot = Slots[ChunkIndex % NumSlots];
+			const int64 ChunkLength = GetChunkLength(ChunkIndex);
+			if (ChunkLength > 0)
+			{
+				Slot.ReadRequest = ReadHandle->ReadRequest(ChunkIndex * ChunkSize, ChunkLength, AIOP_Normal, nullptr, Slot.Buffer.GetData());
+				return Slot.ReadRequest != nullptr;
+			}
+		}
+		return true;
+	};
+
+	for (FSlot& Slot : Slots)
+	{
+		//Room for the padding block
+		Slot.Buffer.SetNumUninitialized(ChunkSize + BlockSize);
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	int64 OutputSize = 0;
+
+	bool bSuccess = IssueRead(0) && IssueRead(1);
+	for (int64 ChunkIndex = 0; ChunkIndex < NumChunks && bSuccess; ++ChunkIndex)
+	{
+		FSlot& Slot = Slots[ChunkIndex % NumSlots];
+		if (!WaitRead(Slot))
+		{
+			UE_LOG(LogTinyEncryptCommandlet, Error, TEXT("Failed to read '%s' at %lld"), *InPath, ChunkIndex * ChunkSize);
+			bSuccess = false;
+			break;
+		}
+
+		const bool bLastChunk = (ChunkIndex == NumChunks - 1);
+		const int64 ChunkLength = GetChunkLength(ChunkIndex);
+		uint8* Data = Slot.Buffer.GetData();
+		int64 WriteLength = ChunkLength;
+
+		if (!bLastChunk)
+		{
+			ProcessBlocks(TEA, bDecrypt, Data, ChunkLength / BlockSize);
+		}
+		else if (!bDecrypt)
+		{
+			const int64 BlockBytes = (ChunkLength / BlockSize) * BlockSize;
+			ProcessBlocks(TEA, false, Data, BlockBytes / BlockSize);
+			WriteLength = BlockBytes + TEA.EncryptTail(Data + BlockBytes, (int32)(ChunkLength - BlockBytes), Data + BlockBytes);
+		}
+		else
+		{
+			const int64 BlockBytes = ChunkLength - BlockSize;
+			ProcessBlocks(TEA, true, Data, BlockBytes / BlockSize);
+			const int32 TailLength = TEA.DecryptTail(Data + BlockBytes, Data + BlockBytes);
+			if (TailLength < 0)
+			{
+				UE_LOG(LogTinyEncryptCommandlet, Error, TEXT("Invalid padding, wrong key or damaged file"));
+				bSuccess = false;
+				break;
+			}
+			WriteLength = BlockBytes + TailLength;
+		}
+
+		//The slot of the previous chunk receives the chunk after next
+		FSlot& PrevSlot = Slots[(ChunkIndex + NumSlots - 1) % NumSlots];
+		if (!WaitWrite(PrevSlot) || !IssueRead(ChunkIndex + 2))
+		{
+			bSuccess = false;
+			break;
+		}
+
+		//One write at a time, so the chunks are written in order
+		IFileHandle* Writer = WriteHandle.Get();
+		Slot.WriteResult = Async(EAsyncExecution::ThreadPool, [Writer, Data, WriteLength]()
+		{
+			return Writer->Write(Data, WriteLength);
+		});
+		OutputSize += WriteLength;
+	}
+
+	for (FSlot& Slot : Slots)
+	{
+		//Pending reads after a failure are not used
+		WaitRead(Slot);
+		bSuccess &= WaitWrite(Slot);
+	}
+	const bool bFlushed = WriteHandle->Flush();
+	WriteHandle.Reset();
+	ReadHandle.Reset();
+
+	if (!bSuccess || !bFlushed)
+	{
+		UE_LOG(LogTinyEncryptCommandlet, Error, TEXT("Failed to %s '%s' to '%s'"), bDecrypt ? TEXT("decrypt") : TEXT("encrypt"), *InPath, *OutPath);
+		PlatformFile.DeleteFile(*OutPath);
+		return 1;
+	}
+
+	const double Seconds = FMath::Max(FPlatformTime::Seconds() - StartTime, 0.000001);
+	const double MegaBytes = (double)FileSize / (1024.0 * 1024.0);
+	UE_LOG(LogTinyEncryptCommandlet, Display, TEXT("%s '%s' -> '%s': %lld bytes -> %lld bytes in %.3f s, %.1f MB/s"),
+		bDecrypt ? TEXT("Decrypted") : TEXT("Encrypted"), *InPath, *OutPath, FileSize, OutputSize, Seconds, MegaBytes / Seconds);
+	return 0;
+}
@@ -0,0 +1,27 @@
+// Copyright (C) 2024 Neo Jin. All Rights Reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "TinyEncryptCommandlet.generated.h"
+
+/*
+Encrypt or decrypt a file with TEA, the output has the same format as `FTinyEncrypt::Encrypt` of the whole file.
+
+	UnrealEditor-Cmd.exe <Project> -run=TinyEncrypt -in=<File> -out=<File> -key=<32 hex chars> [-decrypt] [-chunk=<MB>]
+
+The file is processed in chunks with three buffers: reading the next chunks, encrypting the current chunk on all cores,
+and writing the previous chunk are overlapped. Return non-zero if a read, write or the padding check fails.
+Lives in the editor module, so it is not shipped in game builds.
+*/
+UCLASS()
+class UTinyEncryptCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UTinyEncryptCommandlet();
+
+	// UCommandlet interface
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,5 @@
+// Copyright (C) 2024 Neo Jin. All Rights Reserved.
+#include "Modules/ModuleManager.h"
+
+//Editor only tools, the commandlet is not shipped in game builds
+IMPLEMENT_MODULE(FDefaultModuleImpl, TinyEncryptEditor)
@@ -0,0 +1,10 @@
+// Copyright (C) 2024 Neo Jin. All Rights Reserved.
+#pragma once
+
+#include "AutomationTest/TinyEncryptAutomationTestInterface.h"
+
+#if !UE_BUILD_SHIPPING
+
+bool TINYENCRYPTEDITOR_API TestTinyEncryptCommandlet(FString& Detail);
+
+#endif
@@ -0,0 +1,218 @@
+// Copyright (C) 2024 Neo Jin. All Rights Reserved.
+#include "TinyEncryptHandlerComponent.h"
+#include "Misc/Paths.h"
+#include "AutomationTest/TinyEncryptHandlerComponentTestInterface.h"
+#include "Misc/AutomationTest.h"
+#include "Serialization/BitReader.h"
+#include "Serialization/BitWriter.h"
+#include "Runtime/Launch/Resources/Version.h"
+
+#if !UE_BUILD_SHIPPING
+
+static bool TestHandlerComponentWithCipher(ETinyEncryptCipher CipherType, FString& Detail)
+{
+	//Both side share the same DH secret key
+	FDiffieHellmanKeyPair Alice, Bob;
+	Alice.GenerateRandomKeyPair();
+	Bob.GenerateRandomKeyPair();
+
+	FEncryptionData EncryptionData;
+	EncryptionData.Key = Alice.GenerateSecretKey(Bob.PublicKey).ToArray();
+
+	FTinyEncryptHandlerComponent Sender(false, CipherType);
+	Sender.SetEncryptionData(EncryptionData);
+	TEST_TRUE_WITH_AUTONAME(!Sender.IsEncryptionEnabled());
+	Sender.EnableEncryption();
+	TEST_TRUE_WITH_AUTONAME(Sender.IsEncryptionEnabled());
+
+	EncryptionData.Key = Bob.GenerateSecretKey(Alice.PublicKey).ToArray();
+	FTinyEncryptHandlerComponent Receiver(false, CipherType);
+	Receiver.SetEncryptionData(EncryptionData);
+	Receiver.EnableEncryption();
+
+	const int32 MaxPacketBits = 1024 * 8;
+	const int64 TestBits[] = { 1, 7, 8, 9, 63, 64, 65, 127, 128, 1000, MaxPacketBits - Sender.GetReservedPacketBits() };
+
+	uint8 PlainData[MaxPacketBits / 8];
+	for (int32 i = 0; i < UE_ARRAY_COUNT(PlainData); i++)
+	{
+		PlainData[i] = (uint8)FMath::RandRange(0, 0xFF);
+	}
+
+	for (int64 NumBits : TestBits)
+	{
+		FBitWriter Writer(MaxPacketBits);
+		Writer.SerializeBits(PlainData, NumBits);
+		TEST_TRUE_WITH_AUTONAME(Writer.GetNumBits() == NumBits);
+
+		FOutPacketTraits OutTraits;
+		Sender.Outgoing(Writer, OutTraits);
+		TEST_TRUE_WITH_AUTONAME(!Writer.IsError());
+		TEST_TRUE_WITH_AUTONAME(Writer.GetNumBits() % (ITinyEncryptCipher::GetCipherBlockSize(CipherType) * 8) == 0);
+		TEST_TRUE_WITH_AUTONAME(Writer.GetNumBits() - NumBits <= Sender.GetReservedPacketBits());
+
+		FBitReader Reader(Writer.GetData(), Writer.GetNumBits());
+		TSharedPtr<const FInternetAddr> Address;
+		FInPacketTraits InTraits;
+		Receiver.Incoming(FIncomingPacketRef{ Reader, Address, InTraits });
+		TEST_TRUE_WITH_AUTONAME(!Reader.IsError());
+		TEST_TRUE_WITH_AUTONAME(Reader.GetNumBits() == NumBits);
+
+		uint8 DecryptData[MaxPacketBits / 8] = { 0 };
+		Reader.SerializeBits(DecryptData, NumBits);
+		TEST_TRUE_WITH_AUTONAME(FMemory::Memcmp(PlainData, DecryptData, NumBits / 8) == 0);
+		if ((NumBits & 7) != 0)
+		{
+			const uint8 Mask = (uint8)((1 << (NumBits & 7)) - 1);
+			TEST_TRUE_WITH_AUTONAME((PlainData[NumBits / 8] & Mask) == (DecryptData[NumBits / 8] & Mask));
+		}
+	}
+
+	//Invalid packet
+	{
+		uint8 BadData[12] = { 0 };
+		FBitReader Reader(BadData, 12 * 8);
+		TEST_TRUE_WITH_AUTONAME(!Receiver.DecryptPacket(Reader));
+	}
+	return true;
+}
+
+//Keep the handshake packets instead of sending them
+class FTinyEncryptTestHandshakeComponent : public FTinyEncryptHandlerComponent
+{
+public:
+	FTinyEncryptTestHandshakeComponent(ETinyEncryptCipher CipherType)
+		: FTinyEncryptHandlerComponent(true, CipherType)
+	{
+	}
+
+	TArray<TArray<uint8>> SentPackets;
+
+protected:
+	virtual void SendHandshake(FBitWriter& Packet) override
+	{
+		SentPackets.Emplace(Packet.GetData(), (int32)Packet.GetNumBytes());
+	}
+};
+
+static void DeliverPacket(FTinyEncryptHandlerComponent& Receiver, FBitReader& Reader)
+{
+	TSharedPtr<const FInternetAddr> Address;
+	FInPacketTraits InTraits;
+	Receiver.Incoming(FIncomingPacketRef{ Reader, Address, InTraits });
+}
+
+static void DeliverPacket(FTinyEncryptHandlerComponent& Receiver, const TArray<uint8>& Data)
+{
+	FBitReader Reader(Data.GetData(), Data.Num() * 8);
+	DeliverPacket(Receiver, Reader);
+}
+
+//Send a packet from Sender to Receiver through Outgoing/Incoming, return true if it arrived unchanged
+static bool ExchangePacket(FTinyEncryptHandlerComponent& Sender, FTinyEncryptHandlerComponent& Receiver)
+{
+	uint8 PlainData[100];
+	for (int32 i = 0; i < 100; i++)
+	{
+		PlainData[i] = (uint8)FMath::RandRange(0, 0xFF);
+	}
+
+	FBitWriter Writer(1024 * 8);
+	Writer.Serialize(PlainData, 100);
+	FOutPacketTraits OutTraits;
+	Sender.Outgoing(Writer, OutTraits);
+
+	FBitReader Reader(Writer.GetData(), Writer.GetNumBits());
+	DeliverPacket(Receiver, Reader);
+	if (Reader.IsError() || Reader.GetNumBits() != 100 * 8)
+	{
+		return false;
+	}
+
+	uint8 DecryptData[100];
+	Reader.Serialize(DecryptData, 100);
+	return FMemory::Memcmp(PlainData, DecryptData, 100) == 0;
+}
+
+static bool TestHandshakeWithCipher(ETinyEncryptCipher CipherType, FString& Detail)
+{
+	PacketHandler ServerHandler;
+	PacketHandler ClientHandler;
+	ServerHandler.Mode = UE::Handler::Mode::Server;
+	ClientHandler.Mode = UE::Handler::Mode::Client;
+
+	TSharedPtr<FTinyEncryptTestHandshakeComponent> Server = MakeShared<FTinyEncryptTestHandshakeComponent>(CipherType);
+	TSharedPtr<FTinyEncryptTestHandshakeComponent> Client = MakeShared<FTinyEncryptTestHandshakeComponent>(CipherType);
+	TSharedPtr<HandlerComponent> ServerComponent = Server;
+	TSharedPtr<HandlerComponent> ClientComponent = Client;
+	ServerHandler.AddHandler(ServerComponent);
+	ClientHandler.AddHandler(ClientComponent);
+	TEST_TRUE_WITH_AUTONAME(!Server->IsInitialized() && !Client->IsInitialized());
+
+	//The first client hello is lost, it is resent after 1 second
+	Client->NotifyHandshakeBegin();
+	TEST_TRUE_WITH_AUTONAME(Client->SentPackets.Num() == 1);
+	Client->Tick(0.5f);
+	TEST_TRUE_WITH_AUTONAME(Client->SentPackets.Num() == 1);
+	Client->Tick(0.6f);
+	TEST_TRUE_WITH_AUTONAME(Client->SentPackets.Num() == 2);
+	TEST_TRUE_WITH_AUTONAME(Client->SentPackets[0] == Client->SentPackets[1]);
+	const TArray<uint8> ClientHello = Client->SentPackets[1];
+
+	DeliverPacket(*Server, ClientHello);
+	TEST_TRUE_WITH_AUTONAME(Server->IsInitialized() && Server->IsEncryptionEnabled());
+	TEST_TRUE_WITH_AUTONAME(Server->SentPackets.Num() == 1);
+	const TArray<uint8> ServerHello = Server->SentPackets[0];
+
+	//The server hello is lost, the resent client hello gets the same server hello
+	DeliverPacket(*Server, ClientHello);
+	TEST_TRUE_WITH_AUTONAME(Server->SentPackets.Num() == 2 && Server->SentPackets[1] == ServerHello);
+
+	//A client hello with another public key after initialization is dropped, the session is not re-keyed
+	FDiffieHellmanKeyPair Attacker;
+	Attacker.GenerateRandomKeyPair();
+	TArray<uint8> SpoofedHello = ClientHello;
+	Attacker.PublicKey.WriteBytes(SpoofedHello.GetData() + 1);
+	DeliverPacket(*Server, SpoofedHello);
+	TEST_TRUE_WITH_AUTONAME(Server->SentPackets.Num() == 2);
+
+	DeliverPacket(*Client, ServerHello);
+	TEST_TRUE_WITH_AUTONAME(Client->IsInitialized() && Client->IsEncryptionEnabled());
+
+	//A late server hello is ignored
+	DeliverPacket(*Client, ServerHello);
+	Client->Tick(2.f);
+	TEST_TRUE_WITH_AUTONAME(Client->SentPackets.Num() == 2);
+
+	//Both sides have the same key
+	TEST_TRUE_WITH_AUTONAME(ExchangePacket(*Client, *Server));
+	TEST_TRUE_WITH_AUTONAME(ExchangePacket(*Server, *Client));
+	return true;
+}
+
+bool TestTinyEncryptHandlerComponent(FString& Detail)
+{
+	return TestHandlerComponentWithCipher(ETinyEncryptCipher::TEA, Detail) &&
+		TestHandlerComponentWithCipher(ETinyEncryptCipher::AES128, Detail) &&
+		TestHandshakeWithCipher(ETinyEncryptCipher::TEA, Detail) &&
+		TestHandshakeWithCipher(ETinyEncryptCipher::AES128, Detail);
+}
+
+#endif //!UE_BUILD_SHIPPING
+
+#if WITH_DEV_AUTOMATION_TESTS && !UE_BUILD_SHIPPING
+
+#if (ENGINE_MAJOR_VERSION >= 5 && ENGINE_MINOR_VERSION >= 5)
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST(FTinyEncryptTestHandlerComponent, FAutomationTestBase, "TinyEncrypt.HandlerComponent", EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+#else
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST(FTinyEncryptTestHandlerComponent, FAutomationTestBase, "TinyEncrypt.HandlerComponent", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+#endif
+bool FTinyEncryptTestHandlerComponent::RunTest(const FString& Parameters)
+{
+	FString Detail;
+	bool bSuccess = TestTinyEncryptHandlerComponent(Detail);
+	TestTrue(Detail, bSuccess);
+	return true;
+}
+
+#endif
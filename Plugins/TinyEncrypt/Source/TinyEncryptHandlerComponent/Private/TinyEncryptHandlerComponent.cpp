@@ -0,0 +1,296 @@
+// Copyright (C) 2024 Neo Jin. All Rights Reserved.
+#include "TinyEncryptHandlerComponent.h"
+#include "Serialization/BitReader.h"
+#include "Serialization/BitWriter.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogTinyEncryptHandler, Log, All);
+
+IMPLEMENT_MODULE(FTinyEncryptHandlerComponentModule, TinyEncryptHandlerComponent)
+
+namespace TinyEncryptHandlerComponent
+{
+	//FBitReader can only shrink by copying into a new buffer, trim the bit count of the decrypted packet directly
+	struct FBitReaderAccess : public FBitReader
+	{
+		static void SetNumBits(FBitReader& Reader, int64 NumBits)
+		{
+			check(NumBits <= Reader.GetNumBits());
+			Reader.*(&FBitReaderAccess::Num) = NumBits;
+		}
+	};
+}
+
+TSharedPtr<HandlerComponent> FTinyEncryptHandlerComponentModule::CreateComponentInstance(FString& Options)
+{
+	const bool bExternalKey = Options.Contains(TEXT("ExternalKey"));
+	const ETinyEncryptCipher CipherType = Options.Contains(TEXT("AES")) ? ETinyEncryptCipher::AES128 : ETinyEncryptCipher::TEA;
+
+	TSharedPtr<HandlerComponent> ReturnVal = MakeShared<FTinyEncryptHandlerComponent>(!bExternalKey, CipherType);
+	return ReturnVal;
+}
+
+FTinyEncryptHandlerComponent::FTinyEncryptHandlerComponent(bool bInKeyExchange, ETinyEncryptCipher InCipherType)
+	: FEncryptionComponent(FName(TEXT("TinyEncryptHandlerComponent")))
+	, bKeyExchange(bInKeyExchange)
+	, bEncryptionEnabled(false)
+	, CipherType(InCipherType)
+	, HandshakeResendTimer(0.f)
+{
+	bRequiresHandshake = bKeyExchange;
+}
+
+void FTinyEncryptHandlerComponent::SetEncryptionData(const FEncryptionData& EncryptionData)
+{
+	if (EncryptionData.Key.Num() != 16)
+	{
+		UE_LOG(LogTinyEncryptHandler, Warning, TEXT("SetEncryptionData: expect a 16 bytes key, got %d bytes"), EncryptionData.Key.Num());
+		return;
+	}
+
+	FUInt128Ex SecretKey;
+	SecretKey.MakeFromArray(EncryptionData.Key);
+	SetSecretKey(SecretKey);
+}
+
+void FTinyEncryptHandlerComponent::EnableEncryption()
+{
+	if (!Cipher.IsValid())
+	{
+		UE_LOG(LogTinyEncryptHandler, Warning, TEXT("EnableEncryption: no encryption key"));
+		return;
+	}
+	bEncryptionEnabled = true;
+}
+
+void FTinyEncryptHandlerComponent::DisableEncryption()
+{
+	bEncryptionEnabled = false;
+}
+
+bool FTinyEncryptHandlerComponent::IsEncryptionEnabled() const
+{
+	return bEncryptionEnabled;
+}
+
+void FTinyEncryptHandlerComponent::Initialize()
+{
+	SetActive(true);
+
+	if (bKeyExchange)
+	{
+		//The key pair is ready before handshake begin
+		KeyPair.GenerateRandomKeyPair(EDiffieHellmanPowerMode::ConstantTime);
+	}
+	else
+	{
+		SetState(UE::Handler::Component::State::Initialized);
+		Initialized();
+	}
+}
+
+void FTinyEncryptHandlerComponent::NotifyHandshakeBegin()
+{
+	if (Handler->Mode == UE::Handler::Mode::Client)
+	{
+		SendHandshakePacket(EHandshakeType::ClientHello);
+		SetState(UE::Handler::Component::State::InitializedOnLocal);
+	}
+}
+
+bool FTinyEncryptHandlerComponent::IsValid() const
+{
+	return true;
+}
+
+void FTinyEncryptHandlerComponent::Tick(float DeltaTime)
+{
+	//Resend client hello until server hello arrived, handshake packets may be lost
+	if (bKeyExchange && Handler != nullptr && Handler->Mode == UE::Handler::Mode::Client &&
+		State == UE::Handler::Component::State::InitializedOnLocal)
+	{
+		HandshakeResendTimer += DeltaTime;
+		if (HandshakeResendTimer >= 1.f)
+		{
+			SendHandshakePacket(EHandshakeType::ClientHello);
+		}
+	}
+}
+
+void FTinyEncryptHandlerComponent::Incoming(FIncomingPacketRef PacketRef)
+{
+	FBitReader& Packet = PacketRef.Packet;
+
+	if (bKeyExchange && Packet.GetNumBits() == HandshakePacketBytes * 8)
+	{
+		HandleHandshakePacket(Packet);
+		return;
+	}
+
+	if (bEncryptionEnabled && !DecryptPacket(Packet))
+	{
+		UE_LOG(LogTinyEncryptHandler, Verbose, TEXT("Incoming: drop invalid packet(%lld bits)"), Packet.GetNumBits());
+		Packet.SetError();
+	}
+}
+
+void FTinyEncryptHandlerComponent::Outgoing(FBitWriter& Packet, FOutPacketTraits& Traits)
+{
+	if (bEncryptionEnabled && Packet.GetNumBits() > 0 && !EncryptPacket(Packet))
+	{
+		UE_LOG(LogTinyEncryptHandler, Warning, TEXT("Outgoing: packet overflow after encryption(%lld bits)"), Packet.GetNumBits());
+		Packet.SetError();
+	}
+}
+
+int32 FTinyEncryptHandlerComponent::GetReservedPacketBits() const
+{
+	//Termination bit(1) + byte align(7) + padding(one block)
+	return 1 + 7 + ITinyEncryptCipher::GetCipherBlockSize(CipherType) * 8;
+}
+
+void FTinyEncryptHandlerComponent::CountBytes(FArchive& Ar) const
+{
+	FEncryptionComponent::CountBytes(Ar);
+
+	const SIZE_T SizeOfThis = sizeof(*this) - sizeof(FEncryptionComponent);
+	Ar.CountBytes(SizeOfThis, SizeOfThis);
+}
+
+bool FTinyEncryptHandlerComponent::EncryptPacket(FBitWriter& Packet)
+{
+	check(Cipher.IsValid());
+
+	//Termination bit, so the receiver can recover the bit length of the packet
+	Packet.WriteBit(1);
+
+	const int64 NumBits = Packet.GetNumBits();
+	const int32 PlainLen = (int32)Packet.GetNumBytes();
+	if ((NumBits & 7) != 0)
+	{
+		//Clear the unused bits after termination bit
+		Packet.GetData()[PlainLen - 1] &= (uint8)((1 << (NumBits & 7)) - 1);
+	}
+	Packet.WriteAlign();
+
+	//Grow the packet to the encrypted length, then encrypt in place
+	static const uint8 ZeroPad[16] = { 0 };
+	const int32 EncryptLen = Cipher->GetEncryptLength(PlainLen);
+	check(EncryptLen - PlainLen <= (int32)UE_ARRAY_COUNT(ZeroPad));
+	Packet.Serialize((void*)ZeroPad, EncryptLen - PlainLen);
+	if (Packet.IsError())
+	{
+		return false;
+	}
+
+	uint8* Data = Packet.GetData();
+	Cipher->Encrypt(Data, PlainLen, Data);
+	return true;
+}
+
+bool FTinyEncryptHandlerComponent::DecryptPacket(FBitReader& Packet)
+{
+	check(Cipher.IsValid());
+
+	const int32 BlockSize = Cipher->GetBlockSize();
+	const int64 NumBits = Packet.GetNumBits();
+	if (NumBits == 0 || (NumBits % (BlockSize * 8)) != 0)
+	{
+		return false;
+	}
+
+	//Decrypt in place, the packet is dropped anyway if it is invalid
+	const int32 EncryptLen = (int32)(NumBits >> 3);
+	uint8* Data = Packet.GetData();
+	const int32 PlainLen = Cipher->Decrypt(Data, EncryptLen, Data);
+	if (PlainLen <= 0 || PlainLen < EncryptLen - BlockSize || PlainLen >= EncryptLen)
+	{
+		//Invalid padding
+		return false;
+	}
+
+	const uint8 LastByte = Data[PlainLen - 1];
+	if (LastByte == 0)
+	{
+		//Termination bit not found
+		return false;
+	}
+
+	const int64 PlainBits = (int64)(PlainLen - 1) * 8 + FPlatformMath::FloorLog2((uint32)LastByte);
+	TinyEncryptHandlerComponent::FBitReaderAccess::SetNumBits(Packet, PlainBits);
+	return true;
+}
+
+void FTinyEncryptHandlerComponent::SendHandshakePacket(EHandshakeType Type)
+{
+	FBitWriter Writer(HandshakePacketBytes * 8);
+
+	uint8 TypeValue = (uint8)Type;
+	Writer << TypeValue;
+
+	uint8 PublicKey[FUInt128Ex::ByteSize];
+	KeyPair.PublicKey.WriteBytes(PublicKey);
+	Writer.Serialize(PublicKey, FUInt128Ex::ByteSize);
+
+	SendHandshake(Writer);
+	HandshakeResendTimer = 0.f;
+}
+
+void FTinyEncryptHandlerComponent::SendHandshake(FBitWriter& Packet)
+{
+	FOutPacketTraits Traits;
+	Handler->SendHandlerPacket(this, Packet, Traits);
+}
+
+void FTinyEncryptHandlerComponent::HandleHandshakePacket(FBitReader& Packet)
+{
+	uint8 TypeValue = 0;
+	Packet << TypeValue;
+
+	uint8 PublicKey[FUInt128Ex::ByteSize];
+	Packet.Serialize(PublicKey, FUInt128Ex::ByteSize);
+
+	if (Packet.IsError())
+	{
+		return;
+	}
+
+	FUInt128Ex AnotherPublicKey;
+	AnotherPublicKey.ReadBytes(PublicKey);
+
+	const EHandshakeType Type = (EHandshakeType)TypeValue;
+	if (Handler->Mode == UE::Handler::Mode::Server && Type == EHandshakeType::ClientHello)
+	{
+		if (IsInitialized())
+		{
+			//The hello is not authenticated, never re-key an established session. Only reply the same client again,
+			//its server hello may be lost
+			if (AnotherPublicKey == RemotePublicKey)
+			{
+				SendHandshakePacket(EHandshakeType::ServerHello);
+			}
+			return;
+		}
+
+		RemotePublicKey = AnotherPublicKey;
+		SetSecretKey(KeyPair.GenerateSecretKey(AnotherPublicKey, EDiffieHellmanPowerMode::ConstantTime));
+		SendHandshakePacket(EHandshakeType::ServerHello);
+
+		EnableEncryption();
+		SetState(UE::Handler::Component::State::Initialized);
+		Initialized();
+	}
+	else if (Handler->Mode == UE::Handler::Mode::Client && Type == EHandshakeType::ServerHello && !IsInitialized())
+	{
+		RemotePublicKey = AnotherPublicKey;
+		SetSecretKey(KeyPair.GenerateSecretKey(AnotherPublicKey, EDiffieHellmanPowerMode::ConstantTime));
+
+		EnableEncryption();
+		SetState(UE::Handler::Component::State::Initialized);
+		Initialized();
+	}
+}
+
+void FTinyEncryptHandlerComponent::SetSecretKey(const FUInt128Ex& SecretKey)
+{
+	Cipher = ITinyEncryptCipher::Create(CipherType, SecretKey);
+}
@@ -0,0 +1,87 @@
+// Copyright (C) 2024 Neo Jin. All Rights Reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+#include "EncryptionComponent.h"
+#include "PacketHandler.h"
+#include "TinyEncryptKeyExchange.h"
+#include "TinyEncryptCipher.h"
+
+/*
+PacketHandler component which encrypts every outgoing packet and decrypts every incoming packet with TEA or AES-128.
+
+Enable it in DefaultEngine.ini, the key is negotiated by a DH key exchange carried in the PacketHandler handshake:
+	[PacketHandlerComponents]
+	+Components=TinyEncryptHandlerComponent
+
+Or use it as the engine encryption component, the key (16 bytes) is set by game code through `UNetConnection::SetEncryptionData`:
+	[PacketHandlerComponents]
+	EncryptionComponent=TinyEncryptHandlerComponent(ExternalKey)
+
+Add `AES` to the options to use hardware AES-128 instead of TEA, both sides must use the same options:
+	+Components=TinyEncryptHandlerComponent(AES)
+*/
+class TINYENCRYPTHANDLERCOMPONENT_API FTinyEncryptHandlerComponent : public FEncryptionComponent
+{
+public:
+	FTinyEncryptHandlerComponent(bool bInKeyExchange, ETinyEncryptCipher InCipherType = ETinyEncryptCipher::TEA);
+
+	// FEncryptionComponent interface
+	virtual void SetEncryptionData(const FEncryptionData& EncryptionData) override;
+	virtual void EnableEncryption() override;
+	virtual void DisableEncryption() override;
+	virtual bool IsEncryptionEnabled() const override;
+
+	// HandlerComponent interface
+	virtual void Initialize() override;
+	virtual void NotifyHandshakeBegin() override;
+	virtual bool IsValid() const override;
+	virtual void Tick(float DeltaTime) override;
+	virtual void Incoming(FIncomingPacketRef PacketRef) override;
+	virtual void Outgoing(FBitWriter& Packet, FOutPacketTraits& Traits) override;
+	virtual void IncomingConnectionless(FIncomingPacketRef PacketRef) override {}
+	virtual void OutgoingConnectionless(const TSharedPtr<const FInternetAddr>& Address, FBitWriter& Packet, FOutPacketTraits& Traits) override {}
+	virtual int32 GetReservedPacketBits() const override;
+	virtual void CountBytes(FArchive& Ar) const override;
+
+public:
+	//Encrypt the packet in place, return false if the packet can't hold the encrypted data
+	bool EncryptPacket(FBitWriter& Packet);
+	//Decrypt the packet in place, return false if the packet is not a valid encrypted packet
+	bool DecryptPacket(FBitReader& Packet);
+
+protected:
+	//Send a handshake packet through the PacketHandler, overridden by the tests
+	virtual void SendHandshake(FBitWriter& Packet);
+
+private:
+	enum class EHandshakeType : uint8
+	{
+		ClientHello = 1,
+		ServerHello = 2,
+	};
+
+	//Handshake packet: type(1 byte) + public key(16 bytes), never a multiple of the cipher block size
+	static constexpr int32 HandshakePacketBytes = 1 + 16;
+
+	void SendHandshakePacket(EHandshakeType Type);
+	void HandleHandshakePacket(FBitReader& Packet);
+	void SetSecretKey(const FUInt128Ex& SecretKey);
+
+private:
+	bool bKeyExchange;			//Negotiate the key with DH in handshake, otherwise the key is set by `SetEncryptionData`
+	bool bEncryptionEnabled;
+	ETinyEncryptCipher CipherType;
+
+	TUniquePtr<ITinyEncryptCipher> Cipher;
+	FDiffieHellmanKeyPair KeyPair;
+	FUInt128Ex RemotePublicKey;
+
+	float HandshakeResendTimer;
+};
+
+class FTinyEncryptHandlerComponentModule : public FPacketHandlerComponentModuleInterface
+{
+public:
+	virtual TSharedPtr<HandlerComponent> CreateComponentInstance(FString& Options) override;
+};
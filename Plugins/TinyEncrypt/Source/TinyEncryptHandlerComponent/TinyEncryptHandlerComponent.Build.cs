@@ -0,0 +1,26 @@
+// Copyright (C) 2024 Neo Jin. All Rights Reserved.
+using UnrealBuildTool;
+
+public class TinyEncryptHandlerComponent : ModuleRules
+{
+	public TinyEncryptHandlerComponent(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = ModuleRules.PCHUsageMode.UseExplicitOrSharedPCHs;
+
+		PublicDependencyModuleNames.AddRange(
+			new string[]
+			{
+				"Core",
+				"PacketHandler",
+				"TinyEncrypt",
+			}
+			);
+
+		PrivateDependencyModuleNames.AddRange(
+			new string[]
+			{
+				"Sockets",
+			}
+			);
+	}
+}
@@ -17,6 +17,6 @@ public class TinyEncryptDemo : ModuleRules
 			"TinyEncrypt"
 		});
 
-		PrivateDependencyModuleNames.AddRange(new string[] {  });
+		PrivateDependencyModuleNames.AddRange(new string[] { "Sockets" });
 	}
 }
@@ -52,6 +52,10 @@ bool UTinyEncryptGameInstance::UnitTest(FString& Detail)
     if (!TestTinyEncryptUInt128(Detail)) return false;
     if (!TestTinyEncryptExchange(Detail)) return false;
     if (!TestTinyEncryptEncrypt(Detail)) return false;
+    if (!TestTinyEncryptSessionTable(Detail)) return false;
+    if (!TestTinyEncryptFramer(Detail)) return false;
+    if (!TestTinyEncryptWorker(Detail)) return false;
+    if (!TestTinyEncryptSocketStream(Detail)) return false;
 #endif
     return true;
 }
@@ -0,0 +1,520 @@
+#include "TinyEncryptLoadTestCommandlet.h"
+#include "TinyEncryptKeyExchange.h"
+#include "TinyEncryptCipher.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/Thread.h"
+#include "Misc/Parse.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+#include "IPAddress.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogTinyEncryptLoadTest, Log, All);
+
+namespace TinyEncryptLoadTest
+{
+    struct FSettings
+    {
+        int32 MessageSize = 256;
+        int32 Rate = 1000;          //Messages per second per client, 0 = unlimited
+        double Seconds = 5.0;
+        ETinyEncryptCipher Cipher = ETinyEncryptCipher::TEA;
+    };
+
+    struct FConnection
+    {
+        FSocket* Client = nullptr;
+        FSocket* Server = nullptr;
+        TUniquePtr<ITinyEncryptCipher> ClientCipher;
+        TUniquePtr<ITinyEncryptCipher> ServerCipher;
+        double NextSendTime = 0.0;     //Only touched by the client thread
+        bool bEnded = false;            //End frame received, only touched by the server thread
+    };
+
+    //Client threads count the sent bytes, server threads count the received messages and their latencies
+    struct FWorkerStats
+    {
+        TArray<float> LatenciesUs;
+        int64 Messages = 0;
+        int64 EncryptedBytes = 0;
+        bool bError = false;
+    };
+
+    //Length 0 frame, sent by the client after its last message
+    static constexpr int32 EndFrameLength = 0;
+    //The server threads give up if the end frames don't arrive in this time after the traffic
+    static constexpr double DrainSeconds = 10.0;
+
+    struct FResult
+    {
+        double HandshakesPerSecond = 0.0;
+        double MessagesPerSecond = 0.0;
+        double EncryptedMBPerSecond = 0.0;
+        float LatencyUs[5] = { 0.f };   //p50, p90, p99, p99.9, max
+    };
+
+    static const float Percentiles[] = { 0.5f, 0.9f, 0.99f, 0.999f, 1.f };
+
+    static bool SendAll(FSocket* Socket, const uint8* Data, int32 Len)
+    {
+        while (Len > 0)
+        {
+            int32 Sent = 0;
+            if (!Socket->Send(Data, Len, Sent) || Sent <= 0)
+            {
+                return false;
+            }
+            Data += Sent;
+            Len -= Sent;
+        }
+        return true;
+    }
+
+    //Non-blocking socket, wait until the data is sent or the deadline passes
+    static bool SendAllUntil(FSocket* Socket, const uint8* Data, int32 Len, double Deadline)
+    {
+        while (Len > 0)
+        {
+            int32 Sent = 0;
+            if (Socket->Send(Data, Len, Sent) && Sent > 0)
+            {
+                Data += Sent;
+                Len -= Sent;
+                continue;
+            }
+            if (ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->GetLastErrorCode() != SE_EWOULDBLOCK || FPlatformTime::Seconds() > Deadline)
+            {
+                return false;
+            }
+            Socket->Wait(ESocketWaitConditions::WaitForWrite, FTimespan::FromMilliseconds(10));
+        }
+        return true;
+    }
+
+    static bool RecvAll(FSocket* Socket, uint8* Data, int32 Len)
+    {
+        while (Len > 0)
+        {
+            int32 Read = 0;
+            if (!Socket->Recv(Data, Len, Read, ESocketReceiveFlags::WaitAll) || Read <= 0)
+            {
+                return false;
+            }
+            Data += Read;
+            Len -= Read;
+        }
+        return true;
+    }
+
+    //Client hello and server hello carry the public keys, both sides create the cipher from the DH secret key
+    static bool Handshake(FConnection& Connection, ETinyEncryptCipher Cipher)
+    {
+        FDiffieHellmanKeyPair ClientKeyPair, ServerKeyPair;
+        uint8 PublicKey[FUInt128Ex::ByteSize];
+        FUInt128Ex ReceivedKey;
+
+        ClientKeyPair.GenerateRandomKeyPair(EDiffieHellmanPowerMode::ConstantTime);
+        ClientKeyPair.PublicKey.WriteBytes(PublicKey);
+        if (!SendAll(Connection.Client, PublicKey, FUInt128Ex::ByteSize) || !RecvAll(Connection.Server, PublicKey, FUInt128Ex::ByteSize))
+        {
+            return false;
+        }
+        ReceivedKey.ReadBytes(PublicKey);
+
+        ServerKeyPair.GenerateRandomKeyPair(EDiffieHellmanPowerMode::ConstantTime);
+        Connection.ServerCipher = ITinyEncryptCipher::Create(Cipher, ServerKeyPair.GenerateSecretKey(ReceivedKey, EDiffieHellmanPowerMode::ConstantTime));
+
+        ServerKeyPair.PublicKey.WriteBytes(PublicKey);
+        if (!SendAll(Connection.Server, PublicKey, FUInt128Ex::ByteSize) || !RecvAll(Connection.Client, PublicKey, FUInt128Ex::ByteSize))
+        {
+            return false;
+        }
+        ReceivedKey.ReadBytes(PublicKey);
+        Connection.ClientCipher = ITinyEncryptCipher::Create(Cipher, ClientKeyPair.GenerateSecretKey(ReceivedKey, EDiffieHellmanPowerMode::ConstantTime));
+        return true;
+    }
+
+    //Client encrypts and sends one message
+    static bool SendMessage(FConnection& Connection, const FSettings& Settings, double Deadline, TArray<uint8>& PlainBuffer, TArray<uint8>& WireBuffer, FWorkerStats& Stats)
+    {
+        const uint64 SendCycles = FPlatformTime::Cycles64();
+        FMemory::Memcpy(PlainBuffer.GetData(), &SendCycles, sizeof(SendCycles));
+
+        const int32 EncryptLen = Connection.ClientCipher->Encrypt(PlainBuffer.GetData(), Settings.MessageSize, WireBuffer.GetData() + 4);
+        FMemory::Memcpy(WireBuffer.GetData(), &EncryptLen, 4);
+        if (!SendAllUntil(Connection.Client, WireBuffer.GetData(), 4 + EncryptLen, Deadline))
+        {
+            return false;
+        }
+        Stats.EncryptedBytes += EncryptLen;
+        return true;
+    }
+
+    //Server receives and decrypts one message, bOutEnd is set by the end frame
+    static bool ReceiveMessage(FConnection& Connection, const FSettings& Settings, TArray<uint8>& WireBuffer, FWorkerStats& Stats, bool& bOutEnd)
+    {
+        int32 ReceivedLen = 0;
+        if (!RecvAll(Connection.Server, (uint8*)&ReceivedLen, 4))
+        {
+            return false;
+        }
+        if (ReceivedLen == EndFrameLength)
+        {
+            bOutEnd = true;
+            return true;
+        }
+
+        //The rest of the frame is being sent by the client thread, blocking here can't deadlock
+        if (ReceivedLen < 0 || ReceivedLen > WireBuffer.Num() - 4 || !RecvAll(Connection.Server, WireBuffer.GetData() + 4, ReceivedLen))
+        {
+            return false;
+        }
+        if (Connection.ServerCipher->Decrypt(WireBuffer.GetData() + 4, ReceivedLen, WireBuffer.GetData() + 4) != Settings.MessageSize)
+        {
+            return false;
+        }
+
+        uint64 SendCycles = 0;
+        FMemory::Memcpy(&SendCycles, WireBuffer.GetData() + 4, sizeof(SendCycles));
+        Stats.LatenciesUs.Add((float)(FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - SendCycles) * 1000.0));
+        Stats.Messages++;
+        return true;
+    }
+
+    //Send messages on the connections of the thread at the rate until EndTime, then the end frames
+    static void RunClient(TArray<FConnection>& Connections, int32 ThreadIndex, int32 NumThreads, const FSettings& Settings, double EndTime, FWorkerStats& Stats)
+    {
+        //A send which waits for a stopped server thread gives up at the deadline
+        const double Deadline = EndTime + DrainSeconds;
+        for (int32 i = ThreadIndex; i < Connections.Num(); i += NumThreads)
+        {
+            Connections[i].Client->SetNonBlocking(true);
+        }
+
+        TArray<uint8> PlainBuffer, WireBuffer;
+        PlainBuffer.SetNumZeroed(Settings.MessageSize);
+        WireBuffer.SetNumUninitialized(4 + Settings.MessageSize + 16);
+
+        const double Interval = (Settings.Rate > 0) ? 1.0 / Settings.Rate : 0.0;
+        double Now = FPlatformTime::Seconds();
+        while (Now < EndTime && !Stats.bError)
+        {
+            bool bSent = false;
+            for (int32 i = ThreadIndex; i < Connections.Num(); i += NumThreads)
+            {
+                FConnection& Connection = Connections[i];
+                if (Now >= Connection.NextSendTime)
+                {
+                    //Keep the schedule of the rate, the sends missed by a slow thread are dropped, not bursted
+                    Connection.NextSendTime = FMath::Max(Connection.NextSendTime + Interval, Now);
+                    if (!SendMessage(Connection, Settings, Deadline, PlainBuffer, WireBuffer, Stats))
+                    {
+                        Stats.bError = true;
+                        break;
+                    }
+                    bSent = true;
+                }
+            }
+            if (!bSent)
+            {
+                FPlatformProcess::Sleep(0.0001f);
+            }
+            Now = FPlatformTime::Seconds();
+        }
+
+        for (int32 i = ThreadIndex; i < Connections.Num(); i += NumThreads)
+        {
+            const int32 EndFrame = EndFrameLength;
+            Stats.bError = Stats.bError || !SendAllUntil(Connections[i].Client, (const uint8*)&EndFrame, 4, Deadline);
+        }
+
+        //The server threads read EOF instead of waiting for the rest of a frame
+        if (Stats.bError)
+        {
+            for (int32 i = ThreadIndex; i < Connections.Num(); i += NumThreads)
+            {
+                Connections[i].Client->Shutdown(ESocketShutdownMode::Write);
+            }
+        }
+    }
+
+    //Receive the messages of the connections of the thread which are readable, until every end frame arrives
+    static void RunServer(TArray<FConnection>& Connections, int32 ThreadIndex, int32 NumThreads, const FSettings& Settings, double EndTime, FWorkerStats& Stats)
+    {
+        TArray<uint8> WireBuffer;
+        WireBuffer.SetNumUninitialized(4 + Settings.MessageSize + 16);
+
+        int32 OpenConnections = 0;
+        for (int32 i = ThreadIndex; i < Connections.Num(); i += NumThreads)
+        {
+            OpenConnections++;
+        }
+
+        while (OpenConnections > 0 && !Stats.bError)
+        {
+            bool bReceived = false;
+            for (int32 i = ThreadIndex; i < Connections.Num() && !Stats.bError; i += NumThreads)
+            {
+                FConnection& Connection = Connections[i];
+                //Readable on data and on EOF, so a failed client is noticed at once
+                if (Connection.bEnded || !Connection.Server->Wait(ESocketWaitConditions::WaitForRead, FTimespan::Zero()))
+                {
+                    continue;
+                }
+
+                bool bEnd = false;
+                Stats.bError = !ReceiveMessage(Connection, Settings, WireBuffer, Stats, bEnd);
+                if (bEnd)
+                {
+                    Connection.bEnded = true;
+                    OpenConnections--;
+                }
+                bReceived = true;
+            }
+            if (!bReceived)
+            {
+                if (FPlatformTime::Seconds() > EndTime + DrainSeconds)
+                {
+                    Stats.bError = true;
+                    break;
+                }
+                FPlatformProcess::Sleep(0.0001f);
+            }
+        }
+    }
+
+    static void CloseConnections(ISocketSubsystem* SocketSubsystem, TArray<FConnection>& Connections)
+    {
+        for (FConnection& Connection : Connections)
+        {
+            if (Connection.Client != nullptr)
+            {
+                SocketSubsystem->DestroySocket(Connection.Client);
+            }
+            if (Connection.Server != nullptr)
+            {
+                SocketSubsystem->DestroySocket(Connection.Server);
+            }
+        }
+        Connections.Reset();
+    }
+
+    static bool Connect(ISocketSubsystem* SocketSubsystem, int32 NumClients, TArray<FConnection>& Connections)
+    {
+        FSocket* Listener = SocketSubsystem->CreateSocket(NAME_Stream, TEXT("TinyEncryptLoadTestListener"), false);
+        TSharedRef<FInternetAddr> Address = SocketSubsystem->CreateInternetAddr();
+        Address->SetLoopbackAddress();
+        Address->SetPort(0);
+
+        bool bSuccess = Listener != nullptr && Listener->Bind(*Address) && Listener->Listen(NumClients);
+        if (bSuccess)
+        {
+            //The port is chosen by the system
+            Listener->GetAddress(*Address);
+            Address->SetLoopbackAddress();
+        }
+
+        for (int32 i = 0; i < NumClients && bSuccess; i++)
+        {
+            FConnection& Connection = Connections.AddDefaulted_GetRef();
+            Connection.Client = SocketSubsystem->CreateSocket(NAME_Stream, TEXT("TinyEncryptLoadTestClient"), false);
+            bSuccess = Connection.Client != nullptr && Connection.Client->Connect(*Address);
+            if (bSuccess)
+            {
+                Connection.Server = Listener->Accept(TEXT("TinyEncryptLoadTestServer"));
+                bSuccess = Connection.Server != nullptr;
+            }
+            if (bSuccess)
+            {
+                Connection.Client->SetNoDelay(true);
+                Connection.Server->SetNoDelay(true);
+            }
+        }
+
+        if (Listener != nullptr)
+        {
+            SocketSubsystem->DestroySocket(Listener);
+        }
+        return bSuccess;
+    }
+
+    //Run Function(ThreadIndex) on NumThreads threads, wait for all of them
+    static void RunOnThreads(int32 NumThreads, TFunction<void(int32)> Function)
+    {
+        TArray<TUniquePtr<FThread>> Threads;
+        for (int32 ThreadIndex = 0; ThreadIndex < NumThreads; ThreadIndex++)
+        {
+            Threads.Add(MakeUnique<FThread>(TEXT("TinyEncryptLoadTest"), [&Function, ThreadIndex]() { Function(ThreadIndex); }));
+        }
+        for (TUniquePtr<FThread>& Thread : Threads)
+        {
+            Thread->Join();
+        }
+    }
+
+    static bool RunScenario(ISocketSubsystem* SocketSubsystem, const FSettings& Settings, int32 NumClients, int32 NumThreads, FResult& OutResult)
+    {
+        TArray<FConnection> Connections;
+        if (!Connect(SocketSubsystem, NumClients, Connections))
+        {
+            UE_LOG(LogTinyEncryptLoadTest, Error, TEXT("Can't open %d loopback connections"), NumClients);
+            CloseConnections(SocketSubsystem, Connections);
+            return false;
+        }
+
+        //Connection i is driven by thread i % NumThreads
+        NumThreads = FMath::Clamp(NumThreads, 1, NumClients);
+        TArray<FWorkerStats> Stats;
+        Stats.SetNum(NumThreads);
+
+        const double HandshakeStart = FPlatformTime::Seconds();
+        RunOnThreads(NumThreads, [&](int32 ThreadIndex)
+        {
+            for (int32 i = ThreadIndex; i < Connections.Num() && !Stats[ThreadIndex].bError; i += NumThreads)
+            {
+                Stats[ThreadIndex].bError = !Handshake(Connections[i], Settings.Cipher);
+            }
+        });
+        const double HandshakeSeconds = FMath::Max(FPlatformTime::Seconds() - HandshakeStart, 0.000001);
+
+        //The client ends and the server ends are driven by their own threads, so the clients keep sending while the
+        //servers decrypt, and a full socket buffer only blocks the sender until its server thread catches up
+        TArray<FWorkerStats> ServerStats;
+        ServerStats.SetNum(NumThreads);
+
+        const double TrafficStart = FPlatformTime::Seconds();
+        const double EndTime = TrafficStart + Settings.Seconds;
+        bool bHandshakeError = false;
+        for (const FWorkerStats& WorkerStats : Stats)
+        {
+            bHandshakeError |= WorkerStats.bError;
+        }
+        if (!bHandshakeError)
+        {
+            RunOnThreads(NumThreads * 2, [&](int32 Index)
+            {
+                if (Index < NumThreads)
+                {
+                    RunClient(Connections, Index, NumThreads, Settings, EndTime, Stats[Index]);
+                }
+                else
+                {
+                    RunServer(Connections, Index - NumThreads, NumThreads, Settings, EndTime, ServerStats[Index - NumThreads]);
+                }
+            });
+        }
+        const double TrafficSeconds = FMath::Max(FPlatformTime::Seconds() - TrafficStart, 0.000001);
+        CloseConnections(SocketSubsystem, Connections);
+        Stats.Append(ServerStats);
+
+        TArray<float> Latencies;
+        int64 Messages = 0;
+        int64 EncryptedBytes = 0;
+        for (const FWorkerStats& WorkerStats : Stats)
+        {
+            if (WorkerStats.bError)
+            {
+                UE_LOG(LogTinyEncryptLoadTest, Error, TEXT("Handshake or message failed on a loopback connection"));
+                return false;
+            }
+            Latencies.Append(WorkerStats.LatenciesUs);
+            Messages += WorkerStats.Messages;
+            EncryptedBytes += WorkerStats.EncryptedBytes;
+        }
+        Latencies.Sort();
+
+        OutResult.HandshakesPerSecond = NumClients / HandshakeSeconds;
+        OutResult.MessagesPerSecond = Messages / TrafficSeconds;
+        OutResult.EncryptedMBPerSecond = EncryptedBytes / (1024.0 * 1024.0) / TrafficSeconds;
+        for (int32 i = 0; i < UE_ARRAY_COUNT(Percentiles); i++)
+        {
+            const int32 Index = FMath::Min((int32)(Percentiles[i] * Latencies.Num()), Latencies.Num() - 1);
+            OutResult.LatencyUs[i] = Latencies.Num() > 0 ? Latencies[Index] : 0.f;
+        }
+        return true;
+    }
+
+    //"1,16,64" -> { 1, 16, 64 }
+    static TArray<int32> ParseList(const FString& Params, const TCHAR* Name, int32 DefaultValue)
+    {
+        TArray<int32> Values;
+        FString ListString;
+        if (FParse::Value(*Params, Name, ListString, false))
+        {
+            TArray<FString> Items;
+            ListString.ParseIntoArray(Items, TEXT(","));
+            for (const FString& Item : Items)
+            {
+                const int32 Value = FCString::Atoi(*Item);
+                if (Value > 0)
+                {
+                    Values.Add(Value);
+                }
+            }
+        }
+        if (Values.Num() == 0)
+        {
+            Values.Add(DefaultValue);
+        }
+        return Values;
+    }
+}
+
+UTinyEncryptLoadTestCommandlet::UTinyEncryptLoadTestCommandlet()
+{
+    IsClient = false;
+    IsServer = false;
+    IsEditor = false;
+    LogToConsole = true;
+}
+
+int32 UTinyEncryptLoadTestCommandlet::Main(const FString& Params)
+{
+    using namespace TinyEncryptLoadTest;
+
+    FSettings Settings;
+    FParse::Value(*Params, TEXT("size="), Settings.MessageSize);
+    FParse::Value(*Params, TEXT("rate="), Settings.Rate);
+    FParse::Value(*Params, TEXT("seconds="), Settings.Seconds);
+    Settings.MessageSize = FMath::Clamp(Settings.MessageSize, (int32)sizeof(uint64), 1024 * 1024);
+    Settings.Rate = FMath::Max(Settings.Rate, 0);
+    Settings.Seconds = FMath::Max(Settings.Seconds, 0.1);
+
+    FString CipherName;
+    if (FParse::Value(*Params, TEXT("cipher="), CipherName) && CipherName.Equals(TEXT("AES"), ESearchCase::IgnoreCase))
+    {
+        Settings.Cipher = ETinyEncryptCipher::AES128;
+    }
+
+    const TArray<int32> ClientCounts = ParseList(Params, TEXT("clients="), 16);
+    const TArray<int32> ThreadCounts = ParseList(Params, TEXT("threads="), 4);
+
+    ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+    if (SocketSubsystem == nullptr)
+    {
+        UE_LOG(LogTinyEncryptLoadTest, Error, TEXT("No socket subsystem"));
+        return 1;
+    }
+
+    UE_LOG(LogTinyEncryptLoadTest, Display, TEXT("Cipher=%s%s Size=%d Rate=%d/s per client Seconds=%.1f"),
+        Settings.Cipher == ETinyEncryptCipher::AES128 ? TEXT("AES128") : TEXT("TEA"),
+        (Settings.Cipher == ETinyEncryptCipher::AES128 && ITinyEncryptCipher::IsHardwareAESSupported()) ? TEXT("(hardware)") : TEXT(""),
+        Settings.MessageSize, Settings.Rate, Settings.Seconds);
+    UE_LOG(LogTinyEncryptLoadTest, Display, TEXT("Clients Threads Handshakes/s      Msgs/s      MB/s   p50(us)   p90(us)   p99(us) p99.9(us)   max(us)"));
+
+    for (int32 NumClients : ClientCounts)
+    {
+        for (int32 NumThreads : ThreadCounts)
+        {
+            FResult Result;
+            if (!RunScenario(SocketSubsystem, Settings, NumClients, NumThreads, Result))
+            {
+                return 1;
+            }
+
+            UE_LOG(LogTinyEncryptLoadTest, Display, TEXT("%7d %7d %12.1f %11.0f %9.2f %9.1f %9.1f %9.1f %9.1f %9.1f"),
+                NumClients, NumThreads, Result.HandshakesPerSecond, Result.MessagesPerSecond, Result.EncryptedMBPerSecond,
+                Result.LatencyUs[0], Result.LatencyUs[1], Result.LatencyUs[2], Result.LatencyUs[3], Result.LatencyUs[4]);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "TinyEncryptLoadTestCommandlet.generated.h"
+
+/*
+Headless load generator over loopback sockets, to measure how the plugin scales on one machine.
+
+    UnrealEditor-Cmd TinyEncryptDemo.uproject -run=TinyEncryptLoadTest -nullrhi
+        [-clients=1,16,64] [-threads=1,4] [-size=256] [-rate=1000] [-seconds=5] [-cipher=TEA|AES]
+
+Every combination of clients and threads is one run: the clients connect to a loopback listener, do the DH
+handshake with `FDiffieHellmanKeyPair`, then send length-prefixed encrypted messages of `size` bytes at `rate`
+messages/s per client(0 = as fast as possible) for `seconds`. `threads` client threads send on their connections
+while as many server threads receive and decrypt the other ends concurrently. Each run reports handshakes/s,
+encrypted MB/s and the message latency percentiles(encrypt + send + queueing + receive + decrypt).
+*/
+UCLASS()
+class UTinyEncryptLoadTestCommandlet : public UCommandlet
+{
+    GENERATED_BODY()
+
+public:
+    UTinyEncryptLoadTestCommandlet();
+
+    // UCommandlet interface
+    virtual int32 Main(const FString& Params) override;
+};